@@ -5,6 +5,7 @@
 #   ./exec.sh              # 対話シェルに入る
 #   ./exec.sh linux        # Linux ブートデモ (telnet localhost 4321)
 #   ./exec.sh imgproc IMG  # 画像処理デモ
+#   ./exec.sh imgproc-batch DIR|VIDEO  # 連続処理 (output_frames/)
 set -e
 
 SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
@@ -83,8 +84,21 @@ case "${1:-shell}" in
         fi
         ;;
 
+    imgproc-batch)
+        INPUT="${2:-}"
+        if [ -z "$INPUT" ] || [ ! -e "$INPUT" ]; then
+            echo "Usage: $0 imgproc-batch <directory|video>"
+            exit 1
+        fi
+        load_image
+        echo "=== Image Processing Batch ($(basename "$INPUT")) ==="
+        $DOCKER_RUN -it \
+            -v "$(realpath "$INPUT"):/work/input_batch" \
+            "$IMAGE_REF" make demo-imgproc-batch INPUT=/work/input_batch
+        ;;
+
     *)
-        echo "Usage: $0 [shell|linux|linux-headless|imgproc <image>]"
+        echo "Usage: $0 [shell|linux|linux-headless|imgproc <image>|imgproc-batch <dir|video>]"
         exit 1
         ;;
 esac
@@ -0,0 +1,300 @@
+/*
+ * draw_bench.cpp — Memory-traffic benchmark for the Draw Engine TLM
+ *
+ * Drives draw_tlm::Engine through its legacy register window on host
+ * RAM and reports, per operation and rectangle shape, how many AXI
+ * beats and bursts the engine needs per pixel.  The model is not
+ * cycle-accurate, so this measures the memory side only: a change that
+ * splits rows into more bursts, reads the destination when it does not
+ * have to, or re-reads the texture shows up here as a drop in px/beat.
+ * "sprite" blends a texture with transparent margins, which should
+ * only read back the destination under the visible middle.  "clut8"
+ * copies from an 8-bit indexed texture and "zoom" blows a half-size
+ * RGB888 texture up 2x with the bilinear filter: both should read a
+ * fraction of a beat per pixel from the source.
+ *
+ * Bursts are framed the way sim_main_tlm.cpp issues them (INCR, at
+ * most 256 beats, never across a 4 KiB boundary).  The host wall-clock
+ * rate is reported too but only meaningful on one machine.
+ *
+ * px_per_clk / px_per_clk_4p are the model's PERF_CYCLES estimate with
+ * one and with BENCH_PIPES band-split pipelines on the shared master:
+ * they separate latency-bound cases (narrow rectangles, short rows),
+ * which more pipelines speed up, from bandwidth-bound ones, which they
+ * cannot.
+ *
+ *   draw_bench [report.json]      (default: stdout)
+ *
+ * Built and compared against results/bench_baseline.json by
+ * `make bench` / `make check-results`.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "draw_tlm.h"
+
+namespace {
+
+constexpr uint64_t RAM_BASE  = 0x40000000;
+constexpr uint64_t RAM_SIZE  = 64u << 20;
+constexpr uint32_t FRAME     = 0x41000000;
+constexpr uint32_t TEXTURE   = 0x42000000;
+constexpr uint32_t PALETTE   = 0x43000000;
+
+constexpr unsigned BENCH_PIPES = 4;
+
+constexpr uint64_t AXI_MAX_BEATS = 256;
+constexpr uint64_t AXI_BOUNDARY  = 4096;
+
+/* Legacy window offsets / opcodes, as in draw_dl.h */
+constexpr uint32_t REG_CTRL = draw_tlm::DRAW_BASE + 0x00;
+constexpr uint32_t REG_STAT = draw_tlm::DRAW_BASE + 0x04;
+constexpr uint32_t REG_CMD  = draw_tlm::DRAW_BASE + 0x0C;
+constexpr uint32_t REG_PERF_CYCLES = draw_tlm::DRAW_BASE + 0x104 + 4 * draw_tlm::PERF_CYCLES;
+
+enum {
+    OP_EODL = 0x0F, OP_SETFRAME = 0x20, OP_SETDRAWAREA = 0x21,
+    OP_SETTEXTURE = 0x22, OP_SETFCOLOR = 0x23, OP_SETSTCOLOR = 0x24,
+    OP_SETPALETTE = 0x25, OP_SETSCALE = 0x26,
+    OP_SETSTMODE = 0x30, OP_SETBLENDALPHA = 0x31, OP_SETBLENDOFF = 0x32,
+    OP_PATBLT = 0x81, OP_BITBLT = 0x82, OP_SCALEBLT = 0x87,
+};
+
+uint32_t cmd(uint32_t op, uint32_t arg = 0) { return op << 24 | (arg & 0xFFFFFF); }
+uint32_t xy(int x, int y) { return (uint32_t)(x & 0xFFFF) << 16 | (uint32_t)(y & 0xFFFF); }
+
+class Ram : public draw_tlm::Bus {
+public:
+    uint64_t rd_beats = 0, wr_beats = 0, rd_bursts = 0, wr_bursts = 0;
+
+    Ram() : mem_(RAM_SIZE / 4) {}
+
+    uint32_t read32(uint64_t addr) override
+    {
+        rd_beats++;
+        rd_bursts++;
+        return mem_[index(addr)];
+    }
+    void write32(uint64_t addr, uint32_t value) override
+    {
+        wr_beats++;
+        wr_bursts++;
+        mem_[index(addr)] = value;
+    }
+    void read(uint64_t addr, uint32_t *dst, size_t words) override
+    {
+        rd_beats += words;
+        rd_bursts += bursts(addr, words);
+        std::memcpy(dst, &mem_[index(addr)], words * 4);
+    }
+    void write(uint64_t addr, const uint32_t *src, size_t words) override
+    {
+        wr_beats += words;
+        wr_bursts += bursts(addr, words);
+        std::memcpy(&mem_[index(addr)], src, words * 4);
+    }
+
+    uint32_t *at(uint64_t addr) { return &mem_[index(addr)]; }
+    void clear_stats() { rd_beats = wr_beats = rd_bursts = wr_bursts = 0; }
+
+private:
+    static size_t index(uint64_t addr) { return (size_t)((addr - RAM_BASE) / 4); }
+
+    static uint64_t bursts(uint64_t addr, size_t words)
+    {
+        uint64_t n = 0;
+        while (words) {
+            uint64_t to_boundary = (AXI_BOUNDARY - (addr & (AXI_BOUNDARY - 1))) / 4;
+            uint64_t beats = std::min<uint64_t>({ words, AXI_MAX_BEATS, to_boundary });
+            addr += 4 * beats;
+            words -= beats;
+            n++;
+        }
+        return n;
+    }
+
+    std::vector<uint32_t> mem_;
+};
+
+struct Resolution {
+    const char *name;
+    int w, h;
+};
+
+/* Display modes the engine supports */
+const Resolution resolutions[] = {
+    { "vga",  640,  480  },
+    { "xga",  1024, 768  },
+    { "sxga", 1280, 1024 },
+};
+
+struct Shape {
+    const char *name;
+    int x, y, w, h;     /* w/h <= 0: frame size minus |w|/|h| */
+};
+
+const Shape shapes[] = {
+    { "full",      0,  0,  0,   0   },
+    { "box64",     64, 64, 64,  64  },
+    { "column1",   17, 0,  1,   0   },
+    { "row1",      0,  33, 0,   1   },
+    { "narrow4",   5,  3,  4,   -6  },
+    { "unaligned", 3,  5,  -13, -11 },
+};
+
+enum Op { OP_FILL, OP_COPY, OP_BLEND, OP_STENCIL, OP_SPRITE, OP_CLUT8, OP_ZOOM };
+
+const char *const op_names[] = {
+    "fill", "bitblt", "blend", "stencil", "sprite", "clut8", "zoom",
+};
+
+struct Result {
+    uint64_t pixels;
+    uint64_t rd_beats, wr_beats, rd_bursts, wr_bursts;
+    double   us;
+    uint64_t cycles;
+};
+
+class Bench {
+public:
+    Bench() : engine_(ram_) {}
+
+    Result run(Op op, const Resolution &r, const Shape &s, unsigned pipes = 1);
+
+private:
+    void submit(const std::vector<uint32_t> &dl);
+
+    Ram              ram_;
+    draw_tlm::Engine engine_;
+};
+
+void Bench::submit(const std::vector<uint32_t> &dl)
+{
+    for (uint32_t w : dl)
+        engine_.mmio_write(REG_CMD, w);
+    engine_.mmio_write(REG_CTRL, 1);
+    while (engine_.mmio_read(REG_STAT) & 1)
+        engine_.tick(1);
+}
+
+Result Bench::run(Op op, const Resolution &r, const Shape &s, unsigned pipes)
+{
+    int w = s.w > 0 ? s.w : r.w + s.w - s.x;
+    int h = s.h > 0 ? s.h : r.h + s.h - s.y;
+
+    /*
+     * Texture: opaque/translucent stripes with every 4th texel keyed;
+     * for sprites, a translucent middle half between alpha-0 margins.
+     * Packed formats get a byte ramp (rows are multiples of 4 bytes).
+     */
+    uint32_t *tex = ram_.at(TEXTURE);
+    uint8_t *bytes = reinterpret_cast<uint8_t *>(tex);
+    for (int i = 0; i < r.w * r.h; i++) {
+        int x = i % r.w;
+        if (op == OP_CLUT8)
+            bytes[i] = (uint8_t)i;
+        else if (op == OP_ZOOM)
+            bytes[i] = (uint8_t)(i / 3 + i % 3 * 85);
+        else if (op == OP_SPRITE)
+            tex[i] = x >= r.w / 4 && x < r.w * 3 / 4 ? 0xC02080C0 : 0x00000000;
+        else
+            tex[i] = (i & 3) == 3 ? 0xFF00FF00 : (i & 4) ? 0x80C04020 : 0xFF2080C0;
+    }
+    uint32_t *pal = ram_.at(PALETTE);
+    for (int i = 0; i < 256; i++)
+        pal[i] = 0xFF000000 | (uint32_t)i * 0x010305;
+
+    std::vector<uint32_t> dl = {
+        cmd(OP_SETFRAME), FRAME, xy(r.w, r.h),
+        cmd(OP_SETDRAWAREA), xy(0, 0), xy(r.w, r.h),
+    };
+    if (op == OP_CLUT8)
+        dl.insert(dl.end(), { cmd(OP_SETPALETTE, 256), PALETTE,
+                              cmd(OP_SETTEXTURE, 2), TEXTURE, xy(r.w, r.h) });
+    else if (op == OP_ZOOM)
+        dl.insert(dl.end(), { cmd(OP_SETTEXTURE, 1), TEXTURE, xy(r.w / 2, r.h / 2),
+                              cmd(OP_SETSCALE, 1), 0x8000, 0x8000 });
+    else
+        dl.insert(dl.end(), { cmd(OP_SETTEXTURE), TEXTURE, xy(r.w, r.h) });
+    dl.insert(dl.end(), {
+        cmd(OP_SETFCOLOR), 0x803060A0,
+        cmd(OP_SETSTCOLOR), 0xFF00FF00,
+        cmd(OP_SETSTMODE, op == OP_STENCIL),
+    });
+    if (op == OP_BLEND || op == OP_SPRITE)
+        dl.push_back(cmd(OP_SETBLENDALPHA, 0xFF));
+    else
+        dl.push_back(cmd(OP_SETBLENDOFF));
+    if (op == OP_FILL)
+        dl.insert(dl.end(), { cmd(OP_PATBLT), xy(s.x, s.y), xy(w, h) });
+    else if (op == OP_ZOOM)
+        dl.insert(dl.end(), { cmd(OP_SCALEBLT), xy(s.x, s.y), xy(w, h), xy(0, 0) });
+    else
+        dl.insert(dl.end(), { cmd(OP_BITBLT), xy(s.x, s.y), xy(w, h), xy(0, 0) });
+    dl.push_back(cmd(OP_EODL));
+
+    engine_.set_pipes(pipes);
+    engine_.reset();
+    ram_.clear_stats();
+
+    auto t0 = std::chrono::steady_clock::now();
+    submit(dl);
+    auto t1 = std::chrono::steady_clock::now();
+
+    return { (uint64_t)w * h, ram_.rd_beats, ram_.wr_beats,
+             ram_.rd_bursts, ram_.wr_bursts,
+             std::chrono::duration<double, std::micro>(t1 - t0).count(),
+             engine_.mmio_read(REG_PERF_CYCLES) };
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    FILE *out = argc > 1 ? fopen(argv[1], "w") : stdout;
+    if (!out) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    Bench bench;
+    int n = 0;
+
+    fprintf(out, "{\"model\": \"draw_tlm\", \"results\": [");
+    for (unsigned o = 0; o < sizeof(op_names) / sizeof(op_names[0]); o++) {
+        for (const Resolution &r : resolutions) {
+            for (const Shape &s : shapes) {
+                Result res = bench.run((Op)o, r, s);
+                uint64_t cycles_np = bench.run((Op)o, r, s, BENCH_PIPES).cycles;
+                uint64_t beats = res.rd_beats + res.wr_beats;
+                uint64_t bursts = res.rd_bursts + res.wr_bursts;
+                fprintf(out, "%s\n  {\"op\": \"%s\", \"res\": \"%s\", \"shape\": \"%s\", "
+                        "\"pixels\": %llu, \"rd_beats\": %llu, \"wr_beats\": %llu, "
+                        "\"rd_bursts\": %llu, \"wr_bursts\": %llu, "
+                        "\"px_per_beat\": %.4f, \"beats_per_burst\": %.2f, "
+                        "\"px_per_clk\": %.4f, \"px_per_clk_%up\": %.4f, "
+                        "\"host_mpix_per_s\": %.1f}",
+                        n++ ? "," : "", op_names[o], r.name, s.name,
+                        (unsigned long long)res.pixels,
+                        (unsigned long long)res.rd_beats,
+                        (unsigned long long)res.wr_beats,
+                        (unsigned long long)res.rd_bursts,
+                        (unsigned long long)res.wr_bursts,
+                        beats ? (double)res.pixels / beats : 0.0,
+                        bursts ? (double)beats / bursts : 0.0,
+                        res.cycles ? (double)res.pixels / res.cycles : 0.0,
+                        BENCH_PIPES,
+                        cycles_np ? (double)res.pixels / cycles_np : 0.0,
+                        res.us > 0 ? res.pixels / res.us : 0.0);
+            }
+        }
+    }
+    fprintf(out, "\n]}\n");
+
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
@@ -0,0 +1,2134 @@
+/*
+ * draw_tlm.cpp — Transaction-level model of the VirtIO-GPU Draw Engine
+ *
+ * See draw_tlm.h.  Structures follow the VirtIO 1.1 spec (MMIO v2,
+ * split virtqueues, GPU device 2D commands); all guest data is
+ * little-endian, as is every host this is built on.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "draw_tlm.h"
+
+namespace draw_tlm {
+
+/* ── VirtIO MMIO register offsets ─────────────────────────── */
+enum {
+    VIRTIO_MAGIC            = 0x000,
+    VIRTIO_VERSION          = 0x004,
+    VIRTIO_DEVICE_ID        = 0x008,
+    VIRTIO_VENDOR_ID        = 0x00C,
+    VIRTIO_DEV_FEATURES     = 0x010,
+    VIRTIO_DEV_FEATURES_SEL = 0x014,
+    VIRTIO_DRV_FEATURES     = 0x020,
+    VIRTIO_DRV_FEATURES_SEL = 0x024,
+    VIRTIO_QUEUE_SEL        = 0x030,
+    VIRTIO_QUEUE_NUM_MAX    = 0x034,
+    VIRTIO_QUEUE_NUM        = 0x038,
+    VIRTIO_QUEUE_READY      = 0x044,
+    VIRTIO_QUEUE_NOTIFY     = 0x050,
+    VIRTIO_INT_STATUS       = 0x060,
+    VIRTIO_INT_ACK          = 0x064,
+    VIRTIO_STATUS           = 0x070,
+    VIRTIO_QUEUE_DESC_LO    = 0x080,
+    VIRTIO_QUEUE_DESC_HI    = 0x084,
+    VIRTIO_QUEUE_AVAIL_LO   = 0x090,
+    VIRTIO_QUEUE_AVAIL_HI   = 0x094,
+    VIRTIO_QUEUE_USED_LO    = 0x0A0,
+    VIRTIO_QUEUE_USED_HI    = 0x0A4,
+    VIRTIO_CONFIG_GEN       = 0x0FC,
+    VIRTIO_CONFIG           = 0x100,
+};
+
+constexpr uint32_t VIRTIO_MAGIC_VALUE   = 0x74726976;   /* "virt" */
+constexpr uint32_t VIRTIO_ID_GPU        = 16;
+constexpr uint64_t VIRTIO_F_VERSION_1   = 1ull << 32;
+constexpr uint64_t VIRTIO_RING_F_EVENT_IDX = 1ull << 29;
+constexpr uint64_t VIRTIO_GPU_F_RESOURCE_BLOB = 1ull << 3;
+constexpr uint64_t VIRTIO_DEV_FEATURE_BITS =
+    VIRTIO_F_VERSION_1 | VIRTIO_RING_F_EVENT_IDX | VIRTIO_GPU_F_RESOURCE_BLOB;
+constexpr uint32_t VIRTIO_STATUS_DRIVER_OK = 4;
+
+constexpr uint16_t VIRTQ_DESC_F_NEXT  = 1;
+constexpr uint16_t VIRTQ_DESC_F_WRITE = 2;
+constexpr uint16_t VIRTQ_AVAIL_F_NO_INTERRUPT = 1;
+constexpr size_t   VIRTQ_REQ_MAX      = 64 * 1024;
+
+/* ── Draw Engine registers / opcodes (mirrors draw_dl.h) ──── */
+enum {
+    DRAW_REG_CTRL    = 0x00,
+    DRAW_REG_STAT    = 0x04,
+    DRAW_REG_BUFSTAT = 0x08,
+    DRAW_REG_CMD     = 0x0C,
+    DRAW_REG_INT     = 0x10,
+    DRAW_REG_CAPS    = 0x14,
+    DRAW_REG_PIPES   = 0x18,
+    DRAW_REG_RINGBASE = 0x20,
+    DRAW_REG_RINGSIZE = 0x24,
+    DRAW_REG_RINGHEAD = 0x28,
+    DRAW_REG_RINGTAIL = 0x2C,
+    DRAW_REG_RINGDONE = 0x30,
+};
+
+constexpr uint32_t DRAW_CTRL_EXE  = 1u << 0;
+constexpr uint32_t DRAW_CTRL_RST  = 1u << 1;
+constexpr uint32_t DRAW_STAT_BUSY = 1u << 0;
+constexpr uint32_t DRAW_BUF_EMPTY = 1u << 16;
+constexpr uint32_t DRAW_BUF_FULL  = 1u << 17;
+constexpr uint32_t DRAW_INT_ENBL  = 1u << 0;
+constexpr uint32_t DRAW_INT_CLR   = 1u << 1;
+
+enum {
+    DRAW_OP_NOP           = 0x00,
+    DRAW_OP_EODL          = 0x0F,
+    DRAW_OP_JUMP          = 0x10,
+    DRAW_OP_CALL          = 0x11,
+    DRAW_OP_RET           = 0x12,
+    DRAW_OP_SETFRAME      = 0x20,
+    DRAW_OP_SETDRAWAREA   = 0x21,
+    DRAW_OP_SETTEXTURE    = 0x22,
+    DRAW_OP_SETFCOLOR     = 0x23,
+    DRAW_OP_SETSTCOLOR    = 0x24,
+    DRAW_OP_SETPALETTE    = 0x25,
+    DRAW_OP_SETSCALE      = 0x26,
+    DRAW_OP_SETSTMODE     = 0x30,
+    DRAW_OP_SETBLENDALPHA = 0x31,
+    DRAW_OP_SETBLENDOFF   = 0x32,
+    DRAW_OP_PATBLT        = 0x81,
+    DRAW_OP_BITBLT        = 0x82,
+    DRAW_OP_LINE          = 0x83,
+    DRAW_OP_TRIANGLE      = 0x84,
+    DRAW_OP_ELLIPSE       = 0x85,
+    DRAW_OP_GRADIENT      = 0x86,
+    DRAW_OP_SCALEBLT      = 0x87,
+};
+
+constexpr uint32_t DRAW_GRAD_VERTICAL = 1u << 0;
+constexpr uint32_t DRAW_SCALE_BILINEAR = 1u << 0;
+
+/* ── VirtIO-GPU protocol ──────────────────────────────────── */
+enum {
+    GPU_CMD_GET_DISPLAY_INFO        = 0x0100,
+    GPU_CMD_RESOURCE_CREATE_2D      = 0x0101,
+    GPU_CMD_RESOURCE_UNREF          = 0x0102,
+    GPU_CMD_SET_SCANOUT             = 0x0103,
+    GPU_CMD_RESOURCE_FLUSH          = 0x0104,
+    GPU_CMD_TRANSFER_TO_HOST_2D     = 0x0105,
+    GPU_CMD_RESOURCE_ATTACH_BACKING = 0x0106,
+    GPU_CMD_RESOURCE_DETACH_BACKING = 0x0107,
+    GPU_CMD_RESOURCE_CREATE_BLOB    = 0x010C,
+    GPU_CMD_SET_SCANOUT_BLOB        = 0x010D,
+    GPU_CMD_UPDATE_CURSOR           = 0x0300,
+    GPU_CMD_MOVE_CURSOR             = 0x0301,
+
+    GPU_RESP_OK_NODATA              = 0x1100,
+    GPU_RESP_OK_DISPLAY_INFO        = 0x1101,
+    GPU_RESP_ERR_UNSPEC             = 0x1200,
+    GPU_RESP_ERR_OUT_OF_MEMORY      = 0x1201,
+    GPU_RESP_ERR_INVALID_SCANOUT_ID = 0x1202,
+    GPU_RESP_ERR_INVALID_RESOURCE_ID = 0x1203,
+    GPU_RESP_ERR_INVALID_PARAMETER  = 0x1205,
+};
+
+constexpr uint32_t GPU_FLAG_FENCE   = 1;
+constexpr uint32_t GPU_BLOB_MEM_GUEST = 1;
+constexpr unsigned GPU_MAX_SCANOUTS = 16;
+constexpr size_t   GPU_RES_MAX_BYTES = 64u << 20;
+
+enum {
+    GPU_FORMAT_B8G8R8A8 = 1,
+    GPU_FORMAT_B8G8R8X8 = 2,
+    GPU_FORMAT_A8R8G8B8 = 3,
+    GPU_FORMAT_X8R8G8B8 = 4,
+    GPU_FORMAT_R8G8B8A8 = 67,
+    GPU_FORMAT_X8B8G8R8 = 68,
+    GPU_FORMAT_A8B8G8R8 = 121,
+    GPU_FORMAT_R8G8B8X8 = 134,
+};
+
+struct GpuHdr {
+    uint32_t type, flags;
+    uint64_t fence_id;
+    uint32_t ctx_id;
+    uint8_t  ring_idx, pad[3];
+};
+struct GpuRect {
+    uint32_t x, y, width, height;
+};
+struct GpuDisplayInfo {
+    GpuHdr hdr;
+    struct {
+        GpuRect  r;
+        uint32_t enabled, flags;
+    } pmodes[GPU_MAX_SCANOUTS];
+};
+struct GpuCreate2d {
+    GpuHdr   hdr;
+    uint32_t resource_id, format, width, height;
+};
+struct GpuResourceId {          /* UNREF, DETACH_BACKING */
+    GpuHdr   hdr;
+    uint32_t resource_id, pad;
+};
+struct GpuSetScanout {
+    GpuHdr   hdr;
+    GpuRect  r;
+    uint32_t scanout_id, resource_id;
+};
+struct GpuFlush {
+    GpuHdr   hdr;
+    GpuRect  r;
+    uint32_t resource_id, pad;
+};
+struct GpuTransfer2d {
+    GpuHdr   hdr;
+    GpuRect  r;
+    uint64_t offset;
+    uint32_t resource_id, pad;
+};
+struct GpuAttachBacking {
+    GpuHdr   hdr;
+    uint32_t resource_id, nr_entries;
+};
+struct GpuMemEntry {
+    uint64_t addr;
+    uint32_t length, pad;
+};
+struct GpuCreateBlob {
+    GpuHdr   hdr;
+    uint32_t resource_id, blob_mem, blob_flags, nr_entries;
+    uint64_t blob_id, size;
+};
+struct GpuSetScanoutBlob {
+    GpuHdr   hdr;
+    GpuRect  r;
+    uint32_t scanout_id, resource_id;
+    uint32_t width, height, format, pad;
+    uint32_t strides[4], offsets[4];
+};
+
+struct GpuUpdateCursor {        /* UPDATE_CURSOR, MOVE_CURSOR */
+    GpuHdr   hdr;
+    uint32_t scanout_id, x, y, pad0;
+    uint32_t resource_id, hot_x, hot_y, pad1;
+};
+
+static_assert(sizeof(GpuHdr) == 24, "virtio_gpu_ctrl_hdr");
+static_assert(sizeof(GpuDisplayInfo) == 408, "virtio_gpu_resp_display_info");
+static_assert(sizeof(GpuTransfer2d) == 56, "virtio_gpu_transfer_to_host_2d");
+static_assert(sizeof(GpuMemEntry) == 16, "virtio_gpu_mem_entry");
+static_assert(sizeof(GpuCreateBlob) == 56, "virtio_gpu_resource_create_blob");
+static_assert(sizeof(GpuSetScanoutBlob) == 96, "virtio_gpu_set_scanout_blob");
+static_assert(sizeof(GpuUpdateCursor) == 56, "virtio_gpu_update_cursor");
+
+/* Resource word (guest byte order) → scanout ARGB8888 */
+static uint32_t to_argb(uint32_t format, uint32_t v)
+{
+    switch (format) {
+    case GPU_FORMAT_B8G8R8A8:
+        return v;
+    case GPU_FORMAT_B8G8R8X8:
+        return v | 0xFF000000;
+    case GPU_FORMAT_A8R8G8B8:
+        return __builtin_bswap32(v);
+    case GPU_FORMAT_X8R8G8B8:
+        return __builtin_bswap32(v) | 0xFF000000;
+    case GPU_FORMAT_R8G8B8A8:
+        return (v & 0xFF00FF00) | ((v >> 16) & 0xFF) | ((v & 0xFF) << 16);
+    case GPU_FORMAT_R8G8B8X8:
+        return (v & 0x0000FF00) | ((v >> 16) & 0xFF) | ((v & 0xFF) << 16) | 0xFF000000;
+    case GPU_FORMAT_A8B8G8R8:
+    case GPU_FORMAT_X8B8G8R8:
+        v = __builtin_bswap32(v);
+        v = (v & 0xFF00FF00) | ((v >> 16) & 0xFF) | ((v & 0xFF) << 16);
+        return format == GPU_FORMAT_X8B8G8R8 ? v | 0xFF000000 : v;
+    }
+    return v;
+}
+
+static bool format_supported(uint32_t format)
+{
+    switch (format) {
+    case GPU_FORMAT_B8G8R8A8: case GPU_FORMAT_B8G8R8X8:
+    case GPU_FORMAT_A8R8G8B8: case GPU_FORMAT_X8R8G8B8:
+    case GPU_FORMAT_R8G8B8A8: case GPU_FORMAT_X8B8G8R8:
+    case GPU_FORMAT_A8B8G8R8: case GPU_FORMAT_R8G8B8X8:
+        return true;
+    }
+    return false;
+}
+
+/* Straight-alpha blend of RGB; the destination alpha is kept */
+static inline uint32_t blend_px(uint32_t s, uint32_t d, uint32_t a)
+{
+    uint32_t out = d & 0xFF000000;
+    for (int sh = 0; sh < 24; sh += 8) {
+        uint32_t x = ((s >> sh) & 0xFF) * a + ((d >> sh) & 0xFF) * (255 - a) + 128;
+        out |= ((x + (x >> 8)) >> 8) << sh;
+    }
+    return out;
+}
+
+static inline int pos16(uint32_t w) { return (int16_t)(w & 0xFFFF); }
+
+/* ── Bus defaults ─────────────────────────────────────────── */
+void Bus::read(uint64_t addr, uint32_t *dst, size_t words)
+{
+    for (size_t i = 0; i < words; i++)
+        dst[i] = read32(addr + 4 * i);
+}
+
+void Bus::write(uint64_t addr, const uint32_t *src, size_t words)
+{
+    for (size_t i = 0; i < words; i++)
+        write32(addr + 4 * i, src[i]);
+}
+
+/* ── Engine ───────────────────────────────────────────────── */
+Engine::Engine(Bus &mem) : mem_(&mem)
+{
+    reset();
+}
+
+void Engine::set_pipes(unsigned n)
+{
+    pipes_ = pipes_active_ = std::clamp(n, 1u, DRAW_PIPES_MAX);
+}
+
+void Engine::reset()
+{
+    virtio_reset();
+    draw_reset();
+    draw_int_enbl_ = false;
+    ring_base_ = ring_done_ = 0;
+    ring_size_ = 0;
+    std::fill(std::begin(perf_), std::end(perf_), 0);
+}
+
+uint32_t Engine::mmio_read(uint32_t off)
+{
+    off &= WINDOW_MASK;
+    if (off >= DRAW_BASE && off < DRAW_BASE + 0x1000)
+        return draw_read(off - DRAW_BASE);
+    if (off >= DBG_BASE && off < DBG_BASE + 0x1000) {
+        switch (off - DBG_BASE) {
+        case DBG_STATE:
+            return (busy_ ? 1u : 0u) | ((status_ & VIRTIO_STATUS_DRIVER_OK) ? 2u : 0u);
+        case DBG_LAST_CMD:
+            return last_cmd_;
+        case DBG_LAST_RESP:
+            return last_resp_;
+        case DBG_BACKING0: {
+            auto it = resources_.find(scanout_res_);
+            if (it == resources_.end() || it->second.backing.empty())
+                return 0;
+            return (uint32_t)it->second.backing[0].addr;
+        }
+        case DBG_CMD_CNT:
+            return cmd_cnt_;
+        case DBG_FB_ADDR:
+            if (!scanout_res_)
+                return 0;
+            return (uint32_t)(scanout_direct() ? scanout_base_ : SCANOUT_ADDR);
+        case DBG_WXH:
+            return (scanout_w_ << 16) | (scanout_h_ & 0xFFFF);
+        case DBG_SNAPSHOT:
+            return snapshot_failed_;
+        }
+        return 0;
+    }
+    if (off < DBG_BASE)
+        return virtio_read(off);
+    return 0;
+}
+
+void Engine::mmio_write(uint32_t off, uint32_t value)
+{
+    off &= WINDOW_MASK;
+    if (off >= DRAW_BASE && off < DRAW_BASE + 0x1000)
+        draw_write(off - DRAW_BASE, value);
+    else if (off == DBG_BASE + DBG_SNAPSHOT)
+        snapshot(value);
+    else if (off < DBG_BASE)
+        virtio_write(off, value);
+}
+
+void Engine::tick(uint64_t)
+{
+    for (unsigned qi = 0; qi < 2; qi++)
+        if (queue_[qi].notified)
+            virtq_process(qi);
+    if (busy_)
+        draw_run();
+}
+
+/* ── Snapshots ────────────────────────────────────────────── */
+constexpr uint32_t SNAPSHOT_MAGIC   = 0x544C4D44;   /* "DMLT" */
+constexpr uint32_t SNAPSHOT_VERSION = 8;
+
+template <typename T>
+static void put(std::ostream &out, const T &v)
+{
+    out.write(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+template <typename T>
+static void put_vec(std::ostream &out, const std::vector<T> &v)
+{
+    put(out, (uint64_t)v.size());
+    out.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+}
+
+template <typename T>
+static bool get(std::istream &in, T &v)
+{
+    return (bool)in.read(reinterpret_cast<char *>(&v), sizeof(v));
+}
+
+template <typename T>
+static bool get_vec(std::istream &in, std::vector<T> &v, uint64_t max)
+{
+    uint64_t n;
+    if (!get(in, n) || n > max)
+        return false;
+    v.resize(n);
+    return (bool)in.read(reinterpret_cast<char *>(v.data()), n * sizeof(T));
+}
+
+bool Engine::save(std::ostream &out) const
+{
+    put(out, SNAPSHOT_MAGIC);
+    put(out, SNAPSHOT_VERSION);
+
+    put(out, status_);
+    put(out, dev_features_sel_);
+    put(out, drv_features_sel_);
+    put(out, drv_features_);
+    put(out, queue_sel_);
+    put(out, int_status_);
+    for (const Queue &q : queue_)
+        put(out, q);
+
+    put(out, (uint32_t)resources_.size());
+    for (const auto &r : resources_) {
+        put(out, r.first);
+        put(out, r.second.format);
+        put(out, r.second.width);
+        put(out, r.second.height);
+        put(out, r.second.blob);
+        put(out, r.second.blob_size);
+        put(out, r.second.stride);
+        put(out, r.second.offset);
+        put_vec(out, r.second.pixels);
+        put_vec(out, r.second.backing);
+    }
+    put(out, scanout_res_);
+    put(out, scanout_base_);
+    put(out, scanout_x_);
+    put(out, scanout_y_);
+    put(out, scanout_w_);
+    put(out, scanout_h_);
+    put(out, last_cmd_);
+    put(out, last_resp_);
+    put(out, cmd_cnt_);
+    put(out, cursor_.visible);
+    put(out, cursor_.x);
+    put(out, cursor_.y);
+    put(out, cursor_.hot_x);
+    put(out, cursor_.hot_y);
+    put_vec(out, cursor_.image);
+
+    put_vec(out, std::vector<uint32_t>(fifo_.begin(), fifo_.end()));
+    put(out, busy_);
+    put(out, err_);
+    put(out, draw_int_enbl_);
+    put(out, draw_int_pending_);
+    put(out, frame_addr_);
+    put(out, frame_w_);
+    put(out, frame_h_);
+    put(out, area_x_);
+    put(out, area_y_);
+    put(out, area_w_);
+    put(out, area_h_);
+    put(out, tex_addr_);
+    put(out, tex_w_);
+    put(out, tex_h_);
+    put(out, tex_fmt_);
+    put(out, palette_);
+    put(out, scale_x_);
+    put(out, scale_y_);
+    put(out, bilinear_);
+    put(out, pipes_active_);
+    put(out, fcolor_);
+    put(out, stcolor_);
+    put(out, stencil_);
+    put(out, blend_);
+    put(out, alpha_);
+    put(out, perf_);
+    put(out, ring_base_);
+    put(out, ring_done_);
+    put(out, ring_size_);
+    put(out, ring_head_);
+    put(out, ring_tail_);
+    put(out, dl_ring_);
+    put(out, dl_addr_);
+    put_vec(out, dl_stack_);
+    return (bool)out;
+}
+
+/* All-or-nothing: the live state is only replaced by a complete image */
+bool Engine::load(std::istream &in)
+{
+    Engine e(*mem_);
+    uint32_t magic, version, nres;
+
+    if (!get(in, magic) || magic != SNAPSHOT_MAGIC ||
+        !get(in, version) || version != SNAPSHOT_VERSION)
+        return false;
+
+    bool ok = get(in, e.status_) && get(in, e.dev_features_sel_) &&
+              get(in, e.drv_features_sel_) && get(in, e.drv_features_) &&
+              get(in, e.queue_sel_) && get(in, e.int_status_) &&
+              get(in, e.queue_[0]) && get(in, e.queue_[1]) && get(in, nres);
+    for (uint32_t i = 0; ok && i < nres; i++) {
+        uint32_t id;
+        Resource r;
+        ok = get(in, id) && get(in, r.format) && get(in, r.width) && get(in, r.height) &&
+             get(in, r.blob) && get(in, r.blob_size) && get(in, r.stride) &&
+             get(in, r.offset) && get_vec(in, r.pixels, GPU_RES_MAX_BYTES / 4) &&
+             get_vec(in, r.backing, VIRTQ_REQ_MAX / sizeof(GpuMemEntry));
+        if (ok) {
+            r.index_backing();
+            e.resources_[id] = std::move(r);
+        }
+    }
+    std::vector<uint32_t> fifo;
+    ok = ok && get(in, e.scanout_res_) && get(in, e.scanout_base_) &&
+         get(in, e.scanout_x_) && get(in, e.scanout_y_) &&
+         get(in, e.scanout_w_) && get(in, e.scanout_h_) && get(in, e.last_cmd_) &&
+         get(in, e.last_resp_) && get(in, e.cmd_cnt_) &&
+         get(in, e.cursor_.visible) && get(in, e.cursor_.x) && get(in, e.cursor_.y) &&
+         get(in, e.cursor_.hot_x) && get(in, e.cursor_.hot_y) &&
+         get_vec(in, e.cursor_.image, CURSOR_SIZE * CURSOR_SIZE) &&
+         get_vec(in, fifo, DRAW_FIFO_DEPTH) && get(in, e.busy_) && get(in, e.err_) &&
+         get(in, e.draw_int_enbl_) && get(in, e.draw_int_pending_) &&
+         get(in, e.frame_addr_) && get(in, e.frame_w_) && get(in, e.frame_h_) &&
+         get(in, e.area_x_) && get(in, e.area_y_) && get(in, e.area_w_) && get(in, e.area_h_) &&
+         get(in, e.tex_addr_) && get(in, e.tex_w_) && get(in, e.tex_h_) &&
+         get(in, e.tex_fmt_) && get(in, e.palette_) && get(in, e.scale_x_) &&
+         get(in, e.scale_y_) && get(in, e.bilinear_) && get(in, e.pipes_active_) &&
+         get(in, e.fcolor_) && get(in, e.stcolor_) && get(in, e.stencil_) &&
+         get(in, e.blend_) && get(in, e.alpha_) && get(in, e.perf_) &&
+         get(in, e.ring_base_) && get(in, e.ring_done_) && get(in, e.ring_size_) &&
+         get(in, e.ring_head_) && get(in, e.ring_tail_) && get(in, e.dl_ring_) &&
+         get(in, e.dl_addr_) && get_vec(in, e.dl_stack_, DRAW_CALL_DEPTH);
+    if (!ok || (e.cursor_.visible && e.cursor_.image.size() != CURSOR_SIZE * CURSOR_SIZE) ||
+        e.tex_fmt_ > DRAW_TEX_CLUT8 || !e.scale_x_ || !e.scale_y_)
+        return false;
+    if (e.ring_size_ && (e.ring_head_ >= e.ring_size_ || e.ring_tail_ >= e.ring_size_))
+        return false;
+
+    e.fifo_.assign(fifo.begin(), fifo.end());
+    e.snapshot_path_ = snapshot_path_;
+    e.pipes_ = pipes_;
+    e.pipes_active_ = std::clamp(e.pipes_active_, 1u, pipes_);
+    *this = std::move(e);
+    return true;
+}
+
+void Engine::snapshot(uint32_t op)
+{
+    bool ok = false;
+    if (snapshot_path_.empty()) {
+        ok = false;
+    } else if (op == SNAPSHOT_SAVE) {
+        std::ofstream out(snapshot_path_, std::ios::binary | std::ios::trunc);
+        ok = save(out);
+    } else if (op == SNAPSHOT_RESTORE) {
+        std::ifstream in(snapshot_path_, std::ios::binary);
+        ok = load(in);
+    }
+    snapshot_failed_ = !ok;
+}
+
+/* ── Guest memory helpers ─────────────────────────────────── */
+uint32_t Engine::bus_read32(uint64_t addr)
+{
+    perf_[PERF_RD_BURSTS]++;
+    perf_[PERF_RD_BEATS]++;
+    load_[pipe_].bursts++;
+    load_[pipe_].beats++;
+    return mem_->read32(addr);
+}
+
+void Engine::bus_write32(uint64_t addr, uint32_t value)
+{
+    perf_[PERF_WR_BURSTS]++;
+    perf_[PERF_WR_BEATS]++;
+    load_[pipe_].bursts++;
+    load_[pipe_].beats++;
+    mem_->write32(addr, value);
+}
+
+void Engine::bus_read(uint64_t addr, uint32_t *dst, size_t words)
+{
+    perf_[PERF_RD_BURSTS]++;
+    perf_[PERF_RD_BEATS] += (uint32_t)words;
+    load_[pipe_].bursts++;
+    load_[pipe_].beats += words;
+    mem_->read(addr, dst, words);
+}
+
+void Engine::bus_write(uint64_t addr, const uint32_t *src, size_t words)
+{
+    perf_[PERF_WR_BURSTS]++;
+    perf_[PERF_WR_BEATS] += (uint32_t)words;
+    load_[pipe_].bursts++;
+    load_[pipe_].beats += words;
+    mem_->write(addr, src, words);
+}
+
+void Engine::mem_read(uint64_t addr, void *dst, size_t len)
+{
+    if (!len)
+        return;
+    if (!(addr & 3) && !(len & 3) && !((uintptr_t)dst & 3)) {
+        bus_read(addr, static_cast<uint32_t *>(dst), len / 4);
+        return;
+    }
+    uint64_t base = addr & ~3ull;
+    std::vector<uint32_t> tmp((addr + len - base + 3) / 4);
+    bus_read(base, tmp.data(), tmp.size());
+    memcpy(dst, reinterpret_cast<uint8_t *>(tmp.data()) + (addr - base), len);
+}
+
+void Engine::mem_write(uint64_t addr, const void *src, size_t len)
+{
+    if (!len)
+        return;
+    if (!(addr & 3) && !(len & 3) && !((uintptr_t)src & 3)) {
+        bus_write(addr, static_cast<const uint32_t *>(src), len / 4);
+        return;
+    }
+    uint64_t base = addr & ~3ull;
+    std::vector<uint32_t> tmp((addr + len - base + 3) / 4);
+    tmp.front() = bus_read32(base);                  /* partial head */
+    if ((addr + len) & 3)
+        tmp.back() = bus_read32(base + 4 * (tmp.size() - 1));
+    memcpy(reinterpret_cast<uint8_t *>(tmp.data()) + (addr - base), src, len);
+    bus_write(base, tmp.data(), tmp.size());
+}
+
+uint16_t Engine::mem_read16(uint64_t addr)
+{
+    uint32_t w = bus_read32(addr & ~3ull);
+    return (uint16_t)(w >> ((addr & 2) * 8));
+}
+
+/* ── VirtIO MMIO transport ────────────────────────────────── */
+void Engine::virtio_reset()
+{
+    status_ = 0;
+    dev_features_sel_ = drv_features_sel_ = 0;
+    drv_features_ = 0;
+    queue_sel_ = 0;
+    int_status_ = 0;
+    queue_[0] = queue_[1] = Queue();
+    resources_.clear();
+    scanout_res_ = 0;
+    scanout_base_ = 0;
+    cursor_ = Cursor();
+    scanout_x_ = scanout_y_ = scanout_w_ = scanout_h_ = 0;
+}
+
+uint32_t Engine::virtio_read(uint32_t off)
+{
+    Queue *q = queue_sel_ < 2 ? &queue_[queue_sel_] : nullptr;
+
+    switch (off) {
+    case VIRTIO_MAGIC:
+        return VIRTIO_MAGIC_VALUE;
+    case VIRTIO_VERSION:
+        return 2;
+    case VIRTIO_DEVICE_ID:
+        return VIRTIO_ID_GPU;
+    case VIRTIO_VENDOR_ID:
+        return 0;
+    case VIRTIO_DEV_FEATURES:
+        return dev_features_sel_ < 2 ? (uint32_t)(VIRTIO_DEV_FEATURE_BITS >> (32 * dev_features_sel_)) : 0;
+    case VIRTIO_QUEUE_NUM_MAX:
+        return q ? VIRTQ_NUM_MAX : 0;
+    case VIRTIO_QUEUE_READY:
+        return q && q->ready;
+    case VIRTIO_INT_STATUS:
+        return int_status_;
+    case VIRTIO_STATUS:
+        return status_;
+    case VIRTIO_CONFIG_GEN:
+        return 0;
+    case VIRTIO_CONFIG + 0x0:       /* events_read */
+    case VIRTIO_CONFIG + 0x4:       /* events_clear */
+        return 0;
+    case VIRTIO_CONFIG + 0x8:       /* num_scanouts */
+        return 1;
+    case VIRTIO_CONFIG + 0xC:       /* num_capsets */
+        return 0;
+    }
+    return 0;
+}
+
+void Engine::virtio_write(uint32_t off, uint32_t value)
+{
+    Queue *q = queue_sel_ < 2 ? &queue_[queue_sel_] : nullptr;
+
+    switch (off) {
+    case VIRTIO_DEV_FEATURES_SEL:
+        dev_features_sel_ = value;
+        break;
+    case VIRTIO_DRV_FEATURES:
+        if (drv_features_sel_ < 2) {
+            unsigned sh = drv_features_sel_ * 32;
+            drv_features_ = (drv_features_ & ~(0xFFFFFFFFull << sh)) | ((uint64_t)value << sh);
+        }
+        break;
+    case VIRTIO_DRV_FEATURES_SEL:
+        drv_features_sel_ = value;
+        break;
+    case VIRTIO_QUEUE_SEL:
+        queue_sel_ = value;
+        break;
+    case VIRTIO_QUEUE_NUM:
+        if (q && value <= VIRTQ_NUM_MAX)
+            q->num = value;
+        break;
+    case VIRTIO_QUEUE_READY:
+        if (q) {
+            q->ready = value & 1;
+            if (!q->ready)
+                q->last_avail = q->used_idx = 0;
+        }
+        break;
+    case VIRTIO_QUEUE_NOTIFY:
+        if (value < 2)
+            queue_[value].notified = true;
+        break;
+    case VIRTIO_INT_ACK:
+        int_status_ &= ~value;
+        break;
+    case VIRTIO_STATUS:
+        if (value == 0)
+            virtio_reset();
+        else
+            status_ = value;
+        break;
+    case VIRTIO_QUEUE_DESC_LO:
+        if (q) q->desc = (q->desc & ~0xFFFFFFFFull) | value;
+        break;
+    case VIRTIO_QUEUE_DESC_HI:
+        if (q) q->desc = (q->desc & 0xFFFFFFFFull) | ((uint64_t)value << 32);
+        break;
+    case VIRTIO_QUEUE_AVAIL_LO:
+        if (q) q->avail = (q->avail & ~0xFFFFFFFFull) | value;
+        break;
+    case VIRTIO_QUEUE_AVAIL_HI:
+        if (q) q->avail = (q->avail & 0xFFFFFFFFull) | ((uint64_t)value << 32);
+        break;
+    case VIRTIO_QUEUE_USED_LO:
+        if (q) q->used = (q->used & ~0xFFFFFFFFull) | value;
+        break;
+    case VIRTIO_QUEUE_USED_HI:
+        if (q) q->used = (q->used & 0xFFFFFFFFull) | ((uint64_t)value << 32);
+        break;
+    }
+}
+
+/*
+ * Drain one split virtqueue.  The device-readable part of each chain
+ * is gathered into one request buffer (attach_backing entries may sit
+ * in a descriptor of their own), the response is scattered over the
+ * device-writable part.  Control requests are answered one by one, but
+ * the used index is published and the interrupt raised once per batch,
+ * so a driver queueing transfer+flush pairs (fenced or not) takes one
+ * interrupt for all of them.
+ *
+ * With VIRTIO_RING_F_EVENT_IDX the interrupt is further suppressed
+ * until used_idx passes the driver's used_event, and avail_event asks
+ * for a notification only once the ring holds something new.
+ */
+void Engine::virtq_process(unsigned qi)
+{
+    Queue &q = queue_[qi];
+    q.notified = false;
+    if (!q.ready || !q.num)
+        return;
+
+    const bool event_idx = drv_features_ & VIRTIO_RING_F_EVENT_IDX;
+    std::vector<uint8_t> req, resp;
+    std::vector<Segment> out;
+    uint16_t old_used = q.used_idx;
+    uint16_t avail_idx = mem_read16(q.avail + 2);
+
+    while (q.last_avail != avail_idx) {
+        uint16_t head = mem_read16(q.avail + 4 + 2 * (q.last_avail % q.num));
+        q.last_avail++;
+
+        req.clear();
+        out.clear();
+        uint16_t i = head;
+        for (uint32_t n = 0; n < q.num; n++) {
+            struct { uint64_t addr; uint32_t len; uint16_t flags, next; } d;
+            mem_read(q.desc + 16 * (i % q.num), &d, sizeof(d));
+            if (d.flags & VIRTQ_DESC_F_WRITE) {
+                out.push_back({ d.addr, d.len });
+            } else if (req.size() + d.len <= VIRTQ_REQ_MAX) {
+                size_t at = req.size();
+                req.resize(at + d.len);
+                mem_read(d.addr, req.data() + at, d.len);
+            }
+            if (!(d.flags & VIRTQ_DESC_F_NEXT))
+                break;
+            i = d.next;
+        }
+
+        uint32_t written = 0;
+        if (qi == 1)
+            gpu_cursor(req);
+        else if (gpu_ctrl(req, resp)) {
+            size_t left = resp.size();
+            for (const Segment &s : out) {
+                size_t n = std::min<size_t>(left, s.len);
+                mem_write(s.addr, resp.data() + written, n);
+                written += (uint32_t)n;
+                left -= n;
+                if (!left)
+                    break;
+            }
+        }
+
+        uint32_t elem[2] = { head, written };
+        mem_write(q.used + 4 + 8 * (q.used_idx % q.num), elem, sizeof(elem));
+        q.used_idx++;
+        perf_[PERF_VIRTQ_BUFS]++;
+
+        if (q.last_avail == avail_idx) {
+            /* Pick up what the driver queued meanwhile before publishing */
+            if (event_idx)
+                mem_write(q.used + 4 + 8 * q.num, &q.last_avail, 2);    /* avail_event */
+            avail_idx = mem_read16(q.avail + 2);
+        }
+    }
+    if (q.used_idx == old_used)
+        return;
+    bus_write32(q.used, (uint32_t)q.used_idx << 16);   /* flags = 0 */
+
+    bool irq;
+    if (event_idx) {
+        uint16_t used_event = mem_read16(q.avail + 4 + 2 * q.num);
+        irq = (uint16_t)(q.used_idx - used_event - 1) < (uint16_t)(q.used_idx - old_used);
+    } else {
+        irq = !(mem_read16(q.avail) & VIRTQ_AVAIL_F_NO_INTERRUPT);
+    }
+    if (irq) {
+        int_status_ |= 1;
+        perf_[PERF_VIRTQ_IRQS]++;
+    }
+}
+
+/* ── VirtIO-GPU 2D commands ───────────────────────────────── */
+template <typename T>
+static bool get_req(const std::vector<uint8_t> &req, T &out)
+{
+    if (req.size() < sizeof(T))
+        return false;
+    memcpy(&out, req.data(), sizeof(T));
+    return true;
+}
+
+/* Returns the response length written into @resp (0: none) */
+uint32_t Engine::gpu_ctrl(const std::vector<uint8_t> &req, std::vector<uint8_t> &resp)
+{
+    GpuHdr hdr;
+    if (!get_req(req, hdr))
+        return 0;
+
+    GpuHdr out = {};
+    out.type = GPU_RESP_OK_NODATA;
+    if (hdr.flags & GPU_FLAG_FENCE) {
+        out.flags = GPU_FLAG_FENCE;
+        out.fence_id = hdr.fence_id;
+        out.ctx_id = hdr.ctx_id;
+        out.ring_idx = hdr.ring_idx;
+    }
+    resp.assign(sizeof(GpuHdr), 0);
+
+    switch (hdr.type) {
+    case GPU_CMD_GET_DISPLAY_INFO: {
+        GpuDisplayInfo info = {};
+        info.pmodes[0].r = { 0, 0, SCANOUT_WIDTH, SCANOUT_HEIGHT };
+        info.pmodes[0].enabled = 1;
+        out.type = GPU_RESP_OK_DISPLAY_INFO;
+        resp.assign(sizeof(info), 0);
+        memcpy(resp.data() + sizeof(GpuHdr), &info.pmodes, sizeof(info.pmodes));
+        break;
+    }
+    case GPU_CMD_RESOURCE_CREATE_2D: {
+        GpuCreate2d c;
+        if (!get_req(req, c) || !c.resource_id || !format_supported(c.format) ||
+            !c.width || !c.height || resources_.count(c.resource_id)) {
+            out.type = GPU_RESP_ERR_INVALID_PARAMETER;
+            break;
+        }
+        if ((uint64_t)c.width * c.height * 4 > GPU_RES_MAX_BYTES) {
+            out.type = GPU_RESP_ERR_OUT_OF_MEMORY;
+            break;
+        }
+        Resource &res = resources_[c.resource_id];
+        res.format = c.format;
+        res.width = c.width;
+        res.height = c.height;
+        res.pixels.assign((size_t)c.width * c.height, 0);
+        break;
+    }
+    case GPU_CMD_RESOURCE_UNREF: {
+        GpuResourceId c;
+        if (!get_req(req, c) || !resources_.erase(c.resource_id)) {
+            out.type = GPU_RESP_ERR_INVALID_RESOURCE_ID;
+            break;
+        }
+        if (scanout_res_ == c.resource_id)
+            scanout_res_ = scanout_base_ = 0;
+        break;
+    }
+    case GPU_CMD_RESOURCE_CREATE_BLOB: {
+        GpuCreateBlob c;
+        if (!get_req(req, c) || !c.resource_id || resources_.count(c.resource_id) ||
+            c.blob_mem != GPU_BLOB_MEM_GUEST || !c.size ||
+            req.size() < sizeof(c) + (size_t)c.nr_entries * sizeof(GpuMemEntry)) {
+            out.type = GPU_RESP_ERR_INVALID_PARAMETER;
+            break;
+        }
+        /* Guest blob: the pixels stay in guest memory, nothing is allocated */
+        Resource &res = resources_[c.resource_id];
+        res.blob = true;
+        res.blob_size = c.size;
+        for (uint32_t e = 0; e < c.nr_entries; e++) {
+            GpuMemEntry m;
+            memcpy(&m, req.data() + sizeof(c) + e * sizeof(m), sizeof(m));
+            res.backing.push_back({ m.addr, m.length });
+        }
+        res.index_backing();
+        break;
+    }
+    case GPU_CMD_RESOURCE_ATTACH_BACKING: {
+        GpuAttachBacking c;
+        auto it = get_req(req, c) ? resources_.find(c.resource_id) : resources_.end();
+        if (it == resources_.end()) {
+            out.type = GPU_RESP_ERR_INVALID_RESOURCE_ID;
+            break;
+        }
+        if (req.size() < sizeof(c) + (size_t)c.nr_entries * sizeof(GpuMemEntry)) {
+            out.type = GPU_RESP_ERR_INVALID_PARAMETER;
+            break;
+        }
+        it->second.backing.clear();
+        for (uint32_t e = 0; e < c.nr_entries; e++) {
+            GpuMemEntry m;
+            memcpy(&m, req.data() + sizeof(c) + e * sizeof(m), sizeof(m));
+            it->second.backing.push_back({ m.addr, m.length });
+        }
+        it->second.index_backing();
+        break;
+    }
+    case GPU_CMD_RESOURCE_DETACH_BACKING: {
+        GpuResourceId c;
+        auto it = get_req(req, c) ? resources_.find(c.resource_id) : resources_.end();
+        if (it == resources_.end())
+            out.type = GPU_RESP_ERR_INVALID_RESOURCE_ID;
+        else {
+            it->second.backing.clear();
+            it->second.index_backing();
+        }
+        break;
+    }
+    case GPU_CMD_SET_SCANOUT: {
+        GpuSetScanout c;
+        if (!get_req(req, c) || c.scanout_id != 0) {
+            out.type = GPU_RESP_ERR_INVALID_SCANOUT_ID;
+            break;
+        }
+        if (!c.resource_id) {
+            scanout_res_ = 0;
+            scanout_w_ = scanout_h_ = 0;
+            break;
+        }
+        auto it = resources_.find(c.resource_id);
+        if (it == resources_.end()) {
+            out.type = GPU_RESP_ERR_INVALID_RESOURCE_ID;
+            break;
+        }
+        const Resource &res = it->second;
+        if (res.blob || (uint64_t)c.r.x + c.r.width > res.width ||
+            (uint64_t)c.r.y + c.r.height > res.height) {
+            out.type = GPU_RESP_ERR_INVALID_PARAMETER;
+            break;
+        }
+        scanout_res_ = c.resource_id;
+        scanout_base_ = 0;
+        scanout_x_ = c.r.x;
+        scanout_y_ = c.r.y;
+        scanout_w_ = c.r.width;
+        scanout_h_ = c.r.height;
+        break;
+    }
+    case GPU_CMD_SET_SCANOUT_BLOB: {
+        GpuSetScanoutBlob c;
+        if (!get_req(req, c) || c.scanout_id != 0) {
+            out.type = GPU_RESP_ERR_INVALID_SCANOUT_ID;
+            break;
+        }
+        if (!c.resource_id) {
+            scanout_res_ = 0;
+            scanout_w_ = scanout_h_ = 0;
+            break;
+        }
+        auto it = resources_.find(c.resource_id);
+        if (it == resources_.end() || !it->second.blob) {
+            out.type = GPU_RESP_ERR_INVALID_RESOURCE_ID;
+            break;
+        }
+        Resource &res = it->second;
+        uint64_t span = (uint64_t)c.strides[0] * c.height;
+        if (!format_supported(c.format) || !c.width || !c.height ||
+            c.strides[0] < (uint64_t)c.width * 4 ||
+            c.offsets[0] + span > res.blob_size ||
+            (uint64_t)c.r.x + c.r.width > c.width ||
+            (uint64_t)c.r.y + c.r.height > c.height) {
+            out.type = GPU_RESP_ERR_INVALID_PARAMETER;
+            break;
+        }
+        res.format = c.format;
+        res.width = c.width;
+        res.height = c.height;
+        res.stride = c.strides[0];
+        res.offset = c.offsets[0];
+
+        scanout_res_ = c.resource_id;
+        scanout_x_ = c.r.x;
+        scanout_y_ = c.r.y;
+        scanout_w_ = c.r.width;
+        scanout_h_ = c.r.height;
+
+        /*
+         * Zero-copy when the viewer can read the buffer as it is: ARGB
+         * byte order, SCANOUT_WIDTH pitch and one contiguous entry.
+         * DBG_FB_ADDR then points at guest memory and flushes are free;
+         * otherwise each flush copies the damaged rows to SCANOUT_ADDR.
+         */
+        uint64_t start = res.offset + (uint64_t)c.r.y * res.stride + (uint64_t)c.r.x * 4;
+        bool argb = c.format == GPU_FORMAT_B8G8R8A8 || c.format == GPU_FORMAT_B8G8R8X8;
+        scanout_base_ = argb && res.stride == SCANOUT_WIDTH * 4
+                        ? backing_contig(res, start, (uint64_t)res.stride * c.r.height) : 0;
+        break;
+    }
+    case GPU_CMD_TRANSFER_TO_HOST_2D: {
+        GpuTransfer2d c;
+        auto it = get_req(req, c) ? resources_.find(c.resource_id) : resources_.end();
+        if (it == resources_.end()) {
+            out.type = GPU_RESP_ERR_INVALID_RESOURCE_ID;
+            break;
+        }
+        Resource &res = it->second;
+        if (res.blob)
+            break;              /* guest blob: already where it is scanned out from */
+        if ((uint64_t)c.r.x + c.r.width > res.width ||
+            (uint64_t)c.r.y + c.r.height > res.height || res.backing.empty()) {
+            out.type = GPU_RESP_ERR_INVALID_PARAMETER;
+            break;
+        }
+        /* Same offset rule as QEMU: row h starts at offset + h * stride */
+        uint64_t stride = (uint64_t)res.width * 4;
+        perf_[PERF_XFER_PIXELS] += c.r.width * c.r.height;
+        if (c.r.x == 0 && c.r.width == res.width) {
+            backing_read(res, c.offset, &res.pixels[(size_t)c.r.y * res.width],
+                         (size_t)c.r.width * c.r.height);
+        } else {
+            for (uint32_t h = 0; h < c.r.height; h++)
+                backing_read(res, c.offset + stride * h,
+                             &res.pixels[(size_t)(c.r.y + h) * res.width + c.r.x],
+                             c.r.width);
+        }
+        break;
+    }
+    case GPU_CMD_RESOURCE_FLUSH: {
+        GpuFlush c;
+        auto it = get_req(req, c) ? resources_.find(c.resource_id) : resources_.end();
+        if (it == resources_.end()) {
+            out.type = GPU_RESP_ERR_INVALID_RESOURCE_ID;
+            break;
+        }
+        if (c.resource_id == scanout_res_ && !scanout_direct())
+            scanout_flush(it->second, c.r.x, c.r.y, c.r.width, c.r.height);
+        break;
+    }
+    default:
+        out.type = GPU_RESP_ERR_UNSPEC;
+        break;
+    }
+
+    last_cmd_ = hdr.type;
+    last_resp_ = out.type;
+    cmd_cnt_++;
+    memcpy(resp.data(), &out, sizeof(out));
+    return (uint32_t)resp.size();
+}
+
+/*
+ * @words pixels starting at byte @off of the scatter-gather backing.
+ * The entry holding @off is found by bisecting backing_end, so a
+ * partial-width transfer costs one lookup per row, not a walk.
+ */
+void Engine::backing_read(const Resource &res, uint64_t off, uint32_t *dst, size_t words)
+{
+    uint8_t *p = reinterpret_cast<uint8_t *>(dst);
+    size_t len = words * 4;
+
+    size_t i = std::upper_bound(res.backing_end.begin(), res.backing_end.end(), off) -
+               res.backing_end.begin();
+    if (i < res.backing.size())
+        off -= res.backing_end[i] - res.backing[i].len;
+
+    for (; len && i < res.backing.size(); i++, off = 0) {
+        const Segment &s = res.backing[i];
+        size_t n = std::min<size_t>(len, s.len - off);
+        mem_read(s.addr + off, p, n);
+        p += n;
+        len -= n;
+    }
+    if (len)
+        memset(p, 0, len);      /* past the end of the backing */
+}
+
+/* Guest address of backing bytes [off, off + len) if one entry holds them, else 0 */
+uint64_t Engine::backing_contig(const Resource &res, uint64_t off, uint64_t len) const
+{
+    size_t i = std::upper_bound(res.backing_end.begin(), res.backing_end.end(), off) -
+               res.backing_end.begin();
+    if (i == res.backing.size() || off + len > res.backing_end[i])
+        return 0;
+    return res.backing[i].addr + (off - (res.backing_end[i] - res.backing[i].len));
+}
+
+/* @n converted (ARGB8888) pixels of row @y from column @x of @res */
+void Engine::resource_row(const Resource &res, uint64_t x, uint64_t y, uint32_t *dst, size_t n)
+{
+    if (res.blob)
+        backing_read(res, res.offset + y * res.stride + x * 4, dst, n);
+    else
+        memcpy(dst, &res.pixels[y * res.width + x], n * 4);
+    for (size_t i = 0; i < n; i++)
+        dst[i] = to_argb(res.format, dst[i]);
+}
+
+/* Resource rect (x, y, w, h) → scanout, clipped to both, cursor on top */
+void Engine::scanout_flush(const Resource &res, uint32_t x, uint32_t y,
+                           uint32_t w, uint32_t h)
+{
+    uint64_t x0 = std::max(x, scanout_x_), y0 = std::max(y, scanout_y_);
+    uint64_t x1 = std::min({ (uint64_t)x + w, (uint64_t)scanout_x_ + scanout_w_,
+                             (uint64_t)scanout_x_ + SCANOUT_WIDTH, (uint64_t)res.width });
+    uint64_t y1 = std::min({ (uint64_t)y + h, (uint64_t)scanout_y_ + scanout_h_,
+                             (uint64_t)scanout_y_ + SCANOUT_HEIGHT, (uint64_t)res.height });
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    /* Cursor image origin in resource coordinates */
+    int64_t cx = (int64_t)scanout_x_ + cursor_.x - cursor_.hot_x;
+    int64_t cy = (int64_t)scanout_y_ + cursor_.y - cursor_.hot_y;
+
+    std::vector<uint32_t> row(x1 - x0);
+    perf_[PERF_FLUSH_PIXELS] += (uint32_t)((x1 - x0) * (y1 - y0));
+    for (uint64_t yy = y0; yy < y1; yy++) {
+        resource_row(res, x0, yy, row.data(), row.size());
+        if (cursor_.visible && (int64_t)yy >= cy && (int64_t)yy < cy + CURSOR_SIZE) {
+            const uint32_t *img = &cursor_.image[(yy - cy) * CURSOR_SIZE];
+            int64_t a = std::max<int64_t>(x0, cx), b = std::min<int64_t>(x1, cx + CURSOR_SIZE);
+            for (int64_t xx = a; xx < b; xx++) {
+                uint32_t c = img[xx - cx];
+                row[xx - x0] = blend_px(c, row[xx - x0], c >> 24);
+            }
+        }
+        uint64_t dst = SCANOUT_ADDR +
+                       (((yy - scanout_y_) * SCANOUT_WIDTH) + (x0 - scanout_x_)) * 4;
+        bus_write(dst, row.data(), row.size());
+    }
+}
+
+/* Rewrite the scanout under the cursor box (primary + overlay) */
+void Engine::cursor_refresh()
+{
+    auto it = resources_.find(scanout_res_);
+    if (it == resources_.end() || scanout_direct())
+        return;
+    int64_t x = (int64_t)scanout_x_ + cursor_.x - cursor_.hot_x;
+    int64_t y = (int64_t)scanout_y_ + cursor_.y - cursor_.hot_y;
+    int64_t x0 = std::max<int64_t>(x, 0), y0 = std::max<int64_t>(y, 0);
+    int64_t x1 = x + CURSOR_SIZE, y1 = y + CURSOR_SIZE;
+    if (x1 > x0 && y1 > y0)
+        scanout_flush(it->second, (uint32_t)x0, (uint32_t)y0,
+                      (uint32_t)(x1 - x0), (uint32_t)(y1 - y0));
+}
+
+/*
+ * Cursor queue.  No response is defined: the driver only waits for the
+ * used-ring entry.  A move rewrites the old and the new cursor box; while
+ * the cursor is shown a zero-copy blob scanout falls back to the copied
+ * frame, since the overlay cannot be blended into guest memory.
+ */
+void Engine::gpu_cursor(const std::vector<uint8_t> &req)
+{
+    GpuUpdateCursor c;
+    if (!get_req(req, c) || c.scanout_id != 0)
+        return;
+    if (c.hdr.type != GPU_CMD_UPDATE_CURSOR && c.hdr.type != GPU_CMD_MOVE_CURSOR)
+        return;
+
+    bool was_direct = scanout_direct();
+    bool was_visible = cursor_.visible;
+    if (was_visible) {
+        cursor_.visible = false;
+        cursor_refresh();           /* erase at the old position */
+    }
+
+    cursor_.x = (int32_t)c.x;
+    cursor_.y = (int32_t)c.y;
+    cursor_.visible = was_visible;
+    if (c.hdr.type == GPU_CMD_UPDATE_CURSOR) {
+        auto it = resources_.find(c.resource_id);
+        cursor_.visible = it != resources_.end();
+        if (cursor_.visible) {
+            const Resource &res = it->second;
+            uint32_t w = std::min(res.width, CURSOR_SIZE), h = std::min(res.height, CURSOR_SIZE);
+            cursor_.hot_x = c.hot_x;
+            cursor_.hot_y = c.hot_y;
+            cursor_.image.assign(CURSOR_SIZE * CURSOR_SIZE, 0);
+            for (uint32_t y = 0; y < h; y++)
+                resource_row(res, 0, y, &cursor_.image[y * CURSOR_SIZE], w);
+        }
+    }
+
+    if (was_direct && !scanout_direct()) {
+        /* Leaving zero-copy: bring the copied frame up to date first */
+        auto it = resources_.find(scanout_res_);
+        if (it != resources_.end())
+            scanout_flush(it->second, scanout_x_, scanout_y_, scanout_w_, scanout_h_);
+    } else if (cursor_.visible) {
+        cursor_refresh();
+    }
+}
+
+/* ── Legacy Draw Engine ───────────────────────────────────── */
+void Engine::draw_reset()
+{
+    fifo_.clear();
+    busy_ = false;
+    err_ = 0;
+    draw_int_pending_ = false;
+    frame_addr_ = tex_addr_ = 0;
+    frame_w_ = frame_h_ = tex_w_ = tex_h_ = 0;
+    tex_fmt_ = DRAW_TEX_ARGB8888;
+    std::fill(std::begin(palette_), std::end(palette_), 0);
+    scale_x_ = scale_y_ = 0x10000;
+    bilinear_ = false;
+    area_x_ = area_y_ = area_w_ = area_h_ = 0;
+    fcolor_ = stcolor_ = 0;
+    stencil_ = blend_ = false;
+    alpha_ = 0xFF;
+    ring_head_ = ring_tail_ = 0;
+    dl_ring_ = true;
+    dl_addr_ = 0;
+    dl_stack_.clear();
+    fetch_.clear();
+}
+
+uint32_t Engine::draw_read(uint32_t off)
+{
+    switch (off) {
+    case DRAW_REG_STAT:
+        return (busy_ ? DRAW_STAT_BUSY : 0) | (err_ << 16);
+    case DRAW_REG_CAPS:
+        return DRAW_CAPS_RING | DRAW_CAPS_SHAPES | DRAW_CAPS_TEXFMT | DRAW_CAPS_PIPES;
+    case DRAW_REG_PIPES:
+        return pipes_active_ | pipes_ << 16;
+    case DRAW_REG_BUFSTAT:
+        return (uint32_t)fifo_.size() |
+               (fifo_.empty() ? DRAW_BUF_EMPTY : 0) |
+               (fifo_.size() >= DRAW_FIFO_DEPTH ? DRAW_BUF_FULL : 0);
+    case DRAW_REG_INT:
+        return (draw_int_enbl_ ? DRAW_INT_ENBL : 0) |
+               (draw_int_pending_ ? DRAW_INT_PENDING : 0);
+    case DRAW_REG_RINGBASE:
+        return (uint32_t)ring_base_;
+    case DRAW_REG_RINGSIZE:
+        return ring_size_;
+    case DRAW_REG_RINGHEAD:
+        return ring_head_;
+    case DRAW_REG_RINGTAIL:
+        return ring_tail_;
+    case DRAW_REG_RINGDONE:
+        return (uint32_t)ring_done_;
+    }
+    if (off >= DRAW_REG_PERF && off < DRAW_REG_PERF + 4 * PERF_NUM && !(off & 3))
+        return perf_[(off - DRAW_REG_PERF) / 4];
+    return 0;
+}
+
+void Engine::draw_write(uint32_t off, uint32_t value)
+{
+    switch (off) {
+    case DRAW_REG_CTRL:
+        if (value & DRAW_CTRL_RST) {
+            bool enbl = draw_int_enbl_;
+            draw_reset();
+            draw_int_enbl_ = enbl;
+        } else if ((value & DRAW_CTRL_EXE) && !busy_) {
+            busy_ = true;
+            err_ = 0;
+        }
+        break;
+    case DRAW_REG_CMD:
+        if (fifo_.size() < DRAW_FIFO_DEPTH)
+            fifo_.push_back(value);
+        else
+            perf_[PERF_FIFO_FULL]++;
+        break;
+    case DRAW_REG_PERFCTRL:
+        if (value & DRAW_PERF_CLEAR)
+            std::fill(std::begin(perf_), std::end(perf_), 0);
+        break;
+    case DRAW_REG_INT:
+        draw_int_enbl_ = value & DRAW_INT_ENBL;
+        if (value & DRAW_INT_CLR)
+            draw_int_pending_ = false;
+        break;
+    case DRAW_REG_RINGBASE:
+    case DRAW_REG_RINGSIZE:
+        /*
+         * Re-arming the ring starts over at offset 0 and waits for
+         * idle.  A disarm (size 0) is always taken, so the driver can
+         * get the FIFO back from a client that died mid-list; a list
+         * still running from the ring is abandoned.
+         */
+        if (busy_ && (off != DRAW_REG_RINGSIZE || value))
+            break;
+        if (busy_ && ring_size_)
+            busy_ = false;
+        if (off == DRAW_REG_RINGBASE)
+            ring_base_ = value & ~3u;
+        else
+            ring_size_ = value & ~3u;
+        ring_head_ = ring_tail_ = 0;
+        dl_ring_ = true;
+        dl_stack_.clear();
+        fetch_.clear();
+        break;
+    case DRAW_REG_RINGTAIL:
+        if (!ring_size_)
+            break;
+        ring_tail_ = (value & ~3u) % ring_size_;
+        fetch_.clear();
+        if (!busy_) {
+            busy_ = true;
+            err_ = 0;
+        }
+        break;
+    case DRAW_REG_RINGDONE:
+        ring_done_ = value & ~3u;
+        break;
+    case DRAW_REG_PIPES:
+        /* Pipelines to split over, from the next drawing command on */
+        pipes_active_ = std::clamp(value & 0xF, 1u, pipes_);
+        break;
+    }
+}
+
+constexpr unsigned DRAW_CMD_WORDS_MAX = 5;
+
+static unsigned draw_cmd_words(uint32_t op)
+{
+    switch (op) {
+    case DRAW_OP_SETFRAME:
+    case DRAW_OP_SETDRAWAREA:
+    case DRAW_OP_SETTEXTURE:
+    case DRAW_OP_SETSCALE:
+    case DRAW_OP_PATBLT:
+    case DRAW_OP_LINE:
+    case DRAW_OP_ELLIPSE:
+        return 3;
+    case DRAW_OP_SETFCOLOR:
+    case DRAW_OP_SETSTCOLOR:
+    case DRAW_OP_SETPALETTE:
+    case DRAW_OP_JUMP:
+    case DRAW_OP_CALL:
+        return 2;
+    case DRAW_OP_BITBLT:
+    case DRAW_OP_SCALEBLT:
+    case DRAW_OP_TRIANGLE:
+        return 4;
+    case DRAW_OP_GRADIENT:
+        return 5;
+    }
+    return 1;
+}
+
+/*
+ * Execute whole commands while they are in the FIFO.  A list that
+ * runs dry before EODL keeps the engine busy until the driver pushes
+ * the rest, as with the RTL.
+ */
+void Engine::draw_run()
+{
+    if (ring_size_) {
+        ring_run();
+        return;
+    }
+    while (busy_ && !fifo_.empty()) {
+        unsigned n = draw_cmd_words(fifo_.front() >> 24);
+        if (fifo_.size() < n)
+            break;
+        uint32_t w[DRAW_CMD_WORDS_MAX];
+        for (unsigned i = 0; i < n; i++) {
+            w[i] = fifo_.front();
+            fifo_.pop_front();
+        }
+        if (!draw_exec(w))
+            return;
+    }
+    if (busy_)
+        perf_[PERF_FIFO_EMPTY]++;       /* ran dry before EODL */
+}
+
+/* Word @k ahead of the fetch pointer, through the prefetch buffer */
+uint32_t Engine::ring_word(unsigned k)
+{
+    uint64_t addr = dl_ring_ ? ring_base_ + (ring_head_ + 4ull * k) % ring_size_
+                             : dl_addr_ + 4ull * k;
+    if (addr < fetch_addr_ || addr >= fetch_addr_ + 4 * fetch_.size()) {
+        /* One burst: up to the tail / ring end, or the 4 KiB boundary */
+        uint64_t n;
+        if (dl_ring_) {
+            uint32_t off = (uint32_t)(addr - ring_base_);
+            uint32_t avail = (ring_tail_ + ring_size_ - off) % ring_size_;
+            n = std::min<uint64_t>({ DRAW_FETCH_WORDS, (ring_size_ - off) / 4, avail / 4 });
+        } else {
+            n = std::min<uint64_t>(DRAW_FETCH_WORDS, (4096 - (addr & 4095)) / 4);
+        }
+        fetch_.resize(std::max<uint64_t>(n, 1));
+        fetch_addr_ = addr;
+        bus_read(addr, fetch_.data(), fetch_.size());
+    }
+    return fetch_[(addr - fetch_addr_) / 4];
+}
+
+/* Next whole command into @w; false while the ring holds less than one */
+bool Engine::ring_fetch(uint32_t *w)
+{
+    uint32_t avail = dl_ring_ ? (ring_tail_ + ring_size_ - ring_head_) % ring_size_ : ~0u;
+    if (!avail)
+        return false;
+    unsigned n = draw_cmd_words(ring_word(0) >> 24);
+    if (avail < 4 * n)
+        return false;
+    for (unsigned i = 0; i < n; i++)
+        w[i] = ring_word(i);
+    if (dl_ring_)
+        ring_head_ = (ring_head_ + 4 * n) % ring_size_;
+    else
+        dl_addr_ += 4 * n;
+    return true;
+}
+
+void Engine::ring_goto(uint64_t addr)
+{
+    addr &= ~3ull;
+    dl_ring_ = addr >= ring_base_ && addr < ring_base_ + ring_size_;
+    if (dl_ring_)
+        ring_head_ = (uint32_t)(addr - ring_base_);
+    else
+        dl_addr_ = addr;
+}
+
+/*
+ * Ring mode: fetch commands from guest memory between DRAWRINGHEAD and
+ * DRAWRINGTAIL.  Each EODL writes its [23:0] tag to DRAWRINGDONE and
+ * raises DRW_IRQ; the engine only goes idle once the ring is drained.
+ * The command budget keeps a JUMP loop from stalling the simulation.
+ */
+void Engine::ring_run()
+{
+    for (unsigned budget = DRAW_RING_BUDGET; busy_ && budget; budget--) {
+        uint32_t w[DRAW_CMD_WORDS_MAX];
+        if (!ring_fetch(w)) {
+            perf_[PERF_FIFO_EMPTY]++;   /* ran dry before EODL */
+            return;
+        }
+        switch (w[0] >> 24) {
+        case DRAW_OP_JUMP:
+            perf_[PERF_CMDS]++;
+            ring_goto(w[1]);
+            break;
+        case DRAW_OP_CALL:
+            perf_[PERF_CMDS]++;
+            if (dl_stack_.size() >= DRAW_CALL_DEPTH) {
+                draw_stop(DRAW_ERR_STACK);
+                return;
+            }
+            dl_stack_.push_back({ dl_ring_ ? ring_head_ : dl_addr_, dl_ring_, 0 });
+            ring_goto(w[1]);
+            break;
+        case DRAW_OP_RET:
+            perf_[PERF_CMDS]++;
+            if (dl_stack_.empty()) {
+                draw_stop(DRAW_ERR_STACK);
+                return;
+            }
+            dl_ring_ = dl_stack_.back().ring;
+            if (dl_ring_)
+                ring_head_ = (uint32_t)dl_stack_.back().addr;
+            else
+                dl_addr_ = dl_stack_.back().addr;
+            dl_stack_.pop_back();
+            break;
+        case DRAW_OP_EODL:
+            perf_[PERF_CMDS]++;
+            perf_[PERF_LISTS]++;
+            if (ring_done_)
+                bus_write32(ring_done_, w[0] & 0xFFFFFF);
+            draw_int_pending_ = true;
+            fetch_.clear();             /* chained lists may be rewritten now */
+            if (dl_ring_ && dl_stack_.empty() && ring_head_ == ring_tail_) {
+                draw_stop(0);
+                return;
+            }
+            break;
+        default:
+            if (!draw_exec(w))
+                return;
+        }
+    }
+}
+
+void Engine::draw_stop(uint32_t err)
+{
+    busy_ = false;
+    err_ = err;
+    draw_int_pending_ = true;
+}
+
+/* Returns false once the list has ended (EODL or error) */
+bool Engine::draw_exec(const uint32_t *w)
+{
+    perf_[PERF_CMDS]++;
+    switch (w[0] >> 24) {
+    case DRAW_OP_NOP:
+        break;
+    case DRAW_OP_EODL:
+        perf_[PERF_LISTS]++;
+        draw_stop(0);
+        return false;
+    case DRAW_OP_SETFRAME:
+        frame_addr_ = w[1];
+        frame_w_ = w[2] >> 16;
+        frame_h_ = w[2] & 0xFFFF;
+        break;
+    case DRAW_OP_SETDRAWAREA:
+        area_x_ = pos16(w[1] >> 16);
+        area_y_ = pos16(w[1]);
+        area_w_ = w[2] >> 16;
+        area_h_ = w[2] & 0xFFFF;
+        break;
+    case DRAW_OP_SETTEXTURE:
+        if ((w[0] & 3) > DRAW_TEX_CLUT8) {
+            draw_stop(DRAW_ERR_FORMAT);
+            return false;
+        }
+        tex_addr_ = w[1];
+        tex_w_ = w[2] >> 16;
+        tex_h_ = w[2] & 0xFFFF;
+        tex_fmt_ = w[0] & 3;
+        break;
+    case DRAW_OP_SETPALETTE:
+        /* [8:0] entries from index 0, read once into the palette RAM */
+        mem_read(w[1], palette_, std::min<uint32_t>(w[0] & 0x1FF, 256) * 4);
+        break;
+    case DRAW_OP_SETSCALE:
+        /* Source texels per destination pixel, 16.16; 0 selects 1:1 */
+        scale_x_ = w[1] ? w[1] : 0x10000;
+        scale_y_ = w[2] ? w[2] : 0x10000;
+        bilinear_ = w[0] & DRAW_SCALE_BILINEAR;
+        break;
+    case DRAW_OP_SETFCOLOR:
+        fcolor_ = w[1];
+        break;
+    case DRAW_OP_SETSTCOLOR:
+        stcolor_ = w[1];
+        break;
+    case DRAW_OP_SETSTMODE:
+        stencil_ = w[0] & 1;
+        break;
+    case DRAW_OP_SETBLENDALPHA:
+        blend_ = true;
+        alpha_ = w[0] & 0xFF;
+        break;
+    case DRAW_OP_SETBLENDOFF:
+        blend_ = false;
+        break;
+    case DRAW_OP_PATBLT:
+    case DRAW_OP_BITBLT:
+    case DRAW_OP_SCALEBLT:
+    case DRAW_OP_LINE:
+    case DRAW_OP_TRIANGLE:
+    case DRAW_OP_ELLIPSE:
+    case DRAW_OP_GRADIENT:
+        if (!frame_w_) {
+            draw_stop(DRAW_ERR_NOFRAME);
+            return false;
+        }
+        draw_dispatch(w);
+        break;
+    default:
+        draw_stop(DRAW_ERR_OPCODE);
+        return false;
+    }
+    return true;
+}
+
+/* One drawing command on the pipeline dispatch has selected */
+void Engine::draw_op(const uint32_t *w)
+{
+    switch (w[0] >> 24) {
+    case DRAW_OP_PATBLT:
+        draw_patblt(pos16(w[1] >> 16), pos16(w[1]), w[2] >> 16, w[2] & 0xFFFF);
+        break;
+    case DRAW_OP_BITBLT:
+        draw_bitblt(pos16(w[1] >> 16), pos16(w[1]), w[2] >> 16, w[2] & 0xFFFF,
+                    pos16(w[3] >> 16), pos16(w[3]));
+        break;
+    case DRAW_OP_SCALEBLT:
+        draw_scaleblt(pos16(w[1] >> 16), pos16(w[1]), w[2] >> 16, w[2] & 0xFFFF,
+                      pos16(w[3] >> 16), pos16(w[3]));
+        break;
+    case DRAW_OP_LINE:
+        draw_line(pos16(w[1] >> 16), pos16(w[1]), pos16(w[2] >> 16), pos16(w[2]));
+        break;
+    case DRAW_OP_TRIANGLE:
+        draw_triangle(pos16(w[1] >> 16), pos16(w[1]), pos16(w[2] >> 16), pos16(w[2]),
+                      pos16(w[3] >> 16), pos16(w[3]));
+        break;
+    case DRAW_OP_ELLIPSE:
+        draw_ellipse(pos16(w[1] >> 16), pos16(w[1]), w[2] >> 16, w[2] & 0xFFFF);
+        break;
+    case DRAW_OP_GRADIENT:
+        draw_gradient(pos16(w[1] >> 16), pos16(w[1]), w[2] >> 16, w[2] & 0xFFFF,
+                      w[3], w[4], w[0] & DRAW_GRAD_VERTICAL);
+        break;
+    }
+}
+
+/*
+ * Frame rows a drawing command can touch, clipped to the draw area.
+ * False when the rows must not be split: a BITBLT or SCALEBLT whose
+ * texture shares memory with the frame may read rows another band
+ * writes.
+ */
+bool Engine::draw_rows(const uint32_t *w, int &y0, int &y1) const
+{
+    int a = pos16(w[1]), b;
+    switch (w[0] >> 24) {
+    case DRAW_OP_LINE:
+        b = pos16(w[2]);
+        y0 = std::min(a, b);
+        y1 = std::max(a, b) + 1;
+        break;
+    case DRAW_OP_TRIANGLE:
+        y0 = std::min({ a, pos16(w[2]), pos16(w[3]) });
+        y1 = std::max({ a, pos16(w[2]), pos16(w[3]) }) + 1;
+        break;
+    case DRAW_OP_ELLIPSE:
+        y0 = a - (int)(w[2] & 0xFFFF);
+        y1 = a + (int)(w[2] & 0xFFFF) + 1;
+        break;
+    default:
+        y0 = a;
+        y1 = a + (int)(w[2] & 0xFFFF);
+        break;
+    }
+    y0 = std::max({ y0 + area_y_, area_y_, 0 });
+    y1 = std::min({ y1 + area_y_, area_y_ + area_h_, frame_h_ });
+
+    uint32_t op = w[0] >> 24;
+    if (op == DRAW_OP_BITBLT || op == DRAW_OP_SCALEBLT) {
+        uint64_t tex_end = tex_addr_ + tex_h_ * tex_stride();
+        uint64_t frame_end = frame_addr_ + (uint64_t)frame_h_ * frame_w_ * 4;
+        if (tex_addr_ < frame_end && frame_addr_ < tex_end)
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Hand a drawing command to the pipelines.  Each gets the same command
+ * with the clip narrowed to its band of rows, so the clipping logic
+ * does the split and the bands cover exactly the pixels the whole
+ * command would.  The command completes when all its bands have: that
+ * join keeps painter's order between commands, and the last one's
+ * EODL raises DRW_IRQ once for the whole list.  Each pipeline has its
+ * own SCALEBLT line buffers, so a source row straddling a band seam is
+ * read by both bands.
+ */
+void Engine::draw_dispatch(const uint32_t *w)
+{
+    int y0, y1;
+    unsigned n = 1;
+    if (draw_rows(w, y0, y1) && y1 > y0)
+        n = std::min<unsigned>(pipes_active_, (unsigned)(y1 - y0));
+
+    for (unsigned k = 0; k < n; k++) {
+        load_[k] = {};
+        if (n > 1) {
+            band_y0_ = y0 + (int)((uint64_t)(y1 - y0) * k / n);
+            band_y1_ = y0 + (int)((uint64_t)(y1 - y0) * (k + 1) / n);
+        }
+        pipe_ = k;
+        draw_op(w);
+    }
+    pipe_ = 0;
+    band_y0_ = 0;
+    band_y1_ = INT32_MAX;
+
+    uint64_t beats = 0, busiest = 0;
+    for (unsigned k = 0; k < n; k++) {
+        beats += load_[k].beats;
+        busiest = std::max(busiest, load_[k].beats + load_[k].bursts * DRAW_AXI_LATENCY);
+    }
+    perf_[PERF_BANDS] += n;
+    perf_[PERF_CYCLES] += (uint32_t)std::max(busiest, beats);
+}
+
+/*
+ * Destination (dx, dy) is relative to the draw area; clip to the area,
+ * the frame and the dispatch band, shifting the source origin by the
+ * same amount.
+ */
+bool Engine::draw_clip(int &dx, int &dy, int &w, int &h, int &sx, int &sy) const
+{
+    dx += area_x_;
+    dy += area_y_;
+    int x0 = std::max({ dx, area_x_, 0 }), y0 = std::max({ dy, area_y_, 0, band_y0_ });
+    int x1 = std::min({ dx + w, area_x_ + area_w_, frame_w_ });
+    int y1 = std::min({ dy + h, area_y_ + area_h_, frame_h_, band_y1_ });
+    if (x0 >= x1 || y0 >= y1)
+        return false;
+    sx += x0 - dx;
+    sy += y0 - dy;
+    dx = x0;
+    dy = y0;
+    w = x1 - x0;
+    h = y1 - y0;
+    return true;
+}
+
+void Engine::draw_patblt(int x, int y, int w, int h)
+{
+    int sx = 0, sy = 0;
+    if (!draw_clip(x, y, w, h, sx, sy))
+        return;
+
+    /*
+     * Opaque fills never touch the destination: no read stage, one
+     * write burst per row.  A blend at alpha 0 leaves it unchanged, so
+     * it is dropped altogether.
+     */
+    uint32_t a = alpha_ == 0xFF ? fcolor_ >> 24 : alpha_;
+    if (blend_ && !a)
+        return;
+    uint64_t stride = (uint64_t)frame_w_ * 4;
+    uint64_t addr = frame_addr_ + y * stride + x * 4;
+    std::vector<uint32_t> row(w, fcolor_);
+
+    perf_[PERF_PAT_PIXELS] += (uint32_t)(w * h);
+    if (blend_)
+        perf_[PERF_BLEND_PIXELS] += (uint32_t)(w * h);
+    for (int i = 0; i < h; i++, addr += stride) {
+        if (blend_) {
+            bus_read(addr, row.data(), w);
+            for (int j = 0; j < w; j++)
+                row[j] = blend_px(fcolor_, row[j], a);
+        }
+        bus_write(addr, row.data(), w);
+    }
+}
+
+/* Bytes per texel row; packed formats pad each row to 32 bits */
+uint64_t Engine::tex_stride() const
+{
+    static const unsigned bytes[] = { 4, 3, 1 };
+    return ((uint64_t)tex_w_ * bytes[tex_fmt_] + 3) & ~3ull;
+}
+
+/*
+ * Texels [x, x + n) of texture row y as ARGB8888.  RGB888 and CLUT8
+ * are expanded here, on the way in, so only the packed bytes cross the
+ * bus; RGB888 comes out opaque, CLUT8 takes alpha from the palette.
+ */
+void Engine::tex_fetch(int x, int y, int n, uint32_t *out)
+{
+    uint64_t row = tex_addr_ + y * tex_stride();
+    if (tex_fmt_ == DRAW_TEX_ARGB8888) {
+        bus_read(row + x * 4, out, n);
+        return;
+    }
+    unsigned bpp = tex_fmt_ == DRAW_TEX_RGB888 ? 3 : 1;
+    std::vector<uint8_t> raw((size_t)n * bpp);
+    mem_read(row + (uint64_t)x * bpp, raw.data(), raw.size());
+    const uint8_t *p = raw.data();
+    for (int i = 0; i < n; i++, p += bpp)
+        out[i] = bpp == 1 ? palette_[p[0]]
+                          : 0xFF000000 | (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+}
+
+/*
+ * Write one row of source texels at @addr.  The destination is read
+ * back just for blending, and then only over the span of texels that
+ * change it: keyed texels and alpha 0 are left out of the
+ * read-modify-write, so a sprite's transparent margins cost no
+ * destination traffic.
+ */
+void Engine::blit_row(uint64_t addr, const uint32_t *src, uint32_t *dst, int w,
+                      uint32_t &keyed, uint32_t &blended)
+{
+    if (stencil_)
+        keyed += (uint32_t)std::count(src, src + w, stcolor_);
+
+    if (blend_) {
+        auto visible = [&](int j) {
+            return !(stencil_ && src[j] == stcolor_) && (alpha_ != 0xFF || src[j] >> 24);
+        };
+        int j0 = 0, j1 = w;
+        while (j0 < j1 && !visible(j0))
+            j0++;
+        while (j1 > j0 && !visible(j1 - 1))
+            j1--;
+        if (j0 == j1)
+            return;
+        bus_read(addr + j0 * 4, &dst[j0], j1 - j0);
+        for (int j = j0; j < j1; j++) {
+            if (visible(j))
+                dst[j] = blend_px(src[j], dst[j], alpha_ == 0xFF ? src[j] >> 24 : alpha_);
+        }
+        bus_write(addr + j0 * 4, &dst[j0], j1 - j0);
+        blended += (uint32_t)(j1 - j0);
+    } else if (stencil_) {
+        /* Write only the runs of non-key texels */
+        for (int j = 0; j < w;) {
+            if (src[j] == stcolor_) {
+                j++;
+                continue;
+            }
+            int k = j + 1;
+            while (k < w && src[k] != stcolor_)
+                k++;
+            bus_write(addr + j * 4, &src[j], k - j);
+            j = k;
+        }
+    } else {
+        bus_write(addr, src, w);
+    }
+}
+
+/* Plain copies are a read of the source and a write of the destination only */
+void Engine::draw_bitblt(int dx, int dy, int w, int h, int sx, int sy)
+{
+    if (!draw_clip(dx, dy, w, h, sx, sy))
+        return;
+    if (blend_ && !alpha_)
+        return;
+
+    /* Source must also lie inside the texture */
+    int cx = std::max(0, -sx), cy = std::max(0, -sy);
+    sx += cx; dx += cx; w -= cx;
+    sy += cy; dy += cy; h -= cy;
+    w = std::min(w, tex_w_ - sx);
+    h = std::min(h, tex_h_ - sy);
+    if (w <= 0 || h <= 0)
+        return;
+
+    uint64_t dstride = (uint64_t)frame_w_ * 4, sstride = tex_stride();
+    uint64_t daddr = frame_addr_ + dy * dstride + dx * 4;
+    uint64_t saddr = tex_addr_ + sy * sstride + sx * 4;
+    std::vector<uint32_t> src(w), dst(w);
+
+    /* Overlapping copy within one surface moving down: go bottom-up */
+    int step = 1, i = 0;
+    if (tex_fmt_ == DRAW_TEX_ARGB8888 && daddr > saddr && daddr < saddr + h * sstride) {
+        step = -1;
+        i = h - 1;
+    }
+    uint32_t keyed = 0, blended = 0;
+    for (int n = 0; n < h; n++, i += step) {
+        tex_fetch(sx, sy + i, w, src.data());
+        blit_row(daddr + i * dstride, src.data(), dst.data(), w, keyed, blended);
+    }
+    perf_[PERF_BLT_PIXELS] += (uint32_t)(w * h) - keyed;
+    perf_[PERF_KEY_PIXELS] += keyed;
+    perf_[PERF_BLEND_PIXELS] += blended;
+}
+
+/* ⌊u / 65536⌋ and the 8-bit fraction left over, for signed 16.16 */
+static int fix_floor(int64_t u, uint32_t &frac)
+{
+    int64_t i = u >= 0 ? u / 0x10000 : -((-u + 0xFFFF) / 0x10000);
+    frac = (uint32_t)(u - i * 0x10000) >> 8;
+    return (int)i;
+}
+
+static uint32_t bilerp_px(uint32_t p00, uint32_t p01, uint32_t p10, uint32_t p11,
+                          uint32_t fx, uint32_t fy)
+{
+    uint32_t w00 = (256 - fx) * (256 - fy), w01 = fx * (256 - fy);
+    uint32_t w10 = (256 - fx) * fy, w11 = fx * fy;
+    uint32_t out = 0;
+    for (int sh = 0; sh < 32; sh += 8) {
+        uint32_t c = ((p00 >> sh) & 0xFF) * w00 + ((p01 >> sh) & 0xFF) * w01 +
+                     ((p10 >> sh) & 0xFF) * w10 + ((p11 >> sh) & 0xFF) * w11;
+        out |= ((c + 0x8000) >> 16) << sh;
+    }
+    return out;
+}
+
+/*
+ * Destination pixel (i, j) of the unclipped rectangle samples the
+ * texture at (sx, sy) + ((j, i) + ½) · (SETSCALE steps), clamped to the
+ * texture edge.  Nearest takes the texel under that point; bilinear
+ * weighs the four around it.  A colour key only makes sense on exact
+ * texels, so with the stencil on the filter is always nearest.
+ *
+ * Each source row is fetched once over the columns the rectangle
+ * needs and kept while consecutive destination rows reuse it (two
+ * line buffers, by row parity, cover both bilinear taps).
+ */
+void Engine::draw_scaleblt(int dx, int dy, int w, int h, int sx, int sy)
+{
+    int ox = 0, oy = 0;     /* destination pixels clipped off left / top */
+    if (!draw_clip(dx, dy, w, h, ox, oy) || !tex_w_ || !tex_h_)
+        return;
+    if (blend_ && !alpha_)
+        return;
+
+    bool bilinear = bilinear_ && !stencil_;
+    int64_t half = bilinear ? 0x8000 : 0;
+    std::vector<int> tx0(w), tx1(w);
+    std::vector<uint32_t> fx(w);
+    for (int j = 0; j < w; j++) {
+        int64_t u = ((int64_t)sx << 16) + (int64_t)(ox + j) * scale_x_ + scale_x_ / 2 - half;
+        int x = fix_floor(u, fx[j]);
+        tx0[j] = std::clamp(x, 0, tex_w_ - 1);
+        tx1[j] = std::clamp(x + 1, 0, tex_w_ - 1);
+    }
+    int lo = tx0[0], hi = bilinear ? tx1[w - 1] : tx0[w - 1];
+    int span = hi - lo + 1;
+
+    std::vector<uint32_t> line[2] = { std::vector<uint32_t>(span), std::vector<uint32_t>(span) };
+    int line_y[2] = { -1, -1 };
+    auto texrow = [&](int y) -> const uint32_t * {
+        if (line_y[y & 1] != y) {
+            tex_fetch(lo, y, span, line[y & 1].data());
+            line_y[y & 1] = y;
+        }
+        return line[y & 1].data();
+    };
+
+    uint64_t dstride = (uint64_t)frame_w_ * 4;
+    uint64_t daddr = frame_addr_ + dy * dstride + dx * 4;
+    std::vector<uint32_t> src(w), dst(w);
+    uint32_t keyed = 0, blended = 0;
+    for (int i = 0; i < h; i++, daddr += dstride) {
+        uint32_t fy;
+        int64_t v = ((int64_t)sy << 16) + (int64_t)(oy + i) * scale_y_ + scale_y_ / 2 - half;
+        int y = fix_floor(v, fy);
+        const uint32_t *r0 = texrow(std::clamp(y, 0, tex_h_ - 1));
+        if (bilinear) {
+            const uint32_t *r1 = texrow(std::clamp(y + 1, 0, tex_h_ - 1));
+            for (int j = 0; j < w; j++)
+                src[j] = bilerp_px(r0[tx0[j] - lo], r0[tx1[j] - lo],
+                                   r1[tx0[j] - lo], r1[tx1[j] - lo], fx[j], fy);
+        } else {
+            for (int j = 0; j < w; j++)
+                src[j] = r0[tx0[j] - lo];
+        }
+        blit_row(daddr, src.data(), dst.data(), w, keyed, blended);
+    }
+    perf_[PERF_BLT_PIXELS] += (uint32_t)(w * h) - keyed;
+    perf_[PERF_KEY_PIXELS] += keyed;
+    perf_[PERF_BLEND_PIXELS] += blended;
+}
+
+/*
+ * Shapes.  Each is broken into horizontal spans that go through the
+ * PATBLT path (draw-area clip, fill colour, blend).  The span rules
+ * are exactly those of source/linux/fb_shape.c, so the CPU fallback
+ * and the engine draw the same pixels.
+ */
+void Engine::draw_line(int x0, int y0, int x1, int y1)
+{
+    int dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+
+    /* Bresenham, one PATBLT per run of pixels sharing a row */
+    int ry = y0, ra = x0, rb = x0;
+    for (int x = x0, y = y0;;) {
+        if (y != ry) {
+            draw_patblt(std::min(ra, rb), ry, std::abs(rb - ra) + 1, 1);
+            ry = y;
+            ra = rb = x;
+        }
+        rb = x;
+        if (x == x1 && y == y1)
+            break;
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+    draw_patblt(std::min(ra, rb), ry, std::abs(rb - ra) + 1, 1);
+}
+
+namespace {
+
+/* x(y) = xa + floor((xb - xa) * (y - ya) / (yb - ya)), one step per row */
+struct Edge {
+    int x = 0, step = 0, rem = 0, err = 0, dy = 0;
+
+    Edge(int xa, int ya, int xb, int yb) : x(xa), dy(yb - ya)
+    {
+        if (dy <= 0)
+            return;
+        step = (xb - xa) / dy;
+        rem = (xb - xa) % dy;
+        if (rem < 0) {
+            step--;
+            rem += dy;
+        }
+    }
+    void next()
+    {
+        x += step;
+        err += rem;
+        if (err >= dy && dy > 0) {
+            x++;
+            err -= dy;
+        }
+    }
+};
+
+} // namespace
+
+void Engine::draw_triangle(int x0, int y0, int x1, int y1, int x2, int y2)
+{
+    if (y1 < y0) { std::swap(x0, x1); std::swap(y0, y1); }
+    if (y2 < y0) { std::swap(x0, x2); std::swap(y0, y2); }
+    if (y2 < y1) { std::swap(x1, x2); std::swap(y1, y2); }
+
+    /* Degenerate: all three on one row, the edges would only see x0, x1 */
+    if (y0 == y2) {
+        int a = std::min({x0, x1, x2}), b = std::max({x0, x1, x2});
+        draw_patblt(a, y0, b - a + 1, 1);
+        return;
+    }
+
+    Edge lng(x0, y0, x2, y2), shr(x0, y0, x1, y1);
+    for (int y = y0; y <= y2; y++) {
+        if (y == y1)
+            shr = Edge(x1, y1, x2, y2);
+        /* Floor on the left, ceil on the right */
+        int a = lng.x, b = shr.x;
+        if (a <= b)
+            draw_patblt(a, y, b + (shr.err != 0) - a + 1, 1);
+        else
+            draw_patblt(b, y, a + (lng.err != 0) - b + 1, 1);
+        lng.next();
+        shr.next();
+    }
+}
+
+/* Every (x, y) with x²·ry² + y²·rx² <= rx²·ry², walked out from the centre */
+void Engine::draw_ellipse(int cx, int cy, int rx, int ry)
+{
+    int64_t a2 = (int64_t)rx * rx, b2 = (int64_t)ry * ry, lim = a2 * b2;
+    int x = rx;
+    for (int dy = 0; dy <= ry; dy++) {
+        int64_t yy = a2 * dy * dy;
+        while (x > 0 && b2 * x * x + yy > lim)
+            x--;
+        draw_patblt(cx - x, cy - dy, 2 * x + 1, 1);
+        if (dy)
+            draw_patblt(cx - x, cy + dy, 2 * x + 1, 1);
+    }
+}
+
+/*
+ * Two-colour linear gradient over the whole (w, h) rectangle, left to
+ * right or top to bottom; clipping does not shift the ramp.  Channel i
+ * of n is (c0·(n-1-i) + c1·i) / (n-1), rounded.
+ */
+static uint32_t lerp_px(uint32_t c0, uint32_t c1, uint32_t i, uint32_t n)
+{
+    if (n < 2)
+        return c0;
+    uint32_t out = 0;
+    for (int sh = 0; sh < 32; sh += 8) {
+        uint32_t a = (c0 >> sh) & 0xFF, b = (c1 >> sh) & 0xFF;
+        out |= ((a * (n - 1 - i) + b * i + (n - 1) / 2) / (n - 1)) << sh;
+    }
+    return out;
+}
+
+void Engine::draw_gradient(int x, int y, int w, int h, uint32_t c0, uint32_t c1, bool vertical)
+{
+    uint32_t n = vertical ? (uint32_t)h : (uint32_t)w;
+    int sx = 0, sy = 0;             /* clipped offset into the ramp */
+    if (!draw_clip(x, y, w, h, sx, sy))
+        return;
+
+    uint64_t stride = (uint64_t)frame_w_ * 4;
+    uint64_t addr = frame_addr_ + y * stride + x * 4;
+    std::vector<uint32_t> ramp(w), row(w);
+    if (!vertical)
+        for (int j = 0; j < w; j++)
+            ramp[j] = lerp_px(c0, c1, sx + j, n);
+
+    perf_[PERF_PAT_PIXELS] += (uint32_t)(w * h);
+    if (blend_)
+        perf_[PERF_BLEND_PIXELS] += (uint32_t)(w * h);
+    for (int i = 0; i < h; i++, addr += stride) {
+        if (vertical)
+            std::fill(ramp.begin(), ramp.end(), lerp_px(c0, c1, sy + i, n));
+        if (blend_) {
+            bus_read(addr, row.data(), w);
+            for (int j = 0; j < w; j++)
+                row[j] = blend_px(ramp[j], row[j], alpha_ == 0xFF ? ramp[j] >> 24 : alpha_);
+            bus_write(addr, row.data(), w);
+        } else {
+            bus_write(addr, ramp.data(), w);
+        }
+    }
+}
+
+} // namespace draw_tlm
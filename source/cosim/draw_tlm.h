@@ -0,0 +1,363 @@
+/*
+ * draw_tlm.h — Transaction-level model of the VirtIO-GPU Draw Engine
+ *
+ * Functional stand-in for the Verilator build (lib/libVtop_virtio.so):
+ * the same 64 KiB register window, the same two interrupt lines and the
+ * same memory-side behaviour, but every command is executed as a whole
+ * instead of being clocked through the RTL pipeline and AXI handshakes.
+ *
+ * Register window (offsets from 0x8200_0000):
+ *   0x0000  VirtIO MMIO v2 transport, device ID 16 (GPU), config @0x100
+ *   0x1000  Debug registers (see DBG_*)
+ *   0x2000  Legacy Draw Engine registers, same layout as draw_dl.h
+ *
+ * The GPU side implements the 2D subset virtio-gpu.ko uses for fbdev
+ * and KMS dumb buffers: resources live in host memory, TRANSFER_TO_HOST_2D
+ * pulls from the guest backing and RESOURCE_FLUSH writes the scanout
+ * resource into the litex_video region as ARGB8888.  With
+ * VIRTIO_GPU_F_RESOURCE_BLOB, dumb buffers are guest blobs instead and
+ * SET_SCANOUT_BLOB can point the scanout (DBG_FB_ADDR) straight at one.
+ * The cursor queue keeps a 64x64 ARGB overlay that is blended in
+ * whenever scanout pixels are written, so moving it only rewrites the
+ * two cursor boxes.
+ *
+ * The legacy side decodes the display-list commands from draw_dl.h and
+ * runs PATBLT / BITBLT (blend, stencil key) and the shape commands
+ * (line, triangle, ellipse, gradient) row by row on guest memory.
+ * Textures may be ARGB8888, RGB888 or CLUT8 (palette loaded by
+ * SETPALETTE); texels are converted as they are fetched, and SCALEBLT
+ * resamples them with 16.16 steps, nearest or bilinear.  Drawing
+ * commands can be split over several modelled pipelines by rows
+ * (DRAWPIPES); the split only changes the PERF_CYCLES estimate.
+ * Commands come from the DRAWCMD FIFO, or, once DRAWRINGSIZE is set,
+ * are fetched from a ring in guest memory (JUMP / CALL / RET chain
+ * lists, EODL writes a completion marker to DRAWRINGDONE).
+ *
+ * Nothing here depends on Renode; sim_main_tlm.cpp adapts it to the
+ * co-simulation ABI, and host tools can drive it with any Bus.
+ */
+#ifndef DRAW_TLM_H
+#define DRAW_TLM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace draw_tlm {
+
+/* ── Register map ─────────────────────────────────────────── */
+constexpr uint32_t VIRTIO_BASE       = 0x0000;
+constexpr uint32_t DBG_BASE          = 0x1000;
+constexpr uint32_t DRAW_BASE         = 0x2000;
+constexpr uint32_t WINDOW_MASK       = 0xFFFF;
+
+/* Debug registers (offsets from DBG_BASE) */
+constexpr uint32_t DBG_STATE         = 0x00;   /* bit0 draw busy, bit1 DRIVER_OK */
+constexpr uint32_t DBG_LAST_CMD      = 0x04;   /* last control-queue type */
+constexpr uint32_t DBG_LAST_RESP     = 0x08;   /* last response type */
+constexpr uint32_t DBG_BACKING0      = 0x0C;   /* scanout resource, 1st backing addr */
+constexpr uint32_t DBG_CMD_CNT       = 0x10;   /* control-queue commands completed */
+constexpr uint32_t DBG_FB_ADDR       = 0x14;   /* scanout base, 0 when disabled */
+constexpr uint32_t DBG_WXH           = 0x18;   /* scanout {WIDTH, HEIGHT} */
+constexpr uint32_t DBG_SNAPSHOT      = 0x1C;   /* W: 1 save, 2 restore; R: 1 = last failed */
+
+constexpr uint32_t SNAPSHOT_SAVE     = 1;
+constexpr uint32_t SNAPSHOT_RESTORE  = 2;
+
+/*
+ * Performance counters in the legacy window (offsets from DRAW_BASE).
+ * Free-running u32s, wrapping; PERFCTRL bit0 (write 1) clears them all.
+ * Beats/bursts count every engine memory access, VirtIO included.
+ */
+constexpr uint32_t DRAW_REG_PERFCTRL = 0x100;
+constexpr uint32_t DRAW_REG_PERF     = 0x104;  /* + 4 * PERF_* */
+constexpr uint32_t DRAW_PERF_CLEAR   = 1u << 0;
+
+enum {
+    PERF_CMDS,          /* display-list commands executed */
+    PERF_LISTS,         /* display lists completed (EODL) */
+    PERF_FIFO_FULL,     /* DRAWCMD writes dropped on a full FIFO */
+    PERF_FIFO_EMPTY,    /* ticks that ran the FIFO dry before EODL */
+    PERF_RD_BEATS,      /* 32-bit memory reads */
+    PERF_WR_BEATS,      /* 32-bit memory writes */
+    PERF_RD_BURSTS,     /* read transactions */
+    PERF_WR_BURSTS,     /* write transactions */
+    PERF_PAT_PIXELS,    /* PATBLT and shape pixels written */
+    PERF_BLT_PIXELS,    /* BITBLT pixels written */
+    PERF_BLEND_PIXELS,  /* pixels blended (destination read back) */
+    PERF_KEY_PIXELS,    /* texels dropped by the stencil key */
+    PERF_XFER_PIXELS,   /* TRANSFER_TO_HOST_2D pixels */
+    PERF_FLUSH_PIXELS,  /* RESOURCE_FLUSH pixels written to the scanout */
+    PERF_VIRTQ_BUFS,    /* virtqueue buffers completed (used-ring entries) */
+    PERF_VIRTQ_IRQS,    /* used-buffer interrupts raised */
+    PERF_BANDS,         /* per-pipeline bands drawing commands were split into */
+    PERF_CYCLES,        /* estimated execution clocks (see DRAW_AXI_LATENCY) */
+    PERF_NUM
+};
+
+/* Legacy DRAWINT read-back: bit2 reports a pending (uncleared) DRW_IRQ */
+constexpr uint32_t DRAW_INT_PENDING  = 1u << 2;
+
+/* DRAWCAPS: optional features the model implements (RTL reads 0) */
+constexpr uint32_t DRAW_CAPS_RING    = 1u << 0;   /* DRAWRING*, JUMP / CALL / RET */
+constexpr uint32_t DRAW_CAPS_SHAPES  = 1u << 1;   /* LINE, TRIANGLE, ELLIPSE, GRADIENT */
+constexpr uint32_t DRAW_CAPS_TEXFMT  = 1u << 2;   /* RGB888 / CLUT8, SETPALETTE, SCALEBLT */
+constexpr uint32_t DRAW_CAPS_PIPES   = 1u << 3;   /* DRAWPIPES, band-split dispatch */
+
+/* SETTEXTURE [1:0]: texel format; packed rows start on a 32-bit boundary */
+constexpr uint32_t DRAW_TEX_ARGB8888 = 0;
+constexpr uint32_t DRAW_TEX_RGB888   = 1;         /* bytes R, G, B */
+constexpr uint32_t DRAW_TEX_CLUT8    = 2;         /* index into the SETPALETTE table */
+
+/* DRAWSTAT error codes ([18:16]) */
+constexpr uint32_t DRAW_ERR_OPCODE   = 1;
+constexpr uint32_t DRAW_ERR_NOFRAME  = 2;
+constexpr uint32_t DRAW_ERR_STACK    = 3;  /* CALL too deep / RET at top level */
+constexpr uint32_t DRAW_ERR_FORMAT   = 4;  /* SETTEXTURE with an unknown texel format */
+
+/*
+ * Pipelines.  Every pipeline has one AXI burst outstanding and waits
+ * out its latency; the shared master moves one beat per clock.  A
+ * command takes max(busiest pipeline, total beats) clocks.  The latency
+ * is a nominal figure for the estimate, not a measurement of the RTL.
+ */
+constexpr unsigned DRAW_PIPES_MAX    = 8;
+constexpr unsigned DRAW_AXI_LATENCY  = 16;     /* clocks per burst */
+
+/* Display-list ring fetch */
+constexpr unsigned DRAW_CALL_DEPTH   = 4;
+constexpr unsigned DRAW_FETCH_WORDS  = 64;     /* prefetch burst */
+constexpr unsigned DRAW_RING_BUDGET  = 1u << 16; /* commands per tick */
+
+/* Scanout: the litex_video framebuffer the viewer and fb_tux use */
+constexpr uint64_t SCANOUT_ADDR      = 0x43E00000;
+constexpr uint32_t SCANOUT_WIDTH     = 640;
+constexpr uint32_t SCANOUT_HEIGHT    = 480;
+
+/* Cursor plane (virtqueue 1), composited into the scanout */
+constexpr uint32_t CURSOR_SIZE       = 64;
+
+constexpr unsigned DRAW_FIFO_DEPTH   = 1024;
+constexpr unsigned VIRTQ_NUM_MAX     = 256;
+
+/*
+ * Guest memory as seen from the engine's AXI master.  Only the word
+ * accessors are required; the block forms default to word loops and
+ * exist so a transport that can move whole rows overrides just those.
+ */
+class Bus {
+public:
+    virtual ~Bus() = default;
+    virtual uint32_t read32(uint64_t addr) = 0;
+    virtual void write32(uint64_t addr, uint32_t value) = 0;
+    virtual void read(uint64_t addr, uint32_t *dst, size_t words);
+    virtual void write(uint64_t addr, const uint32_t *src, size_t words);
+};
+
+class Engine {
+public:
+    explicit Engine(Bus &mem);
+
+    void reset();
+
+    /* Register window; @off is masked to the 64 KiB window */
+    uint32_t mmio_read(uint32_t off);
+    void mmio_write(uint32_t off, uint32_t value);
+
+    /*
+     * Advance the model.  Pending virtqueue notifications and the
+     * legacy display list are run to completion regardless of @cycles;
+     * the argument only exists to mirror the RTL bus tick.
+     */
+    void tick(uint64_t cycles);
+
+    /*
+     * Complete model state (transport, resources, display list), for
+     * pairing with a Renode machine snapshot.  The guest triggers these
+     * through DBG_SNAPSHOT using the file set with set_snapshot_path().
+     */
+    bool save(std::ostream &out) const;
+    bool load(std::istream &in);
+    void set_snapshot_path(const std::string &path) { snapshot_path_ = path; }
+
+    /* Pipelines instantiated (1 … DRAW_PIPES_MAX); all are used until DRAWPIPES says otherwise */
+    void set_pipes(unsigned n);
+
+    bool virtio_irq() const { return int_status_ != 0; }
+    bool draw_irq() const { return draw_int_enbl_ && draw_int_pending_; }
+
+private:
+    void snapshot(uint32_t op);
+
+    /* ── Guest memory helpers (all engine traffic, counted) ── */
+    uint32_t bus_read32(uint64_t addr);
+    void bus_write32(uint64_t addr, uint32_t value);
+    void bus_read(uint64_t addr, uint32_t *dst, size_t words);
+    void bus_write(uint64_t addr, const uint32_t *src, size_t words);
+    void mem_read(uint64_t addr, void *dst, size_t len);
+    void mem_write(uint64_t addr, const void *src, size_t len);
+    uint16_t mem_read16(uint64_t addr);
+
+    /* ── VirtIO transport ── */
+    struct Queue {
+        uint32_t num = 0;
+        bool     ready = false;
+        uint64_t desc = 0, avail = 0, used = 0;
+        uint16_t last_avail = 0;
+        uint16_t used_idx = 0;
+        bool     notified = false;
+    };
+    struct Segment {
+        uint64_t addr;
+        uint32_t len;
+    };
+
+    uint32_t virtio_read(uint32_t off);
+    void virtio_write(uint32_t off, uint32_t value);
+    void virtio_reset();
+    void virtq_process(unsigned qi);
+
+    /* ── GPU command set ── */
+    struct Resource {
+        uint32_t format = 0, width = 0, height = 0;
+        std::vector<uint32_t> pixels;       /* host copy; empty for blobs */
+        std::vector<Segment>  backing;
+        std::vector<uint64_t> backing_end;  /* running entry ends, not saved */
+
+        /* Guest blob (RESOURCE_CREATE_BLOB): layout from SET_SCANOUT_BLOB */
+        bool     blob = false;
+        uint64_t blob_size = 0;
+        uint32_t stride = 0;
+        uint64_t offset = 0;
+
+        void index_backing()
+        {
+            uint64_t end = 0;
+            backing_end.clear();
+            for (const Segment &s : backing)
+                backing_end.push_back(end += s.len);
+        }
+    };
+
+    uint32_t gpu_ctrl(const std::vector<uint8_t> &req, std::vector<uint8_t> &resp);
+    void gpu_cursor(const std::vector<uint8_t> &req);
+    void cursor_refresh();
+    bool scanout_direct() const { return scanout_base_ && !cursor_.visible; }
+    void resource_row(const Resource &res, uint64_t x, uint64_t y, uint32_t *dst, size_t n);
+    void backing_read(const Resource &res, uint64_t off, uint32_t *dst, size_t words);
+    uint64_t backing_contig(const Resource &res, uint64_t off, uint64_t len) const;
+    void scanout_flush(const Resource &res, uint32_t x, uint32_t y,
+                       uint32_t w, uint32_t h);
+
+    /* ── Legacy Draw Engine ── */
+    uint32_t draw_read(uint32_t off);
+    void draw_write(uint32_t off, uint32_t value);
+    void draw_reset();
+    void draw_run();
+    void ring_run();
+    bool ring_fetch(uint32_t *w);
+    uint32_t ring_word(unsigned k);
+    void ring_goto(uint64_t addr);
+    bool draw_exec(const uint32_t *w);
+    void draw_stop(uint32_t err);
+    void draw_patblt(int x, int y, int w, int h);
+    void draw_bitblt(int dx, int dy, int w, int h, int sx, int sy);
+    void draw_scaleblt(int dx, int dy, int w, int h, int sx, int sy);
+    void blit_row(uint64_t addr, const uint32_t *src, uint32_t *dst, int w,
+                  uint32_t &keyed, uint32_t &blended);
+    uint64_t tex_stride() const;
+    void tex_fetch(int x, int y, int n, uint32_t *out);
+    void draw_line(int x0, int y0, int x1, int y1);
+    void draw_triangle(int x0, int y0, int x1, int y1, int x2, int y2);
+    void draw_ellipse(int cx, int cy, int rx, int ry);
+    void draw_gradient(int x, int y, int w, int h, uint32_t c0, uint32_t c1, bool vertical);
+    void draw_dispatch(const uint32_t *w);
+    void draw_op(const uint32_t *w);
+    bool draw_rows(const uint32_t *w, int &y0, int &y1) const;
+    bool draw_clip(int &dx, int &dy, int &w, int &h, int &sx, int &sy) const;
+
+    Bus *mem_;
+
+    /* VirtIO MMIO state */
+    uint32_t status_ = 0;
+    uint32_t dev_features_sel_ = 0, drv_features_sel_ = 0;
+    uint64_t drv_features_ = 0;
+    uint32_t queue_sel_ = 0;
+    uint32_t int_status_ = 0;
+    Queue    queue_[2];
+
+    /* GPU state */
+    std::map<uint32_t, Resource> resources_;
+    uint32_t scanout_res_ = 0;
+    uint64_t scanout_base_ = 0;         /* zero-copy blob scanout, 0: SCANOUT_ADDR */
+    uint32_t scanout_x_ = 0, scanout_y_ = 0, scanout_w_ = 0, scanout_h_ = 0;
+    uint32_t last_cmd_ = 0, last_resp_ = 0, cmd_cnt_ = 0;
+
+    struct Cursor {
+        bool     visible = false;
+        int32_t  x = 0, y = 0;          /* hotspot, scanout coordinates */
+        uint32_t hot_x = 0, hot_y = 0;
+        std::vector<uint32_t> image;    /* CURSOR_SIZE², ARGB8888 */
+    } cursor_;
+
+    uint32_t perf_[PERF_NUM] = {};
+
+    std::string snapshot_path_;
+    bool     snapshot_failed_ = false;
+
+    /* Draw Engine state */
+    std::deque<uint32_t> fifo_;
+    bool     busy_ = false;
+    uint32_t err_ = 0;
+    bool     draw_int_enbl_ = false, draw_int_pending_ = false;
+    uint64_t frame_addr_ = 0;
+    int      frame_w_ = 0, frame_h_ = 0;
+    int      area_x_ = 0, area_y_ = 0, area_w_ = 0, area_h_ = 0;
+    uint64_t tex_addr_ = 0;
+    int      tex_w_ = 0, tex_h_ = 0;
+    uint32_t tex_fmt_ = DRAW_TEX_ARGB8888;
+    uint32_t palette_[256] = {};
+    uint32_t scale_x_ = 0x10000, scale_y_ = 0x10000;   /* SCALEBLT steps, 16.16 */
+    bool     bilinear_ = false;
+    uint32_t fcolor_ = 0, stcolor_ = 0;
+    bool     stencil_ = false, blend_ = false;
+    uint32_t alpha_ = 0xFF;
+
+    /*
+     * Band split: while a drawing command runs on pipeline pipe_, the
+     * clip is narrowed to rows [band_y0_, band_y1_) and its bus traffic
+     * is charged to load_[pipe_].
+     */
+    struct PipeLoad {
+        uint64_t beats, bursts;
+    };
+    unsigned pipes_ = 1, pipes_active_ = 1;
+    unsigned pipe_ = 0;
+    int      band_y0_ = 0, band_y1_ = INT32_MAX;
+    PipeLoad load_[DRAW_PIPES_MAX] = {};
+
+    /*
+     * Display-list ring.  While fetching from the ring the read pointer
+     * is ring_head_; a JUMP or CALL out of it continues at dl_addr_ and
+     * leaves ring_head_ just past the chaining command.
+     */
+    struct DlReturn {
+        uint64_t addr;                  /* ring: ring_head_ to restore */
+        uint32_t ring, pad;
+    };
+    uint64_t ring_base_ = 0, ring_done_ = 0;
+    uint32_t ring_size_ = 0, ring_head_ = 0, ring_tail_ = 0;
+    bool     dl_ring_ = true;
+    uint64_t dl_addr_ = 0;
+    std::vector<DlReturn> dl_stack_;
+    uint64_t fetch_addr_ = 0;           /* prefetch buffer, not saved */
+    std::vector<uint32_t> fetch_;
+};
+
+} // namespace draw_tlm
+
+#endif /* DRAW_TLM_H */
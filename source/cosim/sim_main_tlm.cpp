@@ -0,0 +1,189 @@
+/*
+ * sim_main_tlm.cpp — Renode co-simulation glue for the Draw Engine TLM
+ *
+ * Drop-in replacement for the Verilator wrapper behind
+ * lib/libVtop_virtio.so: same Init() entry point, same interrupt
+ * numbering, so platform_virtio.repl and the resc scripts are unchanged
+ * apart from SimulationFilePathLinux.
+ *
+ *   registerInterrupt(VIRTIO_IRQ, 2) → cosim GPIO 2 → plic@1
+ *   registerInterrupt(DRW_IRQ, 3)    → cosim GPIO 3 → plic@2
+ *
+ * Register accesses arrive as target-bus reads/writes; the model's
+ * memory traffic goes back to Renode as agent requests.  Block
+ * transfers are framed the way the RTL's AXI4 master issues them
+ * (INCR, at most 256 beats, never across a 4 KiB boundary); the
+ * burst/beat counts logged on reset show what a bulk transport saves.
+ * Writes are posted; only reads wait for Renode.  This version of the
+ * integration library has no bulk action, so each burst still crosses
+ * as one message per beat; transfer_read()/transfer_write() are where
+ * a ReadBytes/WriteBytes message would go.
+ *
+ * Renode's Save/Load cannot see inside a native library, so the model
+ * state is checkpointed separately: writing DBG_SNAPSHOT saves it to
+ * $DRAW_TLM_SNAPSHOT (default /tmp/draw_tlm.state) or restores it.
+ *
+ * $DRAW_TLM_PIPES (1..8, default 1) sets how many drawing pipelines the
+ * model offers through DRAWPIPES; it only changes the PERF_CYCLES
+ * estimate, never the pixels.
+ */
+#include <algorithm>
+#include <cstdlib>
+
+#include "renode_bus.h"
+
+#include "draw_tlm.h"
+
+static uint8_t virtio_irq;
+static uint8_t draw_irq;
+
+class AgentMemory : public draw_tlm::Bus {
+public:
+    static constexpr uint64_t AXI_MAX_BEATS = 256;
+    static constexpr uint64_t AXI_BOUNDARY  = 4096;
+
+    RenodeAgent *agent = nullptr;
+    uint64_t read_bursts = 0, read_beats = 0;
+    uint64_t write_bursts = 0, write_beats = 0;
+
+    uint32_t read32(uint64_t addr) override
+    {
+        read_bursts++;
+        read_beats++;
+        return (uint32_t)agent->requestDoubleWordFromAgent(addr);
+    }
+    void write32(uint64_t addr, uint32_t value) override
+    {
+        write_bursts++;
+        write_beats++;
+        agent->pushDoubleWordToAgent(addr, value);
+    }
+
+    void read(uint64_t addr, uint32_t *dst, size_t words) override
+    {
+        while (words) {
+            size_t n = burst_beats(addr, words);
+            transfer_read(addr, dst, n);
+            addr += 4 * n;
+            dst += n;
+            words -= n;
+        }
+    }
+    void write(uint64_t addr, const uint32_t *src, size_t words) override
+    {
+        while (words) {
+            size_t n = burst_beats(addr, words);
+            transfer_write(addr, src, n);
+            addr += 4 * n;
+            src += n;
+            words -= n;
+        }
+    }
+
+    void reset_stats()
+    {
+        read_bursts = read_beats = write_bursts = write_beats = 0;
+    }
+
+private:
+    static size_t burst_beats(uint64_t addr, size_t words)
+    {
+        uint64_t to_boundary = (AXI_BOUNDARY - (addr & (AXI_BOUNDARY - 1))) / 4;
+        return (size_t)std::min<uint64_t>({ words, AXI_MAX_BEATS, to_boundary });
+    }
+
+    void transfer_read(uint64_t addr, uint32_t *dst, size_t beats)
+    {
+        read_bursts++;
+        read_beats += beats;
+        for (size_t i = 0; i < beats; i++)
+            dst[i] = (uint32_t)agent->requestDoubleWordFromAgent(addr + 4 * i);
+    }
+    void transfer_write(uint64_t addr, const uint32_t *src, size_t beats)
+    {
+        write_bursts++;
+        write_beats += beats;
+        for (size_t i = 0; i < beats; i++)
+            agent->pushDoubleWordToAgent(addr + 4 * i, src[i]);
+    }
+};
+
+class TlmTarget : public BaseTargetBus {
+public:
+    TlmTarget() : engine(memory)
+    {
+        /* DBG_SNAPSHOT file, paired with a Renode Save/Load */
+        const char *path = getenv("DRAW_TLM_SNAPSHOT");
+        engine.set_snapshot_path(path ? path : "/tmp/draw_tlm.state");
+
+        const char *pipes = getenv("DRAW_TLM_PIPES");
+        if (pipes)
+            engine.set_pipes((unsigned)strtoul(pipes, nullptr, 0));
+    }
+
+    void setAgent(RenodeAgent *a)
+    {
+        BaseBus::setAgent(a);
+        memory.agent = a;
+    }
+
+    void write(int, uint64_t addr, uint64_t value)
+    {
+        engine.mmio_write((uint32_t)addr, (uint32_t)value);
+        sync_irqs();
+    }
+
+    uint64_t read(int, uint64_t addr)
+    {
+        return engine.mmio_read((uint32_t)addr);
+    }
+
+    void tick(bool countEnable, uint64_t steps)
+    {
+        if (!countEnable)
+            return;
+        engine.tick(steps);
+        sync_irqs();
+    }
+
+    void timeoutTick(uint8_t *, uint8_t, int) {}
+
+    void reset()
+    {
+        if (memory.read_beats || memory.write_beats)
+            memory.agent->log(1, "draw_tlm: read %llu bursts / %llu beats, "
+                             "write %llu bursts / %llu beats",
+                             (unsigned long long)memory.read_bursts,
+                             (unsigned long long)memory.read_beats,
+                             (unsigned long long)memory.write_bursts,
+                             (unsigned long long)memory.write_beats);
+        memory.reset_stats();
+        engine.reset();
+        sync_irqs();
+    }
+
+    bool areSignalsConnected() { return true; }
+
+private:
+    void sync_irqs()
+    {
+        virtio_irq = engine.virtio_irq();
+        draw_irq = engine.draw_irq();
+    }
+
+    AgentMemory       memory;
+    draw_tlm::Engine  engine;
+};
+
+RenodeAgent *Init()
+{
+    RenodeAgent *agent = new RenodeAgent();
+    TlmTarget *bus = new TlmTarget();
+
+    agent->addBus(bus);
+    bus->setAgent(agent);
+
+    agent->registerInterrupt(&virtio_irq, 2);
+    agent->registerInterrupt(&draw_irq, 3);
+    return agent;
+}
@@ -0,0 +1,498 @@
+/*
+ * draw_dl.c — Draw Engine native display-list builder + UIO submission
+ *
+ * See draw_dl.h for the register map and command encoding.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "draw_dl.h"
+
+/* ── Display list buffer ──────────────────────────────────── */
+void draw_dl_init(struct draw_dl *dl)
+{
+    memset(dl, 0, sizeof(*dl));
+}
+
+void draw_dl_free(struct draw_dl *dl)
+{
+    free(dl->words);
+    memset(dl, 0, sizeof(*dl));
+}
+
+void draw_dl_reset(struct draw_dl *dl)
+{
+    dl->len = 0;
+    dl->oom = 0;
+}
+
+static void dl_emit(struct draw_dl *dl, uint32_t word)
+{
+    if (dl->len == dl->cap) {
+        size_t ncap = dl->cap ? dl->cap * 2 : 256;
+        uint32_t *nw = realloc(dl->words, ncap * sizeof(*nw));
+        if (!nw) {
+            dl->oom = 1;
+            return;
+        }
+        dl->words = nw;
+        dl->cap = ncap;
+    }
+    dl->words[dl->len++] = word;
+}
+
+/* ── State-setting commands ───────────────────────────────── */
+void draw_dl_setframe(struct draw_dl *dl, uint32_t addr, int w, int h)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SETFRAME, 0));
+    dl_emit(dl, addr);
+    dl_emit(dl, DRAW_XY(w, h));
+}
+
+void draw_dl_setdrawarea(struct draw_dl *dl, int x, int y, int w, int h)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SETDRAWAREA, 0));
+    dl_emit(dl, DRAW_XY(x, y));
+    dl_emit(dl, DRAW_XY(w, h));
+}
+
+void draw_dl_settexture(struct draw_dl *dl, uint32_t addr, int w, int h)
+{
+    draw_dl_settexture_fmt(dl, addr, w, h, DRAW_TEX_ARGB8888);
+}
+
+void draw_dl_settexture_fmt(struct draw_dl *dl, uint32_t addr, int w, int h,
+                            int fmt)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SETTEXTURE, fmt & 3));
+    dl_emit(dl, addr);
+    dl_emit(dl, DRAW_XY(w, h));
+}
+
+void draw_dl_setfcolor(struct draw_dl *dl, uint32_t argb)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SETFCOLOR, 0));
+    dl_emit(dl, argb);
+}
+
+void draw_dl_setstcolor(struct draw_dl *dl, uint32_t argb)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SETSTCOLOR, 0));
+    dl_emit(dl, argb);
+}
+
+void draw_dl_setstmode(struct draw_dl *dl, int enable)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SETSTMODE, enable ? 1 : 0));
+}
+
+void draw_dl_setblendalpha(struct draw_dl *dl, uint8_t alpha)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SETBLENDALPHA, alpha));
+}
+
+void draw_dl_setblendoff(struct draw_dl *dl)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SETBLENDOFF, 0));
+}
+
+/* ── Drawing execution commands ───────────────────────────── */
+void draw_dl_patblt(struct draw_dl *dl, int x, int y, int w, int h)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    dl_emit(dl, DRAW_CMD(DRAW_OP_PATBLT, 0));
+    dl_emit(dl, DRAW_XY(x, y));
+    dl_emit(dl, DRAW_XY(w, h));
+}
+
+void draw_dl_bitblt(struct draw_dl *dl, int dx, int dy, int w, int h,
+                    int sx, int sy)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    dl_emit(dl, DRAW_CMD(DRAW_OP_BITBLT, 0));
+    dl_emit(dl, DRAW_XY(dx, dy));
+    dl_emit(dl, DRAW_XY(w, h));
+    dl_emit(dl, DRAW_XY(sx, sy));
+}
+
+/* ── Texture formats and scaling ──────────────────────────── */
+void draw_dl_setpalette(struct draw_dl *dl, uint32_t addr, int entries)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SETPALETTE, entries & 0x1FF));
+    dl_emit(dl, addr);
+}
+
+void draw_dl_setscale(struct draw_dl *dl, uint32_t step_x, uint32_t step_y,
+                      int bilinear)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SETSCALE, bilinear ? DRAW_SCALE_BILINEAR : 0));
+    dl_emit(dl, step_x);
+    dl_emit(dl, step_y);
+}
+
+void draw_dl_scaleblt(struct draw_dl *dl, int dx, int dy, int w, int h,
+                      int sx, int sy)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    dl_emit(dl, DRAW_CMD(DRAW_OP_SCALEBLT, 0));
+    dl_emit(dl, DRAW_XY(dx, dy));
+    dl_emit(dl, DRAW_XY(w, h));
+    dl_emit(dl, DRAW_XY(sx, sy));
+}
+
+/* ── Shape commands ───────────────────────────────────────── */
+void draw_dl_line(struct draw_dl *dl, int x0, int y0, int x1, int y1)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_LINE, 0));
+    dl_emit(dl, DRAW_XY(x0, y0));
+    dl_emit(dl, DRAW_XY(x1, y1));
+}
+
+void draw_dl_triangle(struct draw_dl *dl, int x0, int y0, int x1, int y1,
+                      int x2, int y2)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_TRIANGLE, 0));
+    dl_emit(dl, DRAW_XY(x0, y0));
+    dl_emit(dl, DRAW_XY(x1, y1));
+    dl_emit(dl, DRAW_XY(x2, y2));
+}
+
+void draw_dl_ellipse(struct draw_dl *dl, int cx, int cy, int rx, int ry)
+{
+    if (rx < 0 || ry < 0)
+        return;
+    dl_emit(dl, DRAW_CMD(DRAW_OP_ELLIPSE, 0));
+    dl_emit(dl, DRAW_XY(cx, cy));
+    dl_emit(dl, DRAW_XY(rx, ry));
+}
+
+void draw_dl_gradient(struct draw_dl *dl, int x, int y, int w, int h,
+                      uint32_t from, uint32_t to, int vertical)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    dl_emit(dl, DRAW_CMD(DRAW_OP_GRADIENT, vertical ? DRAW_GRAD_VERTICAL : 0));
+    dl_emit(dl, DRAW_XY(x, y));
+    dl_emit(dl, DRAW_XY(w, h));
+    dl_emit(dl, from);
+    dl_emit(dl, to);
+}
+
+/* ── Control commands ─────────────────────────────────────── */
+void draw_dl_nop(struct draw_dl *dl)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_NOP, 0));
+}
+
+void draw_dl_eodl(struct draw_dl *dl)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_EODL, 0));
+}
+
+void draw_dl_jump(struct draw_dl *dl, uint32_t addr)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_JUMP, 0));
+    dl_emit(dl, addr);
+}
+
+void draw_dl_call(struct draw_dl *dl, uint32_t addr)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_CALL, 0));
+    dl_emit(dl, addr);
+}
+
+void draw_dl_ret(struct draw_dl *dl)
+{
+    dl_emit(dl, DRAW_CMD(DRAW_OP_RET, 0));
+}
+
+/* ── Device (UIO) ─────────────────────────────────────────── */
+static inline uint32_t reg_rd(struct draw_dev *dev, unsigned off)
+{
+    return dev->regs[off / 4];
+}
+
+static inline void reg_wr(struct draw_dev *dev, unsigned off, uint32_t v)
+{
+    dev->regs[off / 4] = v;
+}
+
+int draw_dev_open(struct draw_dev *dev, const char *uio_path)
+{
+    dev->fd = open(uio_path ? uio_path : "/dev/uio0", O_RDWR);
+    if (dev->fd < 0) {
+        perror(uio_path ? uio_path : "/dev/uio0");
+        return -1;
+    }
+    /* UIO map 0 = the 4 KiB legacy register window */
+    void *p = mmap(NULL, DRAW_REG_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_SHARED, dev->fd, 0);
+    if (p == MAP_FAILED) {
+        perror("mmap uio");
+        close(dev->fd);
+        dev->fd = -1;
+        return -1;
+    }
+    dev->regs = p;
+    dev->caps = reg_rd(dev, DRAW_REG_CAPS);
+    dev->irq_armed = 0;
+    dev->ring = NULL;
+    return 0;
+}
+
+void draw_dev_close(struct draw_dev *dev)
+{
+    if (dev->regs && dev->ring)
+        reg_wr(dev, DRAW_REG_RINGSIZE, 0);      /* hand back to the FIFO */
+    dev->ring = NULL;
+    if (dev->regs)
+        munmap((void *)dev->regs, DRAW_REG_SIZE);
+    if (dev->fd >= 0)
+        close(dev->fd);
+    dev->regs = NULL;
+    dev->fd = -1;
+}
+
+void draw_dev_reset(struct draw_dev *dev)
+{
+    reg_wr(dev, DRAW_REG_CTRL, DRAW_CTRL_RST);
+    dev->ring_tail = 0;     /* RST rewinds HEAD/TAIL, keeps the ring */
+    usleep(1000);
+}
+
+static long ms_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+int draw_dev_wait(struct draw_dev *dev, int timeout_ms)
+{
+    long deadline = ms_now() + timeout_ms;
+
+    /*
+     * DRW_IRQ: generic-uio masks the line after each interrupt, so
+     * the read() returns once the EODL has been reached.  Only a
+     * submit arms it: waiting on an idle engine (before the next
+     * list) would otherwise run poll() out to the timeout, so that
+     * case goes straight to DRAWSTAT.  If the IRQ never arrives
+     * (e.g. DRAWINT not wired in this RTL drop) fall back to polling
+     * DRAWSTAT.BUSY until the deadline.
+     */
+    if (dev->irq_armed) {
+        struct pollfd pfd = { .fd = dev->fd, .events = POLLIN };
+        dev->irq_armed = 0;
+        if (poll(&pfd, 1, timeout_ms) > 0 && (pfd.revents & POLLIN)) {
+            uint32_t count;
+            if (read(dev->fd, &count, sizeof(count)) != sizeof(count))
+                return -1;
+            reg_wr(dev, DRAW_REG_INT, DRAW_INT_ENBL | DRAW_INT_CLR);
+        }
+    }
+
+    uint32_t stat;
+    while ((stat = reg_rd(dev, DRAW_REG_STAT)) & DRAW_STAT_BUSY) {
+        if (ms_now() > deadline) {
+            fprintf(stderr, "draw_engine: timeout (DRAWSTAT=0x%08x)\n", stat);
+            return -1;
+        }
+    }
+    if (DRAW_STAT_ERR(stat)) {
+        fprintf(stderr, "draw_engine: error %u (DRAWSTAT=0x%08x)\n",
+                DRAW_STAT_ERR(stat), stat);
+        return -1;
+    }
+    return 0;
+}
+
+int draw_dev_ring_init(struct draw_dev *dev, struct draw_vram *vram,
+                       uint32_t phys, uint32_t size)
+{
+    if (!(dev->caps & DRAW_CAPS_RING))
+        return -1;      /* RTL without the ring */
+    if (size <= DRAW_RING_HDR || (size & 3) || (phys & 3))
+        return -1;
+    if (draw_dev_wait(dev, 1000) < 0)
+        return -1;
+
+    uint32_t len = size - DRAW_RING_HDR;
+    reg_wr(dev, DRAW_REG_RINGSIZE, 0);
+    reg_wr(dev, DRAW_REG_RINGBASE, phys + DRAW_RING_HDR);
+    reg_wr(dev, DRAW_REG_RINGDONE, phys);
+    reg_wr(dev, DRAW_REG_RINGSIZE, len);
+
+    dev->ring_done = draw_vram_ptr(vram, phys);
+    dev->ring = dev->ring_done + DRAW_RING_HDR / 4;
+    dev->ring_size = len;
+    dev->ring_tail = 0;
+    dev->ring_tag = 0;
+    *dev->ring_done = 0;
+    return 0;
+}
+
+/*
+ * Copy @dl behind the ring tail and publish it.  Only a list larger
+ * than the free space needs more register traffic: the tail is then
+ * published early and HEAD polled until the engine has made room.
+ */
+static int ring_submit(struct draw_dev *dev, struct draw_dl *dl)
+{
+    uint32_t tag = (dev->ring_tag + 1) & 0xFFFFFF;
+    dev->ring_tag = tag ? tag : 1;
+    dl->words[dl->len - 1] = DRAW_CMD(DRAW_OP_EODL, dev->ring_tag);
+
+    uint32_t head = reg_rd(dev, DRAW_REG_RINGHEAD);
+    uint32_t tail = dev->ring_tail;
+    for (size_t i = 0; i < dl->len; i++) {
+        uint32_t next = (tail + 4) % dev->ring_size;
+        if (next == head) {
+            __sync_synchronize();
+            reg_wr(dev, DRAW_REG_RINGTAIL, tail);
+            long deadline = ms_now() + 1000;
+            while ((head = reg_rd(dev, DRAW_REG_RINGHEAD)) == next) {
+                if (ms_now() > deadline) {
+                    fprintf(stderr, "draw_engine: ring stalled (DRAWSTAT=0x%08x)\n",
+                            reg_rd(dev, DRAW_REG_STAT));
+                    dev->ring_tail = tail;
+                    return -1;
+                }
+            }
+        }
+        dev->ring[tail / 4] = dl->words[i];
+        tail = next;
+    }
+    __sync_synchronize();
+    reg_wr(dev, DRAW_REG_RINGTAIL, tail);
+    dev->ring_tail = tail;
+    return 0;
+}
+
+int draw_dev_submit(struct draw_dev *dev, struct draw_dl *dl)
+{
+    if (dl->oom) {
+        fprintf(stderr, "draw_engine: display list allocation failed\n");
+        return -1;
+    }
+    if (dl->len == 0 || (dl->words[dl->len - 1] >> 24) != DRAW_OP_EODL)
+        draw_dl_eodl(dl);
+
+    if (draw_dev_wait(dev, 1000) < 0)
+        return -1;
+
+    /* Arm DRW_IRQ before the list can complete */
+    uint32_t unmask = 1;
+    if (write(dev->fd, &unmask, sizeof(unmask)) != sizeof(unmask) && errno != EINVAL)
+        perror("uio irq enable");
+    reg_wr(dev, DRAW_REG_INT, DRAW_INT_ENBL | DRAW_INT_CLR);
+    dev->irq_armed = 1;
+
+    if (dev->ring) {
+        if (ring_submit(dev, dl) < 0)
+            return -1;
+        return draw_dev_wait(dev, 5000);
+    }
+
+    /*
+     * Feed DRAWCMD.  Lists longer than the command FIFO are started
+     * as soon as the FIFO fills, then topped up while the pipeline
+     * drains it.
+     */
+    int started = 0;
+    for (size_t i = 0; i < dl->len; i++) {
+        if (reg_rd(dev, DRAW_REG_BUFSTAT) & DRAW_BUF_FULL) {
+            if (!started) {
+                reg_wr(dev, DRAW_REG_CTRL, DRAW_CTRL_EXE);
+                started = 1;
+            }
+            long deadline = ms_now() + 1000;
+            while (reg_rd(dev, DRAW_REG_BUFSTAT) & DRAW_BUF_FULL) {
+                if (ms_now() > deadline) {
+                    fprintf(stderr, "draw_engine: FIFO stalled (DRAWSTAT=0x%08x)\n",
+                            reg_rd(dev, DRAW_REG_STAT));
+                    return -1;
+                }
+            }
+        }
+        reg_wr(dev, DRAW_REG_CMD, dl->words[i]);
+    }
+    if (!started)
+        reg_wr(dev, DRAW_REG_CTRL, DRAW_CTRL_EXE);
+
+    return draw_dev_wait(dev, 5000);
+}
+
+/* ── Performance counters ─────────────────────────────────── */
+const char *const draw_perf_names[DRAW_PERF_NUM] = {
+    [DRAW_PERF_CMDS]         = "cmds",
+    [DRAW_PERF_LISTS]        = "lists",
+    [DRAW_PERF_FIFO_FULL]    = "fifo_full",
+    [DRAW_PERF_FIFO_EMPTY]   = "fifo_empty",
+    [DRAW_PERF_RD_BEATS]     = "rd_beats",
+    [DRAW_PERF_WR_BEATS]     = "wr_beats",
+    [DRAW_PERF_RD_BURSTS]    = "rd_bursts",
+    [DRAW_PERF_WR_BURSTS]    = "wr_bursts",
+    [DRAW_PERF_PAT_PIXELS]   = "pat_px",
+    [DRAW_PERF_BLT_PIXELS]   = "blt_px",
+    [DRAW_PERF_BLEND_PIXELS] = "blend_px",
+    [DRAW_PERF_KEY_PIXELS]   = "key_px",
+    [DRAW_PERF_XFER_PIXELS]  = "xfer_px",
+    [DRAW_PERF_FLUSH_PIXELS] = "flush_px",
+    [DRAW_PERF_VIRTQ_BUFS]   = "vq_bufs",
+    [DRAW_PERF_VIRTQ_IRQS]   = "vq_irqs",
+    [DRAW_PERF_BANDS]        = "bands",
+    [DRAW_PERF_CYCLES]       = "cycles",
+};
+
+void draw_dev_perf_read(struct draw_dev *dev, uint32_t *out)
+{
+    for (unsigned i = 0; i < DRAW_PERF_NUM; i++)
+        out[i] = reg_rd(dev, DRAW_REG_PERF(i));
+}
+
+void draw_dev_perf_clear(struct draw_dev *dev)
+{
+    reg_wr(dev, DRAW_REG_PERFCTRL, DRAW_PERF_CLEAR);
+}
+
+/* ── VRAM window (/dev/mem) ───────────────────────────────── */
+int draw_vram_map(struct draw_vram *vram, uint32_t phys, size_t size)
+{
+    vram->fd = open("/dev/mem", O_RDWR | O_SYNC);
+    if (vram->fd < 0) {
+        perror("/dev/mem");
+        return -1;
+    }
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   vram->fd, phys);
+    if (p == MAP_FAILED) {
+        perror("mmap /dev/mem");
+        close(vram->fd);
+        vram->fd = -1;
+        return -1;
+    }
+    vram->base = p;
+    vram->phys = phys;
+    vram->size = size;
+    return 0;
+}
+
+void draw_vram_unmap(struct draw_vram *vram)
+{
+    if (vram->base)
+        munmap(vram->base, vram->size);
+    if (vram->fd >= 0)
+        close(vram->fd);
+    vram->base = NULL;
+    vram->fd = -1;
+}
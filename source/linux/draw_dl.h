@@ -0,0 +1,311 @@
+/*
+ * draw_dl.h — Draw Engine native display-list builder + UIO submission
+ *
+ * Builds Draw Engine command sequences in memory and submits them
+ * through the legacy register window (0x8200_2000, generic-uio node
+ * "draw-engine@82002000" → /dev/uio0).  Completion is signalled by
+ * DRW_IRQ (PLIC source 2), delivered to userspace via the UIO fd.
+ *
+ * Legacy register window (offsets from 0x8200_2000):
+ *   0x00  DRAWCTRL     W   bit0 = EXE (start display list), bit1 = RST
+ *   0x04  DRAWSTAT     R   bit0 = BUSY, [18:16] = error code
+ *   0x08  DRAWBUFSTAT  R   [11:0] = FIFO count, bit16 = EMPTY, bit17 = FULL
+ *   0x0C  DRAWCMD      W   command FIFO (one 32-bit word per write)
+ *   0x10  DRAWINT      RW  bit0 = INTENBL, bit1 = INTCLR (write 1)
+ *   0x14  DRAWCAPS     R   optional features (DRAW_CAPS_*), 0 on the RTL
+ *   0x18  DRAWPIPES    RW  [3:0] = pipelines in use, [19:16] = available
+ *   0x20  DRAWRINGBASE RW  display-list ring base (physical)
+ *   0x24  DRAWRINGSIZE RW  ring size in bytes, 0 = DRAWCMD FIFO mode
+ *                          (ignored while busy, except 0: that abandons
+ *                          a ring list and always takes effect)
+ *   0x28  DRAWRINGHEAD R   fetch offset within the ring
+ *   0x2C  DRAWRINGTAIL RW  producer offset; a write starts fetching
+ *   0x30  DRAWRINGDONE RW  address each EODL writes its [23:0] tag to
+ *   0x100 DRAWPERFCTRL W   bit0 = clear all performance counters
+ *   0x104 DRAWPERF[n]  R   free-running u32 counters (DRAW_PERF_*)
+ *
+ * Command words (opcode in [31:24]):
+ *   NOP          0x00
+ *   EODL         0x0F   end of display list → DRW_IRQ, [23:0] = ring tag
+ *   JUMP         0x10   + ADDR   continue fetching at ADDR (ring mode)
+ *   CALL         0x11   + ADDR   run the list at ADDR up to its RET
+ *   RET          0x12            return after the calling CALL
+ *   SETFRAME     0x20   + VRAMADR + {WIDTH[31:16], HEIGHT[15:0]}
+ *   SETDRAWAREA  0x21   + {POSX, POSY} + {SIZEX, SIZEY}
+ *   SETTEXTURE   0x22   [1:0] = DRAW_TEX_* + VRAMADR + {WIDTH, HEIGHT}
+ *   SETFCOLOR    0x23   + ARGB8888
+ *   SETSTCOLOR   0x24   + ARGB8888 (stencil / color-key)
+ *   SETPALETTE   0x25   [8:0] = entries + VRAMADR of ARGB8888 CLUT8 palette
+ *   SETSCALE     0x26   [0] = bilinear + XSTEP + YSTEP (16.16 texels/pixel)
+ *   SETSTMODE    0x30   [0] = stencil enable
+ *   SETBLENDALPHA 0x31  [7:0] = source alpha (per-pixel α when 0xFF)
+ *   SETBLENDOFF  0x32
+ *   PATBLT       0x81   + {DPOSX, DPOSY} + {DSIZEX, DSIZEY}
+ *   BITBLT       0x82   + {DPOSX, DPOSY} + {DSIZEX, DSIZEY} + {SPOSX, SPOSY}
+ *   LINE         0x83   + {X0, Y0} + {X1, Y1}            1-pixel Bresenham
+ *   TRIANGLE     0x84   + {X0, Y0} + {X1, Y1} + {X2, Y2}  filled
+ *   ELLIPSE      0x85   + {CX, CY} + {RX, RY}            filled, axis-aligned
+ *   GRADIENT     0x86   [0] = vertical + {DPOSX, DPOSY} + {DSIZEX, DSIZEY}
+ *                       + ARGB from + ARGB to
+ *   SCALEBLT     0x87   + {DPOSX, DPOSY} + {DSIZEX, DSIZEY} + {SPOSX, SPOSY}
+ *
+ * Coordinates and sizes are packed as two 16-bit fields, X/width high.
+ * LINE / TRIANGLE / ELLIPSE fill with SETFCOLOR through the PATBLT path
+ * and cover the same pixels as the fb_shape.c span generators.
+ *
+ * RGB888 (bytes R, G, B) and CLUT8 textures are expanded to ARGB8888
+ * as the engine reads them; their rows start on a 32-bit boundary.
+ * SCALEBLT samples texel (SPOS + (d + ½) · STEP) for destination pixel
+ * d, clamped to the texture edge, and forces nearest while the stencil
+ * key is on.
+ *
+ * In ring mode the engine fetches commands itself over AXI from
+ * [HEAD, TAIL) and wraps at RINGSIZE; submitting a list costs one
+ * DRAWRINGTAIL write however long it is.  CALL nests up to 4 deep.
+ */
+#ifndef DRAW_DL_H
+#define DRAW_DL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ── Register map ─────────────────────────────────────────── */
+#define DRAW_REG_BASE        0x82002000u
+#define DRAW_REG_SIZE        0x1000u
+
+#define DRAW_REG_CTRL        0x00
+#define DRAW_REG_STAT        0x04
+#define DRAW_REG_BUFSTAT     0x08
+#define DRAW_REG_CMD         0x0C
+#define DRAW_REG_INT         0x10
+#define DRAW_REG_CAPS        0x14
+#define DRAW_REG_PIPES       0x18
+#define DRAW_REG_RINGBASE    0x20
+#define DRAW_REG_RINGSIZE    0x24
+#define DRAW_REG_RINGHEAD    0x28
+#define DRAW_REG_RINGTAIL    0x2C
+#define DRAW_REG_RINGDONE    0x30
+
+#define DRAW_CTRL_EXE        (1u << 0)
+#define DRAW_CTRL_RST        (1u << 1)
+
+#define DRAW_STAT_BUSY       (1u << 0)
+#define DRAW_STAT_ERR(s)     (((s) >> 16) & 0x7)
+
+#define DRAW_BUF_COUNT(s)    ((s) & 0xFFF)
+#define DRAW_BUF_EMPTY       (1u << 16)
+#define DRAW_BUF_FULL        (1u << 17)
+
+#define DRAW_INT_ENBL        (1u << 0)
+#define DRAW_INT_CLR         (1u << 1)
+
+#define DRAW_CAPS_RING       (1u << 0)     /* DRAWRING*, JUMP / CALL / RET */
+#define DRAW_CAPS_SHAPES     (1u << 1)     /* LINE, TRIANGLE, ELLIPSE, GRADIENT */
+#define DRAW_CAPS_TEXFMT     (1u << 2)     /* RGB888 / CLUT8, SETPALETTE, SCALEBLT */
+#define DRAW_CAPS_PIPES      (1u << 3)     /* DRAWPIPES */
+
+#define DRAW_PIPES_ACTIVE(p) ((p) & 0xF)
+#define DRAW_PIPES_AVAIL(p)  (((p) >> 16) & 0xF)
+
+/*
+ * Performance counters.  Implemented by the transaction-level model
+ * (lib/libdraw_tlm.so); the RTL build reads them back as zero.
+ */
+#define DRAW_REG_PERFCTRL    0x100
+#define DRAW_REG_PERF(n)     (0x104 + 4 * (n))
+#define DRAW_PERF_CLEAR      (1u << 0)
+
+enum {
+    DRAW_PERF_CMDS,         /* display-list commands executed */
+    DRAW_PERF_LISTS,        /* display lists completed (EODL) */
+    DRAW_PERF_FIFO_FULL,    /* DRAWCMD writes dropped on a full FIFO */
+    DRAW_PERF_FIFO_EMPTY,   /* engine ran the FIFO dry before EODL */
+    DRAW_PERF_RD_BEATS,     /* 32-bit memory reads */
+    DRAW_PERF_WR_BEATS,     /* 32-bit memory writes */
+    DRAW_PERF_RD_BURSTS,
+    DRAW_PERF_WR_BURSTS,
+    DRAW_PERF_PAT_PIXELS,   /* PATBLT pixels written */
+    DRAW_PERF_BLT_PIXELS,   /* BITBLT pixels written */
+    DRAW_PERF_BLEND_PIXELS, /* pixels blended (destination read back) */
+    DRAW_PERF_KEY_PIXELS,   /* texels dropped by the stencil key */
+    DRAW_PERF_XFER_PIXELS,  /* VirtIO TRANSFER_TO_HOST_2D pixels */
+    DRAW_PERF_FLUSH_PIXELS, /* VirtIO RESOURCE_FLUSH pixels */
+    DRAW_PERF_VIRTQ_BUFS,   /* VirtIO buffers completed */
+    DRAW_PERF_VIRTQ_IRQS,   /* VirtIO used-buffer interrupts raised */
+    DRAW_PERF_BANDS,        /* row bands dispatched to the pipelines */
+    DRAW_PERF_CYCLES,       /* estimated engine clocks spent drawing */
+    DRAW_PERF_NUM
+};
+
+extern const char *const draw_perf_names[DRAW_PERF_NUM];
+
+/* ── Opcodes ──────────────────────────────────────────────── */
+#define DRAW_OP_NOP          0x00
+#define DRAW_OP_EODL         0x0F
+#define DRAW_OP_JUMP         0x10
+#define DRAW_OP_CALL         0x11
+#define DRAW_OP_RET          0x12
+#define DRAW_OP_SETFRAME     0x20
+#define DRAW_OP_SETDRAWAREA  0x21
+#define DRAW_OP_SETTEXTURE   0x22
+#define DRAW_OP_SETFCOLOR    0x23
+#define DRAW_OP_SETSTCOLOR   0x24
+#define DRAW_OP_SETPALETTE   0x25
+#define DRAW_OP_SETSCALE     0x26
+#define DRAW_OP_SETSTMODE    0x30
+#define DRAW_OP_SETBLENDALPHA 0x31
+#define DRAW_OP_SETBLENDOFF  0x32
+#define DRAW_OP_PATBLT       0x81
+#define DRAW_OP_BITBLT       0x82
+#define DRAW_OP_LINE         0x83
+#define DRAW_OP_TRIANGLE     0x84
+#define DRAW_OP_ELLIPSE      0x85
+#define DRAW_OP_GRADIENT     0x86
+#define DRAW_OP_SCALEBLT     0x87
+
+#define DRAW_GRAD_VERTICAL   (1u << 0)
+#define DRAW_SCALE_BILINEAR  (1u << 0)
+#define DRAW_SCALE_ONE       0x10000u      /* 1:1 step */
+
+/* Texture formats (SETTEXTURE [1:0]) */
+#define DRAW_TEX_ARGB8888    0
+#define DRAW_TEX_RGB888      1
+#define DRAW_TEX_CLUT8       2
+
+/* Bytes per row of a @w-texel texture in @fmt */
+static inline uint32_t draw_tex_stride(int w, int fmt)
+{
+    uint32_t bpp = fmt == DRAW_TEX_RGB888 ? 3 : fmt == DRAW_TEX_CLUT8 ? 1 : 4;
+    return ((uint32_t)w * bpp + 3) & ~3u;
+}
+
+/* SETSCALE step that maps @src texels onto @dst pixels */
+static inline uint32_t draw_scale_step(int src, int dst)
+{
+    return dst > 0 ? (uint32_t)(((uint64_t)src << 16) / (uint32_t)dst) : DRAW_SCALE_ONE;
+}
+
+#define DRAW_CMD(op, arg)    (((uint32_t)(op) << 24) | ((uint32_t)(arg) & 0xFFFFFF))
+#define DRAW_XY(x, y)        ((((uint32_t)(x) & 0xFFFF) << 16) | ((uint32_t)(y) & 0xFFFF))
+
+/* ── Scanout / VRAM layout (reserved-memory in the DTS) ───── */
+#define DRAW_VRAM_BASE       0x43E00000u   /* litex_video scanout */
+#define DRAW_VRAM_SIZE       0x00200000u   /* 2 MiB reserved */
+
+/* Display-list ring: top 64 KiB of VRAM, completion tag in the first word */
+#define DRAW_RING_ADDR       (DRAW_VRAM_BASE + DRAW_VRAM_SIZE - DRAW_RING_SIZE)
+#define DRAW_RING_SIZE       0x00010000u
+#define DRAW_RING_HDR        64
+
+/* ── Display list ─────────────────────────────────────────── */
+struct draw_dl {
+    uint32_t *words;
+    size_t    len;
+    size_t    cap;
+    int       oom;      /* set when a grow failed; submit refuses */
+};
+
+void draw_dl_init(struct draw_dl *dl);
+void draw_dl_free(struct draw_dl *dl);
+void draw_dl_reset(struct draw_dl *dl);
+
+/* State-setting commands */
+void draw_dl_setframe(struct draw_dl *dl, uint32_t addr, int w, int h);
+void draw_dl_setdrawarea(struct draw_dl *dl, int x, int y, int w, int h);
+void draw_dl_settexture(struct draw_dl *dl, uint32_t addr, int w, int h);
+void draw_dl_setfcolor(struct draw_dl *dl, uint32_t argb);
+void draw_dl_setstcolor(struct draw_dl *dl, uint32_t argb);
+void draw_dl_setstmode(struct draw_dl *dl, int enable);
+void draw_dl_setblendalpha(struct draw_dl *dl, uint8_t alpha);
+void draw_dl_setblendoff(struct draw_dl *dl);
+
+/* Texture formats and scaling (DRAW_CAPS_TEXFMT) */
+void draw_dl_settexture_fmt(struct draw_dl *dl, uint32_t addr, int w, int h,
+                            int fmt);
+void draw_dl_setpalette(struct draw_dl *dl, uint32_t addr, int entries);
+void draw_dl_setscale(struct draw_dl *dl, uint32_t step_x, uint32_t step_y,
+                      int bilinear);
+void draw_dl_scaleblt(struct draw_dl *dl, int dx, int dy, int w, int h,
+                      int sx, int sy);
+
+/* Drawing execution commands */
+void draw_dl_patblt(struct draw_dl *dl, int x, int y, int w, int h);
+void draw_dl_bitblt(struct draw_dl *dl, int dx, int dy, int w, int h,
+                    int sx, int sy);
+
+/* Shape commands (DRAW_CAPS_SHAPES) */
+void draw_dl_line(struct draw_dl *dl, int x0, int y0, int x1, int y1);
+void draw_dl_triangle(struct draw_dl *dl, int x0, int y0, int x1, int y1,
+                      int x2, int y2);
+void draw_dl_ellipse(struct draw_dl *dl, int cx, int cy, int rx, int ry);
+void draw_dl_gradient(struct draw_dl *dl, int x, int y, int w, int h,
+                      uint32_t from, uint32_t to, int vertical);
+
+/* Control commands */
+void draw_dl_nop(struct draw_dl *dl);
+void draw_dl_eodl(struct draw_dl *dl);
+void draw_dl_jump(struct draw_dl *dl, uint32_t addr);
+void draw_dl_call(struct draw_dl *dl, uint32_t addr);
+void draw_dl_ret(struct draw_dl *dl);
+
+/* ── Device (UIO) ─────────────────────────────────────────── */
+struct draw_vram;
+
+struct draw_dev {
+    int                fd;
+    volatile uint32_t *regs;
+    uint32_t           caps;        /* DRAWCAPS, read at open */
+    int                irq_armed;   /* DRW_IRQ unmasked by the last submit */
+
+    /* Display-list ring (draw_dev_ring_init), NULL: DRAWCMD FIFO */
+    volatile uint32_t *ring;
+    volatile uint32_t *ring_done;
+    uint32_t           ring_size;   /* bytes */
+    uint32_t           ring_tail;
+    uint32_t           ring_tag;
+};
+
+int  draw_dev_open(struct draw_dev *dev, const char *uio_path);
+void draw_dev_close(struct draw_dev *dev);
+void draw_dev_reset(struct draw_dev *dev);
+
+/*
+ * Push every word of @dl into DRAWCMD, start execution and block
+ * until DRW_IRQ (or DRAWSTAT.BUSY clears).  An EODL is appended
+ * automatically if the list does not already end with one.
+ * Returns 0 on success, -1 on timeout / engine error.
+ */
+int  draw_dev_submit(struct draw_dev *dev, struct draw_dl *dl);
+int  draw_dev_wait(struct draw_dev *dev, int timeout_ms);
+
+/*
+ * Switch @dev to ring submission using [@phys, @phys + @size) inside
+ * @vram: the first DRAW_RING_HDR bytes hold the completion tag, the
+ * rest is the ring.  draw_dev_submit() then copies each list into the
+ * ring and publishes it with a single DRAWRINGTAIL write.  Returns -1
+ * (and stays on the FIFO) without DRAW_CAPS_RING.
+ */
+int  draw_dev_ring_init(struct draw_dev *dev, struct draw_vram *vram,
+                        uint32_t phys, uint32_t size);
+
+/* Snapshot / clear the DRAWPERF counters (@out has DRAW_PERF_NUM slots) */
+void draw_dev_perf_read(struct draw_dev *dev, uint32_t *out);
+void draw_dev_perf_clear(struct draw_dev *dev);
+
+/* ── VRAM window (/dev/mem) ───────────────────────────────── */
+struct draw_vram {
+    int       fd;
+    uint8_t  *base;
+    uint32_t  phys;
+    size_t    size;
+};
+
+int  draw_vram_map(struct draw_vram *vram, uint32_t phys, size_t size);
+void draw_vram_unmap(struct draw_vram *vram);
+
+static inline void *draw_vram_ptr(const struct draw_vram *vram, uint32_t phys)
+{
+    return vram->base + (phys - vram->phys);
+}
+
+#endif /* DRAW_DL_H */
@@ -0,0 +1,343 @@
+/*
+ * fb_bench.c — Rendering micro-benchmarks: CPU span kernels vs Draw Engine
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "fb_blend.h"
+#include "fb_bench.h"
+
+static const struct { const char *name; int w, h; } bench_res[] = {
+    { "VGA",  640,  480 },
+    { "SVGA", 800,  600 },
+    { "XGA",  1024, 768 },
+    { "SXGA", 1280, 1024 },
+};
+
+/* Box sizes; 0 = full screen */
+static const int bench_size[] = { 16, 64, 256, 0 };
+
+#define N_RES   (int)(sizeof(bench_res) / sizeof(bench_res[0]))
+#define N_SIZE  (int)(sizeof(bench_size) / sizeof(bench_size[0]))
+
+/* Draw Engine ops are batched up to this many pixels per submission */
+#define HW_BATCH_PIXELS  (256 * 1024)
+#define HW_BATCH_MAX     256
+
+/* ── One benchmark case ───────────────────────────────────── */
+struct bench_case {
+    const struct fb_bench_cfg *cfg;
+    const char         *res;
+    int                 rw, rh;     /* target resolution */
+    int                 w, h;       /* box size */
+
+    struct fb_surface   dst;        /* CPU target */
+    const uint32_t     *src;        /* w × h source for copy / blend */
+    const char         *line;       /* w / 8 characters */
+
+    struct draw_dl     *dl;
+    int                 batch;      /* ops per display list */
+};
+
+typedef void (*bench_fn)(struct bench_case *c);
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int results_out;
+
+static void report(struct bench_case *c, FILE *out, const char *path,
+                   const char *op, long ops, double us)
+{
+    double per_op = us / ops;
+    double mpix = (double)c->w * c->h / per_op;     /* pixels/µs = Mpix/s */
+
+    if (c->cfg->json) {
+        fprintf(out, "%s\n  {\"path\": \"%s\", \"op\": \"%s\", \"res\": \"%s\", "
+                "\"width\": %d, \"height\": %d, \"box_w\": %d, \"box_h\": %d, "
+                "\"ops\": %ld, \"us_per_op\": %.3f, \"mpix_per_s\": %.3f}",
+                results_out ? "," : "", path, op, c->res, c->rw, c->rh,
+                c->w, c->h, ops, per_op, mpix);
+    } else {
+        fprintf(out, "%s,%s,%s,%d,%d,%d,%d,%ld,%.3f,%.3f\n",
+                path, op, c->res, c->rw, c->rh, c->w, c->h, ops, per_op, mpix);
+    }
+    fflush(out);
+    results_out++;
+}
+
+/* Repeat @fn until FB_BENCH_MIN_US and at least 3 calls have passed */
+static void run_case(struct bench_case *c, FILE *out, const char *path,
+                     const char *op, bench_fn fn, int ops_per_call)
+{
+    long calls = 0;
+
+    fn(c);      /* warm-up: caches, display list growth, atlas expansion */
+
+    double t0 = now_us(), t;
+
+    do {
+        fn(c);
+        calls++;
+        t = now_us() - t0;
+    } while ((t < FB_BENCH_MIN_US || calls < 3) && calls < 1000000);
+
+    report(c, out, path, op, calls * ops_per_call, t);
+}
+
+/* ── CPU ops ──────────────────────────────────────────────── */
+static void cpu_fill(struct bench_case *c)
+{
+    fb_fill_rect(&c->dst, 0, 0, c->w, c->h, 0xFF3080C0);
+}
+
+static void cpu_copy(struct bench_case *c)
+{
+    fb_copy_rect(&c->dst, 0, 0, c->w, c->h, c->src, c->w);
+}
+
+static void cpu_blend(struct bench_case *c)
+{
+    fb_blend_rect(&c->dst, 0, 0, c->src, c->w, c->h);
+}
+
+static void cpu_text(struct bench_case *c)
+{
+    for (int y = 0; y + FB_GLYPH_H <= c->h || y == 0; y += FB_GLYPH_H)
+        fb_text_draw(&c->dst, 0, y, c->line, 0xFFFFFFFF, 0xFF000000, 0);
+}
+
+static void cpu_logo(struct bench_case *c)
+{
+    /* Sub-surface = the box, so the tiles clip at its edges */
+    struct fb_surface box = { c->dst.base, c->w, c->h, c->dst.stride };
+    const struct fb_tex *t = c->cfg->logo;
+
+    for (int y = 0; y < c->h; y += t->height)
+        for (int x = 0; x < c->w; x += t->width)
+            fb_tex_draw(&box, t, x, y);
+}
+
+/* ── Draw Engine ops (one display list of c->batch ops) ───── */
+static void hw_submit(struct bench_case *c)
+{
+    if (draw_dev_submit(c->cfg->hw, c->dl) < 0)
+        fprintf(stderr, "bench: Draw Engine submission failed\n");
+}
+
+static void hw_prologue(struct bench_case *c)
+{
+    draw_dl_reset(c->dl);
+    draw_dl_setframe(c->dl, c->cfg->hw_frame, c->rw, c->rh);
+    draw_dl_setdrawarea(c->dl, 0, 0, c->rw, c->rh);
+    draw_dl_setblendoff(c->dl);
+    draw_dl_setstmode(c->dl, 0);
+}
+
+static void hw_empty(struct bench_case *c)
+{
+    draw_dl_reset(c->dl);
+    hw_submit(c);
+}
+
+static void hw_fill(struct bench_case *c)
+{
+    hw_prologue(c);
+    draw_dl_setfcolor(c->dl, 0xFF3080C0);
+    for (int i = 0; i < c->batch; i++)
+        draw_dl_patblt(c->dl, 0, 0, c->w, c->h);
+    hw_submit(c);
+}
+
+/* Copy / blend read cfg->hw_src: the CPU source, uploaded by hw_load_src() */
+static void hw_copy(struct bench_case *c)
+{
+    hw_prologue(c);
+    draw_dl_settexture(c->dl, c->cfg->hw_src, c->w, c->h);
+    for (int i = 0; i < c->batch; i++)
+        draw_dl_bitblt(c->dl, 0, 0, c->w, c->h, 0, 0);
+    hw_submit(c);
+}
+
+/* Per-pixel alpha (0xFF) like fb_blend_rect: the transparent third is skipped */
+static void hw_blend(struct bench_case *c)
+{
+    hw_prologue(c);
+    draw_dl_settexture(c->dl, c->cfg->hw_src, c->w, c->h);
+    draw_dl_setblendalpha(c->dl, 0xFF);
+    for (int i = 0; i < c->batch; i++)
+        draw_dl_bitblt(c->dl, 0, 0, c->w, c->h, 0, 0);
+    draw_dl_setblendoff(c->dl);
+    hw_submit(c);
+}
+
+static void hw_text(struct bench_case *c)
+{
+    hw_prologue(c);
+    for (int i = 0; i < c->batch; i++)
+        for (int y = 0; y + FB_GLYPH_H <= c->h || y == 0; y += FB_GLYPH_H)
+            fb_text_dl(c->dl, c->cfg->hw_font, 0, y, c->line,
+                       0xFFFFFFFF, 0xFF000000, 0);
+    hw_submit(c);
+}
+
+static void hw_logo(struct bench_case *c)
+{
+    const struct fb_tex *t = c->cfg->hw_logo;
+
+    hw_prologue(c);
+    fb_tex_bind(c->dl, t);
+    for (int i = 0; i < c->batch; i++)
+        for (int y = 0; y < c->h; y += t->height)
+            for (int x = 0; x < c->w; x += t->width) {
+                int bw = (c->w - x < t->width)  ? c->w - x : t->width;
+                int bh = (c->h - y < t->height) ? c->h - y : t->height;
+                draw_dl_bitblt(c->dl, x, y, bw, bh, 0, 0);
+            }
+    hw_submit(c);
+}
+
+static int hw_src_fits(const struct bench_case *c)
+{
+    return c->cfg->hw_src_px && (size_t)c->w * c->h * 4 <= c->cfg->hw_src_size;
+}
+
+static void hw_load_src(const struct bench_case *c)
+{
+    size_t len = (size_t)c->w * c->h * 4;
+
+    memcpy(c->cfg->hw_src_px, c->src, len);
+    msync(c->cfg->hw_src_px, (len + 0xFFF) & ~(size_t)0xFFF, MS_SYNC);
+}
+
+/* ── fbdev flush ──────────────────────────────────────────── */
+static void flush_box(struct bench_case *c)
+{
+    c->cfg->flush(0, 0, c->w, c->h);
+}
+
+/* ── Suite ────────────────────────────────────────────────── */
+static const struct {
+    const char *op;
+    bench_fn    cpu;
+    bench_fn    hw;
+} bench_ops[] = {
+    { "fill",  cpu_fill,  hw_fill  },
+    { "copy",  cpu_copy,  hw_copy  },
+    { "blend", cpu_blend, hw_blend },
+    { "text",  cpu_text,  hw_text  },
+    { "logo",  cpu_logo,  hw_logo  },
+};
+
+/* Blend source: transparent, opaque and mixed-alpha thirds per row */
+static void make_blend_src(uint32_t *px, int w, int h)
+{
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            uint32_t a = (x < w / 3) ? 0 : (x < 2 * w / 3) ? 255 : (x * 7 + y) & 0xFF;
+            uint32_t c = (a * 3) / 4;           /* premultiplied: <= a */
+            px[(size_t)y * w + x] = (a << 24) | (c << 16) | (c << 8) | c;
+        }
+    }
+}
+
+int fb_bench_run(const struct fb_bench_cfg *cfg, FILE *out)
+{
+    int max_w = bench_res[N_RES - 1].w, max_h = bench_res[N_RES - 1].h;
+    uint32_t *target = malloc((size_t)max_w * max_h * 4);
+    uint32_t *src = malloc((size_t)max_w * max_h * 4);
+    char *line = malloc(max_w / FB_GLYPH_W + 1);
+    struct draw_dl dl;
+
+    if (!target || !src || !line) {
+        fprintf(stderr, "bench: out of memory\n");
+        free(target);
+        free(src);
+        free(line);
+        return -1;
+    }
+    memset(target, 0, (size_t)max_w * max_h * 4);
+    draw_dl_init(&dl);
+
+    results_out = 0;
+    if (cfg->json)
+        fprintf(out, "{\"results\": [");
+    else
+        fprintf(out, "path,op,res,width,height,box_w,box_h,ops,us_per_op,mpix_per_s\n");
+
+    for (int r = 0; r < N_RES; r++) {
+        struct bench_case c = {
+            .cfg = cfg, .res = bench_res[r].name,
+            .rw = bench_res[r].w, .rh = bench_res[r].h,
+            .src = src, .line = line, .dl = &dl,
+        };
+        const struct fb_surface *scr = cfg->screen;
+        int on_screen = scr && scr->width == c.rw && scr->height == c.rh;
+        int hw_ok = cfg->hw && (size_t)c.rw * c.rh * 4 <= cfg->hw_frame_size;
+
+        c.dst = on_screen ? *scr
+                          : (struct fb_surface){ (uint8_t *)target, c.rw, c.rh, c.rw * 4 };
+        if (cfg->hw && !hw_ok)
+            fprintf(stderr, "bench: %s frame exceeds the VRAM window, CPU only\n",
+                    c.res);
+        if (hw_ok) {
+            c.w = c.h = 0;
+            run_case(&c, out, "hw", "submit", hw_empty, 1);
+        }
+
+        for (int s = 0; s < N_SIZE; s++) {
+            c.w = bench_size[s] ? bench_size[s] : c.rw;
+            c.h = bench_size[s] ? bench_size[s] : c.rh;
+            int cols = c.w / FB_GLYPH_W;
+            for (int i = 0; i < cols; i++)
+                line[i] = 0x21 + i % 94;    /* printable ASCII */
+            line[cols] = '\0';
+
+            long px = (long)c.w * c.h;
+            c.batch = (int)(HW_BATCH_PIXELS / px);
+            if (c.batch < 1) c.batch = 1;
+            if (c.batch > HW_BATCH_MAX) c.batch = HW_BATCH_MAX;
+
+            for (size_t o = 0; o < sizeof(bench_ops) / sizeof(bench_ops[0]); o++) {
+                if (bench_ops[o].cpu == cpu_blend)
+                    make_blend_src(src, c.w, c.h);
+                else if (bench_ops[o].cpu == cpu_copy)
+                    for (long i = 0; i < px; i++)
+                        src[i] = 0xFF000000 | (uint32_t)(i * 2654435761u >> 8);
+
+                if (bench_ops[o].cpu != cpu_logo || cfg->logo)
+                    run_case(&c, out, "cpu", bench_ops[o].op, bench_ops[o].cpu, 1);
+                if (!hw_ok || (bench_ops[o].hw == hw_logo && !cfg->hw_logo) ||
+                    (bench_ops[o].hw == hw_text && !cfg->hw_font))
+                    continue;
+                if (bench_ops[o].hw == hw_copy || bench_ops[o].hw == hw_blend) {
+                    if (!hw_src_fits(&c)) {
+                        fprintf(stderr, "bench: %s %dx%d %s source exceeds the VRAM "
+                                "window, CPU only\n", c.res, c.w, c.h, bench_ops[o].op);
+                        continue;
+                    }
+                    hw_load_src(&c);
+                }
+                run_case(&c, out, "hw", bench_ops[o].op, bench_ops[o].hw, c.batch);
+            }
+
+            if (on_screen && cfg->flush)
+                run_case(&c, out, "fbdev", "flush", flush_box, 1);
+        }
+    }
+
+    if (cfg->json)
+        fprintf(out, "\n]}\n");
+
+    draw_dl_free(&dl);
+    free(target);
+    free(src);
+    free(line);
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * fb_bench.h — Rendering micro-benchmarks: CPU span kernels vs Draw Engine
+ *
+ * Times fill, copy, blend blit, text and logo tiling for box sizes
+ * from 16x16 up to full screen, at every scanout resolution the board
+ * supports (VGA … SXGA).  CPU cases render into heap surfaces of each
+ * resolution (or the live screen at its own size); Draw Engine cases
+ * batch the op into one display list per submission and are run for
+ * the resolutions whose frame fits the VRAM window.  Copy and blend
+ * read a separate source surface in VRAM holding the same pixels as
+ * the CPU source, so the engine never blits the frame onto itself;
+ * box sizes that do not fit that surface are CPU only.  Framebuffer
+ * flush cost is measured on its own.
+ *
+ * Every case repeats until at least FB_BENCH_MIN_US has elapsed
+ * (CLOCK_MONOTONIC) and reports µs per op and Mpixel/s as CSV or JSON.
+ */
+#ifndef FB_BENCH_H
+#define FB_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "draw_dl.h"
+#include "fb_span.h"
+#include "fb_tex.h"
+#include "fb_text.h"
+
+#define FB_BENCH_MIN_US  200000
+
+struct fb_bench_cfg {
+    int                      json;          /* 0 = CSV */
+
+    const struct fb_tex     *logo;          /* CPU logo texture */
+
+    /* Live screen: used as the CPU target at its own resolution */
+    const struct fb_surface *screen;
+    /* Push [x, y, w, h] of the screen to the display; NULL = skip */
+    void (*flush)(int x, int y, int w, int h);
+
+    /* Draw Engine path; hw == NULL runs the CPU cases only */
+    struct draw_dev         *hw;
+    uint32_t                 hw_frame;      /* VRAM address of the target */
+    size_t                   hw_frame_size; /* bytes usable there */
+    uint32_t                 hw_src;        /* VRAM address of the copy / blend source */
+    uint32_t                *hw_src_px;     /* ... mapped, page aligned */
+    size_t                   hw_src_size;   /* bytes usable there */
+    const struct fb_tex     *hw_logo;       /* logo texture in VRAM */
+    struct fb_text_atlas    *hw_font;       /* glyph atlas in VRAM */
+};
+
+/* Run the whole suite; results go to @out.  Returns 0, -1 on ENOMEM. */
+int fb_bench_run(const struct fb_bench_cfg *cfg, FILE *out);
+
+#endif /* FB_BENCH_H */
@@ -0,0 +1,133 @@
+/*
+ * fb_blend.c — Division-free premultiplied "over" blending
+ *
+ * See fb_blend.h.  blend_run() is the only kernel with a vector
+ * variant; the run scanning and the fast paths are shared.
+ */
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "fb_blend.h"
+
+/* ── Source preparation ───────────────────────────────────── */
+void fb_blend_prepare_rgba(uint32_t *dst, const uint8_t *rgba, int n)
+{
+    for (int i = 0; i < n; i++, rgba += 4) {
+        uint32_t a = rgba[3];
+        uint32_t rb = (((uint32_t)rgba[0] << 16) | rgba[2]) * a;
+        uint32_t g = (uint32_t)rgba[1] * a;
+
+        rb = ((rb + 0x00010001 + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        g  =  (g + 1 + (g >> 8)) >> 8;
+        dst[i] = (a << 24) | rb | (g << 8);
+    }
+}
+
+/* ── Blend kernels (0 < alpha < 255) ──────────────────────── */
+#if defined(__SSE2__)
+/* Two pixels widened to 16-bit lanes */
+static inline __m128i sse_scale(__m128i d16, __m128i s16)
+{
+    const __m128i ff = _mm_set1_epi16(0xFF);
+    const __m128i one = _mm_set1_epi16(1);
+
+    __m128i a = _mm_shufflelo_epi16(s16, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128i x = _mm_mullo_epi16(d16, _mm_sub_epi16(ff, a));
+    x = _mm_add_epi16(x, _mm_add_epi16(one, _mm_srli_epi16(x, 8)));
+    return _mm_srli_epi16(x, 8);
+}
+#endif
+
+static void blend_run(uint32_t *dst, const uint32_t *src, int n)
+{
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; n >= 4; n -= 4, dst += 4, src += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)src);
+        __m128i d = _mm_loadu_si128((const __m128i *)dst);
+        __m128i lo = sse_scale(_mm_unpacklo_epi8(d, zero),
+                               _mm_unpacklo_epi8(s, zero));
+        __m128i hi = sse_scale(_mm_unpackhi_epi8(d, zero),
+                               _mm_unpackhi_epi8(s, zero));
+        d = _mm_add_epi8(s, _mm_packus_epi16(lo, hi));
+        _mm_storeu_si128((__m128i *)dst, d);
+    }
+#elif defined(__ARM_NEON)
+    for (; n >= 8; n -= 8, dst += 8, src += 8) {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)src);
+        uint8x8x4_t d = vld4_u8((const uint8_t *)dst);
+        uint8x8_t inv = vmvn_u8(s.val[3]);
+        for (int c = 0; c < 4; c++) {
+            uint16x8_t x = vmull_u8(d.val[c], inv);
+            x = vaddq_u16(vsraq_n_u16(x, x, 8), vdupq_n_u16(1));
+            d.val[c] = vadd_u8(s.val[c], vshrn_n_u16(x, 8));
+        }
+        vst4_u8((uint8_t *)dst, d);
+    }
+#endif
+    for (int i = 0; i < n; i++)
+        dst[i] = fb_blend_px(src[i], dst[i]);
+}
+
+/* ── Spans / rects ────────────────────────────────────────── */
+void fb_blend_span(uint32_t *dst, const uint32_t *src, int n)
+{
+    int i = 0;
+    while (i < n) {
+        uint32_t a = src[i] >> 24;
+        int j = i + 1;
+
+        if (a == 0xFF) {
+            while (j < n && (src[j] >> 24) == 0xFF)
+                j++;
+            memcpy(dst + i, src + i, (size_t)(j - i) * 4);
+        } else if (a == 0) {
+            while (j < n && (src[j] >> 24) == 0)
+                j++;
+        } else {
+            while (j < n && (a = src[j] >> 24) != 0 && a != 0xFF)
+                j++;
+            blend_run(dst + i, src + i, j - i);
+        }
+        i = j;
+    }
+}
+
+void fb_blend_rect(const struct fb_surface *s, int dx, int dy,
+                   const uint32_t *src, int sw, int sh)
+{
+    int sx = 0, sy = 0, w = sw, h = sh;
+    if (!fb_clip(s, &dx, &dy, &w, &h, &sx, &sy))
+        return;
+
+    const uint32_t *srow = src + (size_t)sy * sw + sx;
+    uint8_t *drow = (uint8_t *)(fb_row(s, dy) + dx);
+    for (int i = 0; i < h; i++, drow += s->stride, srow += sw)
+        fb_blend_span((uint32_t *)drow, srow, w);
+}
+
+void fb_blend_fill_rect(const struct fb_surface *s, int x, int y, int w, int h,
+                        uint32_t src)
+{
+    uint32_t a = src >> 24;
+
+    if (a == 0xFF) {
+        fb_fill_rect(s, x, y, w, h, src);
+        return;
+    }
+    if (a == 0 || !fb_clip(s, &x, &y, &w, &h, NULL, NULL))
+        return;
+
+    uint8_t *row = (uint8_t *)(fb_row(s, y) + x);
+    for (int i = 0; i < h; i++, row += s->stride) {
+        uint32_t *d = (uint32_t *)row;
+        for (int j = 0; j < w; j++)
+            d[j] = fb_blend_px(src, d[j]);
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * fb_blend.h — Division-free premultiplied "over" blending
+ *
+ * Sources are premultiplied ARGB8888 (every channel <= alpha), the same
+ * word layout as the framebuffer, so the inner loop never repacks:
+ *
+ *   dst' = src + dst * (255 - sa) / 255
+ *
+ * The divide is the exact reciprocal (x + 1 + (x >> 8)) >> 8, applied
+ * to the R/B and A/G channel pairs held side by side in one 32-bit
+ * register (SWAR) — two multiplies and no divides per pixel on rv32.
+ *
+ * Host builds with SSE2 or NEON (golden-image tools) pick a vector
+ * kernel computing the same expression lane-wise, so their output is
+ * bit-identical to the device's scalar path.
+ */
+#ifndef FB_BLEND_H
+#define FB_BLEND_H
+
+#include <stdint.h>
+
+#include "fb_span.h"
+
+/* One pixel; @src must be premultiplied */
+static inline uint32_t fb_blend_px(uint32_t src, uint32_t dst)
+{
+    uint32_t inv = 255 - (src >> 24);
+    uint32_t rb = (dst & 0x00FF00FF) * inv;
+    uint32_t ag = ((dst >> 8) & 0x00FF00FF) * inv;
+
+    rb = ((rb + 0x00010001 + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    ag =  (ag + 0x00010001 + ((ag >> 8) & 0x00FF00FF))       & 0xFF00FF00;
+    return src + (rb | ag);
+}
+
+/*
+ * Convert straight-alpha RGBA bytes (img2raw / PNG order) to
+ * premultiplied ARGB8888 words.  Done once per image, not per blit.
+ */
+void fb_blend_prepare_rgba(uint32_t *dst, const uint8_t *rgba, int n);
+
+/*
+ * Blend @n premultiplied pixels over @dst.  Runs of alpha 255 are
+ * copied, runs of alpha 0 skipped; only the rest is blended.
+ */
+void fb_blend_span(uint32_t *dst, const uint32_t *src, int n);
+
+/* Clipped blit of a premultiplied @sw × @sh image at (dx, dy) */
+void fb_blend_rect(const struct fb_surface *s, int dx, int dy,
+                   const uint32_t *src, int sw, int sh);
+
+/* Clipped fill with one premultiplied color */
+void fb_blend_fill_rect(const struct fb_surface *s, int x, int y, int w, int h,
+                        uint32_t src);
+
+#endif /* FB_BLEND_H */
@@ -0,0 +1,139 @@
+/*
+ * fb_damage.c — Per-frame dirty-rectangle accumulator
+ *
+ * Merge policy: a new rect is folded into an existing one when the
+ * union costs no more pixels than the two boxes flushed separately
+ * (plus one 64-pixel "row overhead" per extra rect — every clip rect
+ * is a separate TRANSFER_TO_HOST_2D on the virtio-gpu side).  When
+ * the list is full, the pair whose union grows the least is merged.
+ */
+#include "fb_damage.h"
+
+#define RECT_OVERHEAD  64   /* px — per-rect command cost, in pixel units */
+
+static inline long rect_area(const struct fb_rect *r)
+{
+    return (long)(r->x2 - r->x1) * (r->y2 - r->y1);
+}
+
+static inline struct fb_rect rect_union(const struct fb_rect *a,
+                                        const struct fb_rect *b)
+{
+    struct fb_rect u = {
+        a->x1 < b->x1 ? a->x1 : b->x1,
+        a->y1 < b->y1 ? a->y1 : b->y1,
+        a->x2 > b->x2 ? a->x2 : b->x2,
+        a->y2 > b->y2 ? a->y2 : b->y2,
+    };
+    return u;
+}
+
+static inline int rect_contains(const struct fb_rect *a, const struct fb_rect *b)
+{
+    return b->x1 >= a->x1 && b->y1 >= a->y1 && b->x2 <= a->x2 && b->y2 <= a->y2;
+}
+
+void fb_damage_init(struct fb_damage *d, int width, int height)
+{
+    d->width = width;
+    d->height = height;
+    d->count = 0;
+}
+
+void fb_damage_reset(struct fb_damage *d)
+{
+    d->count = 0;
+}
+
+static void damage_remove(struct fb_damage *d, int i)
+{
+    d->rects[i] = d->rects[--d->count];
+}
+
+/* Insert @r, absorbing every existing rect that is cheaper merged */
+static void damage_insert(struct fb_damage *d, struct fb_rect r)
+{
+    int merged;
+    do {
+        merged = 0;
+        for (int i = 0; i < d->count; i++) {
+            struct fb_rect u = rect_union(&d->rects[i], &r);
+            if (rect_area(&u) <= rect_area(&d->rects[i]) + rect_area(&r) + RECT_OVERHEAD) {
+                r = u;
+                damage_remove(d, i);
+                merged = 1;
+                break;
+            }
+        }
+    } while (merged && d->count > 0);
+
+    if (d->count < FB_DAMAGE_MAX_RECTS) {
+        d->rects[d->count++] = r;
+        return;
+    }
+
+    /* Full: merge @r with the neighbour whose union grows the least */
+    int best = 0;
+    long best_cost = -1;
+    for (int i = 0; i < d->count; i++) {
+        struct fb_rect u = rect_union(&d->rects[i], &r);
+        long cost = rect_area(&u) - rect_area(&d->rects[i]);
+        if (best_cost < 0 || cost < best_cost) {
+            best = i;
+            best_cost = cost;
+        }
+    }
+    struct fb_rect u = rect_union(&d->rects[best], &r);
+    damage_remove(d, best);
+    damage_insert(d, u);
+}
+
+void fb_damage_add(struct fb_damage *d, int x, int y, int w, int h)
+{
+    struct fb_rect r = { x, y, x + w, y + h };
+
+    if (r.x1 < 0) r.x1 = 0;
+    if (r.y1 < 0) r.y1 = 0;
+    if (r.x2 > d->width)  r.x2 = d->width;
+    if (r.y2 > d->height) r.y2 = d->height;
+    if (r.x1 >= r.x2 || r.y1 >= r.y2)
+        return;
+
+    for (int i = 0; i < d->count; i++)
+        if (rect_contains(&d->rects[i], &r))
+            return;
+
+    damage_insert(d, r);
+}
+
+void fb_damage_add_full(struct fb_damage *d)
+{
+    d->rects[0] = (struct fb_rect){ 0, 0, d->width, d->height };
+    d->count = 1;
+}
+
+int fb_damage_is_full(const struct fb_damage *d)
+{
+    return d->count == 1 &&
+           d->rects[0].x1 == 0 && d->rects[0].y1 == 0 &&
+           d->rects[0].x2 == d->width && d->rects[0].y2 == d->height;
+}
+
+long fb_damage_area(const struct fb_damage *d)
+{
+    long a = 0;
+    for (int i = 0; i < d->count; i++)
+        a += rect_area(&d->rects[i]);
+    return a;
+}
+
+void fb_damage_bounds(const struct fb_damage *d, struct fb_rect *out)
+{
+    if (d->count == 0) {
+        *out = (struct fb_rect){ 0, 0, 0, 0 };
+        return;
+    }
+    *out = d->rects[0];
+    for (int i = 1; i < d->count; i++)
+        *out = rect_union(out, &d->rects[i]);
+}
@@ -0,0 +1,35 @@
+/*
+ * fb_damage.h — Per-frame dirty-rectangle accumulator
+ *
+ * Every drawing primitive reports the rectangle it touched.  Rects
+ * are clipped to the screen and merged while they arrive, so a frame
+ * ends with at most FB_DAMAGE_MAX_RECTS boxes that the flush path
+ * can hand to the kernel (msync ranges, DRM FB_DAMAGE_CLIPS rects).
+ */
+#ifndef FB_DAMAGE_H
+#define FB_DAMAGE_H
+
+#define FB_DAMAGE_MAX_RECTS  16
+
+/* Half-open box: [x1, x2) × [y1, y2) — same as struct drm_clip_rect */
+struct fb_rect {
+    int x1, y1, x2, y2;
+};
+
+struct fb_damage {
+    int            width;
+    int            height;
+    int            count;
+    struct fb_rect rects[FB_DAMAGE_MAX_RECTS];
+};
+
+void fb_damage_init(struct fb_damage *d, int width, int height);
+void fb_damage_reset(struct fb_damage *d);
+void fb_damage_add(struct fb_damage *d, int x, int y, int w, int h);
+void fb_damage_add_full(struct fb_damage *d);
+
+int  fb_damage_is_full(const struct fb_damage *d);
+long fb_damage_area(const struct fb_damage *d);
+void fb_damage_bounds(const struct fb_damage *d, struct fb_rect *out);
+
+#endif /* FB_DAMAGE_H */
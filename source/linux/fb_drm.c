@@ -0,0 +1,457 @@
+/*
+ * fb_drm.c — DRM/KMS dumb-buffer backend with triple-buffered page flips
+ *
+ * SETCRTC for the mode, then atomic FB_ID + FB_DAMAGE_CLIPS commits on
+ * the primary plane when the driver offers them (legacy PAGE_FLIP, full
+ * transfer, otherwise) — no libdrm, so the static rv32 rootfs build
+ * needs nothing beyond the kernel UAPI headers.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include "fb_drm.h"
+
+#define U64_PTR(p)  ((uint64_t)(uintptr_t)(p))
+
+/* enum drm_plane_type is kernel-internal; these are its "type" values */
+#define DRM_PLANE_TYPE_PRIMARY  1
+
+/* ── Mode / pipe discovery ────────────────────────────────── */
+static int drm_find_pipe(struct fb_drm *d, int width, int height)
+{
+    struct drm_mode_card_res res;
+    uint32_t conns[8], crtcs[8];
+
+    memset(&res, 0, sizeof(res));
+    if (ioctl(d->fd, DRM_IOCTL_MODE_GETRESOURCES, &res) < 0) {
+        perror("DRM_IOCTL_MODE_GETRESOURCES");
+        return -1;
+    }
+    if (res.count_connectors > 8) res.count_connectors = 8;
+    if (res.count_crtcs > 8)      res.count_crtcs = 8;
+    res.count_fbs = 0;
+    res.count_encoders = 0;
+    res.connector_id_ptr = U64_PTR(conns);
+    res.crtc_id_ptr = U64_PTR(crtcs);
+    if (ioctl(d->fd, DRM_IOCTL_MODE_GETRESOURCES, &res) < 0) {
+        perror("DRM_IOCTL_MODE_GETRESOURCES");
+        return -1;
+    }
+
+    for (uint32_t c = 0; c < res.count_connectors; c++) {
+        struct drm_mode_get_connector conn;
+        struct drm_mode_modeinfo modes[16];
+
+        memset(&conn, 0, sizeof(conn));
+        conn.connector_id = conns[c];
+        if (ioctl(d->fd, DRM_IOCTL_MODE_GETCONNECTOR, &conn) < 0)
+            continue;
+        if (conn.connection != DRM_MODE_CONNECTED || conn.count_modes == 0)
+            continue;
+
+        if (conn.count_modes > 16) conn.count_modes = 16;
+        conn.count_props = 0;
+        conn.count_encoders = 0;
+        conn.modes_ptr = U64_PTR(modes);
+        if (ioctl(d->fd, DRM_IOCTL_MODE_GETCONNECTOR, &conn) < 0)
+            continue;
+
+        /* Prefer the mode that matches the render size */
+        int pick = -1;
+        for (uint32_t m = 0; m < conn.count_modes; m++) {
+            if (modes[m].hdisplay == width && modes[m].vdisplay == height) {
+                pick = (int)m;
+                break;
+            }
+        }
+        if (pick < 0) {
+            fprintf(stderr, "DRM: connector %u has no %dx%d mode\n",
+                    conns[c], width, height);
+            continue;
+        }
+
+        /* Current encoder's CRTC, else the first CRTC */
+        uint32_t crtc = res.count_crtcs ? crtcs[0] : 0;
+        if (conn.encoder_id) {
+            struct drm_mode_get_encoder enc;
+            memset(&enc, 0, sizeof(enc));
+            enc.encoder_id = conn.encoder_id;
+            if (ioctl(d->fd, DRM_IOCTL_MODE_GETENCODER, &enc) == 0 && enc.crtc_id)
+                crtc = enc.crtc_id;
+        }
+        if (!crtc)
+            continue;
+
+        d->crtc_index = -1;
+        for (uint32_t i = 0; i < res.count_crtcs; i++)
+            if (crtcs[i] == crtc)
+                d->crtc_index = (int)i;
+
+        d->conn_id = conns[c];
+        d->crtc_id = crtc;
+        d->mode = modes[pick];
+        return 0;
+    }
+
+    fprintf(stderr, "DRM: no connected output\n");
+    return -1;
+}
+
+/* ── Atomic plane properties ──────────────────────────────── */
+/* Property @name of plane @obj: id into *@id, current value into *@val */
+static int drm_plane_prop(struct fb_drm *d, uint32_t obj, const char *name,
+                          uint32_t *id, uint64_t *val)
+{
+    uint32_t props[32];
+    uint64_t values[32];
+    struct drm_mode_obj_get_properties op = {
+        .obj_id = obj, .obj_type = DRM_MODE_OBJECT_PLANE,
+    };
+
+    if (ioctl(d->fd, DRM_IOCTL_MODE_OBJ_GETPROPERTIES, &op) < 0)
+        return -1;
+    if (op.count_props > 32) op.count_props = 32;
+    op.props_ptr = U64_PTR(props);
+    op.prop_values_ptr = U64_PTR(values);
+    if (ioctl(d->fd, DRM_IOCTL_MODE_OBJ_GETPROPERTIES, &op) < 0)
+        return -1;
+
+    for (uint32_t i = 0; i < op.count_props; i++) {
+        struct drm_mode_get_property prop;
+        memset(&prop, 0, sizeof(prop));
+        prop.prop_id = props[i];
+        if (ioctl(d->fd, DRM_IOCTL_MODE_GETPROPERTY, &prop) < 0)
+            continue;
+        if (strncmp(prop.name, name, DRM_PROP_NAME_LEN) == 0) {
+            *id = props[i];
+            if (val)
+                *val = values[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Primary plane of our CRTC and its FB_ID / FB_DAMAGE_CLIPS properties.
+ * Leaves d->plane_id 0 (legacy page flips) unless all three are found.
+ */
+static void drm_find_plane(struct fb_drm *d)
+{
+    struct drm_set_client_cap cap = { .capability = DRM_CLIENT_CAP_ATOMIC, .value = 1 };
+    struct drm_mode_get_plane_res pres;
+    uint32_t planes[16];
+
+    d->plane_id = 0;
+    if (d->crtc_index < 0 || ioctl(d->fd, DRM_IOCTL_SET_CLIENT_CAP, &cap) < 0)
+        return;
+
+    memset(&pres, 0, sizeof(pres));
+    if (ioctl(d->fd, DRM_IOCTL_MODE_GETPLANERESOURCES, &pres) < 0)
+        return;
+    if (pres.count_planes > 16) pres.count_planes = 16;
+    pres.plane_id_ptr = U64_PTR(planes);
+    if (ioctl(d->fd, DRM_IOCTL_MODE_GETPLANERESOURCES, &pres) < 0)
+        return;
+
+    for (uint32_t p = 0; p < pres.count_planes; p++) {
+        struct drm_mode_get_plane plane;
+        uint32_t type_id;
+        uint64_t type;
+
+        memset(&plane, 0, sizeof(plane));
+        plane.plane_id = planes[p];
+        if (ioctl(d->fd, DRM_IOCTL_MODE_GETPLANE, &plane) < 0 ||
+            !(plane.possible_crtcs & (1u << d->crtc_index)))
+            continue;
+        if (drm_plane_prop(d, planes[p], "type", &type_id, &type) < 0 ||
+            type != DRM_PLANE_TYPE_PRIMARY)
+            continue;
+        if (drm_plane_prop(d, planes[p], "FB_ID", &d->prop_fb_id, NULL) < 0 ||
+            drm_plane_prop(d, planes[p], "FB_DAMAGE_CLIPS", &d->prop_damage, NULL) < 0)
+            return;
+        d->plane_id = planes[p];
+        return;
+    }
+}
+
+/* ── Dumb buffers ─────────────────────────────────────────── */
+static int drm_buf_create(struct fb_drm *d, struct fb_drm_buf *b,
+                          int width, int height)
+{
+    struct drm_mode_create_dumb creq = {
+        .width = width, .height = height, .bpp = 32,
+    };
+    if (ioctl(d->fd, DRM_IOCTL_MODE_CREATE_DUMB, &creq) < 0) {
+        perror("DRM_IOCTL_MODE_CREATE_DUMB");
+        return -1;
+    }
+    b->handle = creq.handle;
+    b->pitch = creq.pitch;
+    b->size = creq.size;
+
+    struct drm_mode_fb_cmd fcmd = {
+        .width = width, .height = height, .pitch = b->pitch,
+        .bpp = 32, .depth = 24, .handle = b->handle,
+    };
+    if (ioctl(d->fd, DRM_IOCTL_MODE_ADDFB, &fcmd) < 0) {
+        perror("DRM_IOCTL_MODE_ADDFB");
+        return -1;
+    }
+    b->fb_id = fcmd.fb_id;
+
+    struct drm_mode_map_dumb mreq = { .handle = b->handle };
+    if (ioctl(d->fd, DRM_IOCTL_MODE_MAP_DUMB, &mreq) < 0) {
+        perror("DRM_IOCTL_MODE_MAP_DUMB");
+        return -1;
+    }
+    b->map = mmap(NULL, b->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  d->fd, mreq.offset);
+    if (b->map == MAP_FAILED) {
+        perror("mmap dumb");
+        b->map = NULL;
+        return -1;
+    }
+    memset(b->map, 0, b->size);
+    return 0;
+}
+
+static void drm_buf_destroy(struct fb_drm *d, struct fb_drm_buf *b)
+{
+    if (b->map)
+        munmap(b->map, b->size);
+    if (b->fb_id)
+        ioctl(d->fd, DRM_IOCTL_MODE_RMFB, &b->fb_id);
+    if (b->handle) {
+        struct drm_mode_destroy_dumb dreq = { .handle = b->handle };
+        ioctl(d->fd, DRM_IOCTL_MODE_DESTROY_DUMB, &dreq);
+    }
+    memset(b, 0, sizeof(*b));
+}
+
+/* ── Open / close ─────────────────────────────────────────── */
+int fb_drm_open(struct fb_drm *d, const char *path, int width, int height)
+{
+    memset(d, 0, sizeof(*d));
+    d->fd = open(path ? path : "/dev/dri/card0", O_RDWR | O_CLOEXEC);
+    if (d->fd < 0) {
+        perror(path ? path : "/dev/dri/card0");
+        return -1;
+    }
+    /* First opener is master already; otherwise take it from fbdev */
+    ioctl(d->fd, DRM_IOCTL_SET_MASTER, 0);
+
+    if (drm_find_pipe(d, width, height) < 0)
+        goto fail;
+
+    d->saved_crtc.crtc_id = d->crtc_id;
+    ioctl(d->fd, DRM_IOCTL_MODE_GETCRTC, &d->saved_crtc);
+
+    for (int i = 0; i < FB_DRM_BUFS; i++)
+        if (drm_buf_create(d, &d->buf[i], width, height) < 0)
+            goto fail;
+
+    struct drm_mode_crtc crtc = {
+        .crtc_id = d->crtc_id,
+        .fb_id = d->buf[0].fb_id,
+        .set_connectors_ptr = U64_PTR(&d->conn_id),
+        .count_connectors = 1,
+        .mode = d->mode,
+        .mode_valid = 1,
+    };
+    if (ioctl(d->fd, DRM_IOCTL_MODE_SETCRTC, &crtc) < 0) {
+        perror("DRM_IOCTL_MODE_SETCRTC");
+        goto fail;
+    }
+
+    drm_find_plane(d);
+
+    d->front = d->last = 0;
+    d->back = 1;
+    d->pending = -1;
+    d->frame = 0;
+    for (int i = 0; i < FB_DRM_BUFS; i++)
+        fb_damage_init(&d->damage[i], width, height);
+    printf("DRM: %ux%u on crtc %u, pitch %u, %d dumb buffers, %s\n",
+           d->mode.hdisplay, d->mode.vdisplay, d->crtc_id, d->buf[0].pitch, FB_DRM_BUFS,
+           d->plane_id ? "atomic damage clips" : "legacy page flip");
+    return 0;
+
+fail:
+    fb_drm_close(d);
+    return -1;
+}
+
+void fb_drm_close(struct fb_drm *d)
+{
+    if (d->fd < 0)
+        return;
+
+    fb_drm_wait_flip(d, 100);
+
+    /* Hand the CRTC back to whatever ran before (fbcon) */
+    if (d->saved_crtc.fb_id) {
+        d->saved_crtc.set_connectors_ptr = U64_PTR(&d->conn_id);
+        d->saved_crtc.count_connectors = 1;
+        ioctl(d->fd, DRM_IOCTL_MODE_SETCRTC, &d->saved_crtc);
+    }
+    for (int i = 0; i < FB_DRM_BUFS; i++)
+        drm_buf_destroy(d, &d->buf[i]);
+
+    ioctl(d->fd, DRM_IOCTL_DROP_MASTER, 0);
+    close(d->fd);
+    d->fd = -1;
+}
+
+/* ── Page flipping ────────────────────────────────────────── */
+int fb_drm_wait_flip(struct fb_drm *d, int timeout_ms)
+{
+    while (d->pending >= 0) {
+        struct pollfd pfd = { .fd = d->fd, .events = POLLIN };
+        int r = poll(&pfd, 1, timeout_ms);
+        if (r <= 0) {
+            if (r < 0 && errno == EINTR)
+                continue;
+            fprintf(stderr, "DRM: page flip timeout\n");
+            d->front = d->pending;
+            d->pending = -1;
+            return -1;
+        }
+
+        char buf[256];
+        ssize_t len = read(d->fd, buf, sizeof(buf));
+        for (ssize_t off = 0; off + (ssize_t)sizeof(struct drm_event) <= len; ) {
+            struct drm_event *ev = (struct drm_event *)(buf + off);
+            if (ev->type == DRM_EVENT_FLIP_COMPLETE && d->pending >= 0) {
+                d->front = d->pending;
+                d->pending = -1;
+            }
+            off += ev->length;
+        }
+    }
+    return 0;
+}
+
+static void drm_copy_rect(struct fb_drm_buf *dst, const struct fb_drm_buf *src,
+                          const struct fb_rect *r)
+{
+    size_t bytes = (size_t)(r->x2 - r->x1) * 4;
+    for (int y = r->y1; y < r->y2; y++) {
+        size_t off = (size_t)y * dst->pitch + (size_t)r->x1 * 4;
+        memcpy(dst->map + off, src->map + off, bytes);
+    }
+}
+
+int fb_drm_begin_frame(struct fb_drm *d)
+{
+    /* Neither on screen nor queued; of those, the most recent one */
+    int pick = -1;
+    for (int i = 0; i < FB_DRM_BUFS; i++) {
+        if (i == d->front || i == d->pending)
+            continue;
+        if (pick < 0 || d->buf[i].frame > d->buf[pick].frame)
+            pick = i;
+    }
+    d->back = pick;
+
+    /* Bring it up to date with the newest presented frame */
+    const struct fb_drm_buf *newest = &d->buf[d->last];
+    struct fb_drm_buf *back = &d->buf[d->back];
+    unsigned age = d->frame - back->frame;
+    if (age >= FB_DRM_BUFS) {
+        struct fb_rect all = { 0, 0, d->damage[0].width, d->damage[0].height };
+        drm_copy_rect(back, newest, &all);
+    } else {
+        for (unsigned k = back->frame + 1; k <= d->frame; k++) {
+            const struct fb_damage *dmg = &d->damage[k % FB_DRM_BUFS];
+            for (int i = 0; i < dmg->count; i++)
+                drm_copy_rect(back, newest, &dmg->rects[i]);
+        }
+    }
+    return 0;
+}
+
+/* Atomic flip of plane_id to @b; partial @damage goes along as FB_DAMAGE_CLIPS */
+static int drm_commit_atomic(struct fb_drm *d, const struct fb_drm_buf *b,
+                             const struct fb_damage *damage)
+{
+    struct drm_mode_rect clips[FB_DAMAGE_MAX_RECTS];
+    struct drm_mode_create_blob blob = { 0 };
+    uint32_t props[2] = { d->prop_fb_id, d->prop_damage };
+    uint64_t values[2] = { b->fb_id, 0 };
+    uint32_t count = 1;
+
+    if (damage->count > 0 && !fb_damage_is_full(damage)) {
+        for (int i = 0; i < damage->count; i++) {
+            clips[i].x1 = damage->rects[i].x1;
+            clips[i].y1 = damage->rects[i].y1;
+            clips[i].x2 = damage->rects[i].x2;
+            clips[i].y2 = damage->rects[i].y2;
+        }
+        blob.data = U64_PTR(clips);
+        blob.length = (uint32_t)(damage->count * sizeof(clips[0]));
+        if (ioctl(d->fd, DRM_IOCTL_MODE_CREATEPROPBLOB, &blob) == 0) {
+            values[1] = blob.blob_id;
+            count = 2;
+        }
+    }
+
+    struct drm_mode_atomic req = {
+        .flags = DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK,
+        .count_objs = 1,
+        .objs_ptr = U64_PTR(&d->plane_id),
+        .count_props_ptr = U64_PTR(&count),
+        .props_ptr = U64_PTR(props),
+        .prop_values_ptr = U64_PTR(values),
+        .user_data = (uint64_t)d->back,
+    };
+    int ret = ioctl(d->fd, DRM_IOCTL_MODE_ATOMIC, &req);
+
+    /* The committed plane state holds its own reference to the blob */
+    if (blob.blob_id) {
+        struct drm_mode_destroy_blob dblob = { .blob_id = blob.blob_id };
+        ioctl(d->fd, DRM_IOCTL_MODE_DESTROYPROPBLOB, &dblob);
+    }
+    if (ret < 0) {
+        perror("DRM_IOCTL_MODE_ATOMIC");
+        return -1;
+    }
+    return 0;
+}
+
+int fb_drm_present(struct fb_drm *d, const struct fb_damage *damage)
+{
+    struct fb_drm_buf *b = &d->buf[d->back];
+
+    /* One flip per CRTC: the previous frame must have reached the screen */
+    if (fb_drm_wait_flip(d, 1000) < 0)
+        return -1;
+
+    if (d->plane_id) {
+        if (drm_commit_atomic(d, b, damage) < 0)
+            return -1;
+    } else {
+        struct drm_mode_crtc_page_flip flip = {
+            .crtc_id = d->crtc_id,
+            .fb_id = b->fb_id,
+            .flags = DRM_MODE_PAGE_FLIP_EVENT,
+            .user_data = (uint64_t)d->back,
+        };
+        if (ioctl(d->fd, DRM_IOCTL_MODE_PAGE_FLIP, &flip) < 0) {
+            perror("DRM_IOCTL_MODE_PAGE_FLIP");
+            return -1;
+        }
+    }
+    d->pending = d->last = d->back;
+    d->frame++;
+    d->damage[d->frame % FB_DRM_BUFS] = *damage;
+    b->frame = d->frame;
+    return 0;
+}
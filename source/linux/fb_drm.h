@@ -0,0 +1,97 @@
+/*
+ * fb_drm.h — DRM/KMS dumb-buffer backend with triple-buffered page flips
+ *
+ * Allocates three dumb buffers on the virtio-gpu card (/dev/dri/card0):
+ * one scanned out, one whose flip is queued and one being rendered.
+ * Frames are presented with an asynchronous flip + flip-complete event.
+ * Where the driver supports atomic modesetting and FB_DAMAGE_CLIPS on
+ * the primary plane (virtio-gpu does), the flip is an atomic FB_ID
+ * commit carrying the frame's damage rects, so only those are
+ * transferred to the host; otherwise it is a legacy
+ * DRM_IOCTL_MODE_PAGE_FLIP of the whole frame.
+ *
+ * Starting a frame never waits: the third buffer is free while flip N
+ * is in flight, so CPU (or Draw Engine) rendering of frame N+1 overlaps
+ * the scanout transfer.  KMS queues one flip per CRTC, so presenting
+ * frame N+1 waits for flip N to land.
+ *
+ * As DRM master the fbdev emulation stops committing, so fbcon no
+ * longer needs to be silenced with KD_GRAPHICS.
+ */
+#ifndef FB_DRM_H
+#define FB_DRM_H
+
+#include <stdint.h>
+#include <drm/drm.h>
+#include <drm/drm_mode.h>
+
+#include "fb_damage.h"
+
+#define FB_DRM_BUFS  3
+
+struct fb_drm_buf {
+    unsigned  frame;        /* last frame presented from it; 0 = blank */
+    uint32_t  handle;
+    uint32_t  fb_id;
+    uint32_t  pitch;
+    uint64_t  size;
+    uint8_t  *map;
+};
+
+struct fb_drm {
+    int                      fd;
+    uint32_t                 conn_id;
+    uint32_t                 crtc_id;
+    int                      crtc_index;   /* bit in possible_crtcs */
+    uint32_t                 plane_id;     /* primary plane; 0 = legacy flips */
+    uint32_t                 prop_fb_id;
+    uint32_t                 prop_damage;  /* FB_DAMAGE_CLIPS */
+    struct drm_mode_modeinfo mode;
+    struct drm_mode_crtc     saved_crtc;   /* restored on close */
+
+    struct fb_drm_buf        buf[FB_DRM_BUFS];
+    int                      back;          /* index being rendered */
+    int                      front;         /* index scanned out */
+    int                      pending;       /* index whose flip is queued; -1 = none */
+    int                      last;          /* index of the newest presented frame */
+    unsigned                 frame;         /* frames presented so far */
+
+    /* Damage of the last FB_DRM_BUFS frames, frame k at [k % FB_DRM_BUFS]:
+     * replayed into the back buffer so partial redraws stay coherent
+     * ("buffer age"). */
+    struct fb_damage         damage[FB_DRM_BUFS];
+};
+
+int  fb_drm_open(struct fb_drm *d, const char *path, int width, int height);
+void fb_drm_close(struct fb_drm *d);
+
+/* Back buffer for the frame being built (valid after fb_drm_begin_frame) */
+static inline uint8_t *fb_drm_back(struct fb_drm *d)
+{
+    return d->buf[d->back].map;
+}
+
+static inline uint32_t fb_drm_pitch(const struct fb_drm *d)
+{
+    return d->buf[d->back].pitch;
+}
+
+/*
+ * Pick the buffer that is neither scanned out nor queued as the back
+ * buffer, and copy the damage of every frame it missed from the newest
+ * presented frame into it.  Does not wait for the pending flip.
+ */
+int  fb_drm_begin_frame(struct fb_drm *d);
+
+/*
+ * Queue the back buffer for scanout.  A partial @damage is sent as the
+ * commit's FB_DAMAGE_CLIPS (atomic path only) and remembered for later
+ * begin_frames.  Waits for the previous flip (if still queued), then
+ * returns; this flip completes asynchronously.
+ */
+int  fb_drm_present(struct fb_drm *d, const struct fb_damage *damage);
+
+/* Block until the outstanding flip (if any) has completed */
+int  fb_drm_wait_flip(struct fb_drm *d, int timeout_ms);
+
+#endif /* FB_DRM_H */
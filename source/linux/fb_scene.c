@@ -0,0 +1,153 @@
+/*
+ * fb_scene.c — Line-oriented scene command stream for fb_tux
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fb_scene.h"
+
+enum { COLOR_NONE, COLOR_OPT, COLOR_REQ };
+
+static const struct {
+    const char       *name;
+    enum fb_scene_op  op;
+    int               nargs;
+    int               color;
+} scene_ops[] = {
+    { "color",   FB_SCENE_COLOR,   0, COLOR_REQ  },
+    { "clear",   FB_SCENE_CLEAR,   0, COLOR_OPT  },
+    { "rect",    FB_SCENE_RECT,    4, COLOR_OPT  },
+    { "blend",   FB_SCENE_BLEND,   5, COLOR_OPT  },
+    { "tri",     FB_SCENE_TRI,     6, COLOR_OPT  },
+    { "ellipse", FB_SCENE_ELLIPSE, 4, COLOR_OPT  },
+    { "line",    FB_SCENE_LINE,    4, COLOR_OPT  },
+    { "logo",    FB_SCENE_LOGO,    2, COLOR_NONE },
+    { "key",     FB_SCENE_KEY,     0, COLOR_REQ  },     /* or "off" */
+    { "text",    FB_SCENE_TEXT,    2, COLOR_NONE },     /* + string */
+    { "tux",     FB_SCENE_TUX,     0, COLOR_NONE },
+    { "flush",   FB_SCENE_FLUSH,   0, COLOR_NONE },
+    { "quit",    FB_SCENE_QUIT,    0, COLOR_NONE },
+};
+
+/* Next whitespace-separated token; *p advances past it */
+static const char *next_tok(const char **p, size_t *len)
+{
+    const char *s = *p;
+    while (*s && isspace((unsigned char)*s))
+        s++;
+    const char *e = s;
+    while (*e && !isspace((unsigned char)*e))
+        e++;
+    *p = e;
+    *len = (size_t)(e - s);
+    return *len ? s : NULL;
+}
+
+/* RRGGBB → opaque, AARRGGBB as given; optional 0x / # prefix */
+static int parse_color(const char *s, size_t len, uint32_t *out)
+{
+    char buf[16];
+    if (len >= sizeof(buf))
+        return -1;
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+
+    const char *h = buf;
+    if (*h == '#')
+        h++;
+    else if (h[0] == '0' && (h[1] == 'x' || h[1] == 'X'))
+        h += 2;
+
+    size_t digits = strlen(h);
+    char *end;
+    unsigned long v = strtoul(h, &end, 16);
+    if (digits == 0 || digits > 8 || *end != '\0')
+        return -1;
+    *out = (uint32_t)v | (digits <= 6 ? 0xFF000000u : 0);
+    return 0;
+}
+
+static int parse_int(const char *s, size_t len, int *out)
+{
+    char buf[16];
+    if (len >= sizeof(buf))
+        return -1;
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+
+    char *end;
+    long v = strtol(buf, &end, 10);
+    if (*end != '\0')
+        return -1;
+    *out = (int)v;
+    return 0;
+}
+
+int fb_scene_parse(const char *line, struct fb_scene_cmd *cmd,
+                   char *err, size_t errlen)
+{
+    const char *p = line;
+    size_t len;
+    const char *tok = next_tok(&p, &len);
+
+    if (!tok || *tok == '#')
+        return 0;
+
+    size_t i, n = sizeof(scene_ops) / sizeof(scene_ops[0]);
+    for (i = 0; i < n; i++)
+        if (strlen(scene_ops[i].name) == len && !memcmp(scene_ops[i].name, tok, len))
+            break;
+    if (i == n) {
+        snprintf(err, errlen, "unknown command '%.*s'", (int)len, tok);
+        return -1;
+    }
+
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->op = scene_ops[i].op;
+
+    for (int a = 0; a < scene_ops[i].nargs; a++) {
+        tok = next_tok(&p, &len);
+        if (!tok || parse_int(tok, len, &cmd->arg[a]) < 0) {
+            snprintf(err, errlen, "%s: expected %d integer arguments",
+                     scene_ops[i].name, scene_ops[i].nargs);
+            return -1;
+        }
+    }
+
+    if (cmd->op == FB_SCENE_TEXT) {
+        /* Rest of the line, minus the separator and trailing newline */
+        if (*p)
+            p++;
+        size_t tl = strcspn(p, "\r\n");
+        if (tl >= sizeof(cmd->text))
+            tl = sizeof(cmd->text) - 1;
+        memcpy(cmd->text, p, tl);
+        cmd->text[tl] = '\0';
+        return 1;
+    }
+
+    tok = next_tok(&p, &len);
+    if (cmd->op == FB_SCENE_KEY && tok && len == 3 && !memcmp(tok, "off", 3))
+        return 1;       /* has_color == 0: keying off */
+
+    if (tok) {
+        if (scene_ops[i].color == COLOR_NONE ||
+            parse_color(tok, len, &cmd->color) < 0) {
+            snprintf(err, errlen, "%s: bad argument '%.*s'",
+                     scene_ops[i].name, (int)len, tok);
+            return -1;
+        }
+        cmd->has_color = 1;
+    } else if (scene_ops[i].color == COLOR_REQ) {
+        snprintf(err, errlen, "%s: color required", scene_ops[i].name);
+        return -1;
+    }
+
+    if (next_tok(&p, &len)) {
+        snprintf(err, errlen, "%s: too many arguments", scene_ops[i].name);
+        return -1;
+    }
+    return 1;
+}
@@ -0,0 +1,64 @@
+/*
+ * fb_scene.h — Line-oriented scene command stream for fb_tux
+ *
+ * One primitive per line, '#' starts a comment.  Coordinates are
+ * decimal; colors are hex RRGGBB (opaque) or AARRGGBB.  A primitive
+ * without a color uses the one last set with "color".
+ *
+ *   color C                     current color
+ *   clear [C]                   whole screen
+ *   rect X Y W H [C]            opaque fill
+ *   blend X Y W H A [C]         fill at constant alpha A (0-255)
+ *   tri X0 Y0 X1 Y1 X2 Y2 [C]   filled triangle
+ *   ellipse CX CY RX RY [C]     filled ellipse
+ *   line X0 Y0 X1 Y1 [C]        1-pixel line, both ends included
+ *   logo X Y                    boot logo, top-left corner at (X, Y)
+ *   key C | key off             color key for logo: pixels == C skipped
+ *   text X Y STRING...          8x16 text, transparent background
+ *   tux                         vector Tux
+ *   flush                       present everything since the last flush
+ *   quit                        end of stream (daemon: shut down)
+ *
+ * Parsing only; fb_tux executes the commands on the CPU or as one
+ * Draw Engine display list per flush.
+ */
+#ifndef FB_SCENE_H
+#define FB_SCENE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FB_SCENE_LINE_MAX  512
+
+enum fb_scene_op {
+    FB_SCENE_COLOR,
+    FB_SCENE_CLEAR,
+    FB_SCENE_RECT,
+    FB_SCENE_BLEND,
+    FB_SCENE_TRI,
+    FB_SCENE_ELLIPSE,
+    FB_SCENE_LINE,
+    FB_SCENE_LOGO,
+    FB_SCENE_KEY,
+    FB_SCENE_TEXT,
+    FB_SCENE_TUX,
+    FB_SCENE_FLUSH,
+    FB_SCENE_QUIT,
+};
+
+struct fb_scene_cmd {
+    enum fb_scene_op op;
+    int       arg[6];
+    int       has_color;
+    uint32_t  color;
+    char      text[FB_SCENE_LINE_MAX];  /* FB_SCENE_TEXT */
+};
+
+/*
+ * Decode one line.  Returns 1 for a command, 0 for a blank or comment
+ * line, -1 on a syntax error (message in @err).
+ */
+int fb_scene_parse(const char *line, struct fb_scene_cmd *cmd,
+                   char *err, size_t errlen);
+
+#endif /* FB_SCENE_H */
@@ -0,0 +1,149 @@
+/*
+ * fb_shape.c — Integer scanline generators for filled shapes
+ */
+#include <stdint.h>
+
+#include "fb_shape.h"
+
+/* ── Ellipse ──────────────────────────────────────────────── */
+void fb_ellipse_spans(int cx, int cy, int rx, int ry,
+                      fb_span_cb cb, void *ctx)
+{
+    if (rx < 0 || ry < 0)
+        return;
+
+    int64_t a2 = (int64_t)rx * rx;
+    int64_t b2 = (int64_t)ry * ry;
+    int64_t lim = a2 * b2;
+
+    /*
+     * Walk outwards from the centre row.  The half-width only ever
+     * shrinks as |dy| grows, so x is stepped down in place and the
+     * whole shape costs O(rx + ry) tests rather than O(rx * ry).
+     */
+    int x = rx;
+    for (int dy = 0; dy <= ry; dy++) {
+        int64_t yy = a2 * dy * dy;
+        while (x > 0 && b2 * x * x + yy > lim)
+            x--;
+        cb(ctx, cy - dy, cx - x, cx + x);
+        if (dy)
+            cb(ctx, cy + dy, cx - x, cx + x);
+    }
+}
+
+/* ── Triangle ─────────────────────────────────────────────── */
+/* x(y) = xa + floor((xb - xa) * (y - ya) / (yb - ya)), one step per row */
+struct edge {
+    int x;
+    int step;   /* floor(dx / dy) */
+    int rem;    /* dx - step * dy, in [0, dy) */
+    int err;
+    int dy;
+};
+
+static void edge_init(struct edge *e, int xa, int ya, int xb, int yb)
+{
+    int dx = xb - xa;
+
+    e->x = xa;
+    e->err = 0;
+    e->dy = yb - ya;
+    if (e->dy <= 0) {
+        e->step = e->rem = 0;
+        return;
+    }
+    e->step = dx / e->dy;
+    e->rem = dx % e->dy;
+    if (e->rem < 0) {
+        e->step--;
+        e->rem += e->dy;
+    }
+}
+
+static inline void edge_next(struct edge *e)
+{
+    e->x += e->step;
+    e->err += e->rem;
+    if (e->err >= e->dy && e->dy > 0) {
+        e->x++;
+        e->err -= e->dy;
+    }
+}
+
+#define SWAP_PT(xa, ya, xb, yb) do {            \
+        int tx = xa, ty = ya;                   \
+        xa = xb; ya = yb; xb = tx; yb = ty;     \
+    } while (0)
+
+void fb_triangle_spans(int x0, int y0, int x1, int y1, int x2, int y2,
+                       fb_span_cb cb, void *ctx)
+{
+    /* Sort by y: y0 <= y1 <= y2 */
+    if (y1 < y0) SWAP_PT(x0, y0, x1, y1);
+    if (y2 < y0) SWAP_PT(x0, y0, x2, y2);
+    if (y2 < y1) SWAP_PT(x1, y1, x2, y2);
+
+    /* Degenerate: all three on one row, the edges would only see x0, x1 */
+    if (y0 == y2) {
+        int a = x0 < x1 ? x0 : x1, b = x0 < x1 ? x1 : x0;
+        cb(ctx, y0, a < x2 ? a : x2, b > x2 ? b : x2);
+        return;
+    }
+
+    struct edge lng, shr;
+    edge_init(&lng, x0, y0, x2, y2);
+    edge_init(&shr, x0, y0, x1, y1);
+
+    for (int y = y0; y <= y2; y++) {
+        if (y == y1)
+            edge_init(&shr, x1, y1, x2, y2);
+
+        /*
+         * Floor on the left, ceil on the right: the span covers every
+         * pixel an edge passes through, so mirrored shapes stay
+         * mirrored.
+         */
+        int a = lng.x, b = shr.x;
+        int a_up = a + (lng.err != 0), b_up = b + (shr.err != 0);
+        if (a <= b)
+            cb(ctx, y, a, b_up);
+        else
+            cb(ctx, y, b, a_up);
+
+        edge_next(&lng);
+        edge_next(&shr);
+    }
+}
+
+/* ── Line ─────────────────────────────────────────────────── */
+void fb_line_spans(int x0, int y0, int x1, int y1,
+                   fb_span_cb cb, void *ctx)
+{
+    int dx = x1 > x0 ? x1 - x0 : x0 - x1, sx = x0 < x1 ? 1 : -1;
+    int dy = y1 > y0 ? y0 - y1 : y1 - y0, sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+
+    /* Pixels that share a row are handed out as one span */
+    int ry = y0, ra = x0, rb = x0;
+    for (int x = x0, y = y0;;) {
+        if (y != ry) {
+            cb(ctx, ry, ra < rb ? ra : rb, ra < rb ? rb : ra);
+            ry = y;
+            ra = x;
+        }
+        rb = x;
+        if (x == x1 && y == y1)
+            break;
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+    cb(ctx, ry, ra < rb ? ra : rb, ra < rb ? rb : ra);
+}
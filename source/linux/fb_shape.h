@@ -0,0 +1,31 @@
+/*
+ * fb_shape.h — Integer scanline generators for filled shapes
+ *
+ * Each generator works out a row's x-extent once and hands the whole
+ * span to a callback — fb_hspan() for the CPU, one PATBLT per span
+ * for the Draw Engine.  Integer arithmetic only: the rootfs is built
+ * for a target where every float compare is a libgcc soft-float call.
+ */
+#ifndef FB_SHAPE_H
+#define FB_SHAPE_H
+
+/* One span [x1, x2] (inclusive) on row y */
+typedef void (*fb_span_cb)(void *ctx, int y, int x1, int x2);
+
+/*
+ * Filled axis-aligned ellipse: every (x, y) with
+ * (x/rx)² + (y/ry)² <= 1, i.e. x²·ry² + y²·rx² <= rx²·ry².
+ * rx == ry gives a disc.
+ */
+void fb_ellipse_spans(int cx, int cy, int rx, int ry,
+                      fb_span_cb cb, void *ctx);
+
+/* Filled triangle, edges stepped with an exact integer DDA */
+void fb_triangle_spans(int x0, int y0, int x1, int y1, int x2, int y2,
+                       fb_span_cb cb, void *ctx);
+
+/* 1-pixel Bresenham line, both ends included; one span per row run */
+void fb_line_spans(int x0, int y0, int x1, int y1,
+                   fb_span_cb cb, void *ctx);
+
+#endif /* FB_SHAPE_H */
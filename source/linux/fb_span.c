@@ -0,0 +1,110 @@
+/*
+ * fb_span.c — Clipped span rasterizer over a strided 32bpp surface
+ */
+#include <string.h>
+
+#include "fb_span.h"
+
+int fb_clip(const struct fb_surface *s, int *x, int *y, int *w, int *h,
+            int *sx, int *sy)
+{
+    int x1 = *x, y1 = *y, x2 = *x + *w, y2 = *y + *h;
+
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 > s->width)  x2 = s->width;
+    if (y2 > s->height) y2 = s->height;
+    if (x1 >= x2 || y1 >= y2)
+        return 0;
+
+    if (sx) *sx += x1 - *x;
+    if (sy) *sy += y1 - *y;
+    *x = x1;
+    *y = y1;
+    *w = x2 - x1;
+    *h = y2 - y1;
+    return 1;
+}
+
+/* 32-bit memset, 8 stores per iteration */
+void fb_span_fill(uint32_t *dst, uint32_t color, int n)
+{
+    while (n >= 8) {
+        dst[0] = color; dst[1] = color; dst[2] = color; dst[3] = color;
+        dst[4] = color; dst[5] = color; dst[6] = color; dst[7] = color;
+        dst += 8;
+        n -= 8;
+    }
+    while (n-- > 0)
+        *dst++ = color;
+}
+
+void fb_span_copy(uint32_t *dst, const uint32_t *src, int n)
+{
+    memcpy(dst, src, (size_t)n * 4);
+}
+
+/* Color-keyed copy (stencil): pixels equal to @key stay untouched */
+void fb_span_copy_key(uint32_t *dst, const uint32_t *src, int n, uint32_t key)
+{
+    for (int i = 0; i < n; i++)
+        if (src[i] != key)
+            dst[i] = src[i];
+}
+
+void fb_fill_rect(const struct fb_surface *s, int x, int y, int w, int h,
+                  uint32_t color)
+{
+    if (!fb_clip(s, &x, &y, &w, &h, NULL, NULL))
+        return;
+
+    uint8_t *row = (uint8_t *)(fb_row(s, y) + x);
+
+    /* Whole rows with a byte-uniform color: one memset per frame */
+    uint8_t b = color & 0xFF;
+    if (x == 0 && w == s->width && w * 4 == s->stride &&
+        color == b * 0x01010101u) {
+        memset(row, b, (size_t)h * s->stride);
+        return;
+    }
+
+    for (int i = 0; i < h; i++, row += s->stride)
+        fb_span_fill((uint32_t *)row, color, w);
+}
+
+void fb_copy_rect(const struct fb_surface *s, int dx, int dy, int w, int h,
+                  const uint32_t *src, int src_stride_px)
+{
+    int sx = 0, sy = 0;
+    if (!fb_clip(s, &dx, &dy, &w, &h, &sx, &sy))
+        return;
+
+    const uint32_t *srow = src + (size_t)sy * src_stride_px + sx;
+    uint8_t *drow = (uint8_t *)(fb_row(s, dy) + dx);
+    for (int i = 0; i < h; i++, drow += s->stride, srow += src_stride_px)
+        fb_span_copy((uint32_t *)drow, srow, w);
+}
+
+void fb_copy_rect_key(const struct fb_surface *s, int dx, int dy, int w, int h,
+                      const uint32_t *src, int src_stride_px, uint32_t key)
+{
+    int sx = 0, sy = 0;
+    if (!fb_clip(s, &dx, &dy, &w, &h, &sx, &sy))
+        return;
+
+    const uint32_t *srow = src + (size_t)sy * src_stride_px + sx;
+    uint8_t *drow = (uint8_t *)(fb_row(s, dy) + dx);
+    for (int i = 0; i < h; i++, drow += s->stride, srow += src_stride_px)
+        fb_span_copy_key((uint32_t *)drow, srow, w, key);
+}
+
+void fb_hspan(const struct fb_surface *s, int y, int x1, int x2, uint32_t color)
+{
+    if (y < 0 || y >= s->height)
+        return;
+    if (x1 < 0) x1 = 0;
+    if (x2 >= s->width) x2 = s->width - 1;
+    if (x1 > x2)
+        return;
+    fb_span_fill(fb_row(s, y) + x1, color, x2 - x1 + 1);
+}
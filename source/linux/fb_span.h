@@ -0,0 +1,53 @@
+/*
+ * fb_span.h — Clipped span rasterizer over a strided 32bpp surface
+ *
+ * Primitives clip their rectangle against the surface once, then walk
+ * row pointers (base + y * stride, using the real line_length / DRM
+ * pitch) and hand each row to a span kernel.  No per-pixel bounds
+ * check, no per-pixel y * width multiply.
+ */
+#ifndef FB_SPAN_H
+#define FB_SPAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct fb_surface {
+    uint8_t *base;
+    int      width;
+    int      height;
+    int      stride;    /* bytes per row */
+};
+
+static inline uint32_t *fb_row(const struct fb_surface *s, int y)
+{
+    return (uint32_t *)(s->base + (size_t)y * s->stride);
+}
+
+/*
+ * Clip [x, x+w) × [y, y+h) to the surface.  Returns 0 when nothing is
+ * left; otherwise updates the box in place and, if @sx/@sy are given,
+ * advances them by the amount cut from the left/top (source offsets
+ * for blits).
+ */
+int  fb_clip(const struct fb_surface *s, int *x, int *y, int *w, int *h,
+             int *sx, int *sy);
+
+/* Span kernels */
+void fb_span_fill(uint32_t *dst, uint32_t color, int n);
+void fb_span_copy(uint32_t *dst, const uint32_t *src, int n);
+void fb_span_copy_key(uint32_t *dst, const uint32_t *src, int n, uint32_t key);
+
+/* Clipped rectangle ops */
+void fb_fill_rect(const struct fb_surface *s, int x, int y, int w, int h,
+                  uint32_t color);
+void fb_copy_rect(const struct fb_surface *s, int dx, int dy, int w, int h,
+                  const uint32_t *src, int src_stride_px);
+/* As fb_copy_rect, but source pixels equal to @key are left out */
+void fb_copy_rect_key(const struct fb_surface *s, int dx, int dy, int w, int h,
+                      const uint32_t *src, int src_stride_px, uint32_t key);
+
+/* Horizontal span [x1, x2] inclusive on row y, clipped */
+void fb_hspan(const struct fb_surface *s, int y, int x1, int x2, uint32_t color);
+
+#endif /* FB_SPAN_H */
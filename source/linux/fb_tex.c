@@ -0,0 +1,91 @@
+/*
+ * fb_tex.c — Pre-expanded ARGB8888 texture cache
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fb_tex.h"
+
+int fb_tex_alloc(struct fb_tex *t, int w, int h, void *vram, uint32_t phys)
+{
+    memset(t, 0, sizeof(*t));
+    if (vram) {
+        t->pixels = vram;
+        t->phys = phys;
+    } else {
+        t->pixels = malloc((size_t)w * h * 4);
+        if (!t->pixels) {
+            fprintf(stderr, "fb_tex: out of memory (%dx%d)\n", w, h);
+            return -1;
+        }
+        t->owned = 1;
+    }
+    t->width = w;
+    t->height = h;
+    return 0;
+}
+
+void fb_tex_free(struct fb_tex *t)
+{
+    if (t->owned)
+        free(t->pixels);
+    memset(t, 0, sizeof(*t));
+}
+
+static void clut_expand(uint32_t *pal, int n, const uint8_t *clut_rgb, int clut_len)
+{
+    for (int i = 0; i < n; i++) {
+        const uint8_t *c = clut_rgb + (i < clut_len ? i : 0) * 3;
+        pal[i] = 0xFF000000 | ((uint32_t)c[0] << 16) |
+                 ((uint32_t)c[1] << 8) | c[2];
+    }
+}
+
+void fb_tex_load_clut(struct fb_tex *t, const uint8_t *idx,
+                      const uint8_t *clut_rgb, int clut_len)
+{
+    /* Expand the palette first: one table read per pixel after that */
+    uint32_t pal[256];
+    clut_expand(pal, 256, clut_rgb, clut_len);
+
+    size_t n = (size_t)t->width * t->height;
+    for (size_t i = 0; i < n; i++)
+        t->pixels[i] = pal[idx[i]];
+}
+
+void fb_tex_load_rgb888(struct fb_tex *t, const uint8_t *rgb)
+{
+    size_t n = (size_t)t->width * t->height;
+    for (size_t i = 0; i < n; i++, rgb += 3)
+        t->pixels[i] = 0xFF000000 | ((uint32_t)rgb[0] << 16) |
+                       ((uint32_t)rgb[1] << 8) | rgb[2];
+}
+
+int fb_tex_load_clut8(struct fb_tex *t, const uint8_t *idx,
+                      const uint8_t *clut_rgb, int clut_len)
+{
+    uint32_t stride = draw_tex_stride(t->width, DRAW_TEX_CLUT8);
+    uint32_t pal_off = (stride * t->height + 63) & ~63u;
+    uint8_t *base = (uint8_t *)t->pixels;
+
+    if (!t->phys || clut_len < 1 || clut_len > 256)
+        return -1;
+    for (int y = 0; y < t->height; y++) {
+        memcpy(base + (size_t)y * stride, idx + (size_t)y * t->width, t->width);
+        memset(base + (size_t)y * stride + t->width, 0, stride - t->width);
+    }
+    clut_expand((uint32_t *)(base + pal_off), clut_len, clut_rgb, clut_len);
+
+    t->format = DRAW_TEX_CLUT8;
+    t->palette = t->phys + pal_off;
+    t->palette_len = clut_len;
+    return 0;
+}
+
+void fb_tex_bind(struct draw_dl *dl, const struct fb_tex *t)
+{
+    if (t->format == DRAW_TEX_CLUT8)
+        draw_dl_setpalette(dl, t->palette, t->palette_len);
+    draw_dl_settexture_fmt(dl, t->phys, t->width, t->height, t->format);
+}
@@ -0,0 +1,69 @@
+/*
+ * fb_tex.h — Pre-expanded ARGB8888 texture cache
+ *
+ * Images stored in a compact source format (CLUT224 indices, RGB888)
+ * are expanded once into a 32bpp surface; every later draw is a row
+ * memcpy (fb_copy_rect) or, when the pixels live in VRAM, a single
+ * Draw Engine BITBLT from @phys.  An engine with DRAW_CAPS_TEXFMT
+ * expands CLUT8 itself, so a VRAM texture can also stay packed: a
+ * quarter of the space and of the read traffic, no CPU expansion.
+ */
+#ifndef FB_TEX_H
+#define FB_TEX_H
+
+#include <stdint.h>
+
+#include "draw_dl.h"
+#include "fb_span.h"
+
+struct fb_tex {
+    uint32_t *pixels;   /* width × height, tightly packed */
+    int       width;
+    int       height;
+    uint32_t  phys;     /* VRAM address for SETTEXTURE, 0 = heap only */
+    int       owned;    /* pixels were malloc'ed by fb_tex_alloc */
+    int       format;   /* DRAW_TEX_*; only ARGB8888 can be drawn by the CPU */
+    uint32_t  palette;  /* CLUT8: VRAM address of the ARGB8888 palette */
+    int       palette_len;
+};
+
+/*
+ * Reserve storage for a @w × @h texture.  With @vram == NULL the
+ * pixels come from the heap (CPU blits: cached memory reads fast);
+ * otherwise @vram must map @phys inside the Draw Engine's reach.
+ */
+int  fb_tex_alloc(struct fb_tex *t, int w, int h, void *vram, uint32_t phys);
+void fb_tex_free(struct fb_tex *t);
+
+/* Expanders: fill the whole texture, alpha forced to 0xFF */
+void fb_tex_load_clut(struct fb_tex *t, const uint8_t *idx,
+                      const uint8_t *clut_rgb, int clut_len);
+void fb_tex_load_rgb888(struct fb_tex *t, const uint8_t *rgb);
+
+/*
+ * Store the indices as they are (rows padded to 32 bits) with the
+ * palette behind them, for the engine to expand.  VRAM textures only;
+ * needs well under the w × h × 4 bytes fb_tex_alloc reserved.
+ */
+int  fb_tex_load_clut8(struct fb_tex *t, const uint8_t *idx,
+                       const uint8_t *clut_rgb, int clut_len);
+
+/* SETTEXTURE (and SETPALETTE for CLUT8) selecting VRAM texture @t */
+void fb_tex_bind(struct draw_dl *dl, const struct fb_tex *t);
+
+/* Opaque blit of the whole texture at (x, y), clipped */
+static inline void fb_tex_draw(const struct fb_surface *s,
+                               const struct fb_tex *t, int x, int y)
+{
+    fb_copy_rect(s, x, y, t->width, t->height, t->pixels, t->width);
+}
+
+/* Same, skipping texels equal to @key (stencil / color key) */
+static inline void fb_tex_draw_keyed(const struct fb_surface *s,
+                                     const struct fb_tex *t, int x, int y,
+                                     uint32_t key)
+{
+    fb_copy_rect_key(s, x, y, t->width, t->height, t->pixels, t->width, key);
+}
+
+#endif /* FB_TEX_H */
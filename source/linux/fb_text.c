@@ -0,0 +1,144 @@
+/*
+ * fb_text.c — 8x16 text renderer: mask-table CPU path + VRAM glyph atlas
+ */
+#include <string.h>
+#include <sys/mman.h>
+
+#include "font_8x16_data.h"
+#include "fb_text.h"
+
+/* ── Byte → 8 pixel masks ─────────────────────────────────── */
+static uint32_t mask8[256][8];
+static int mask8_ready;
+
+static void mask8_init(void)
+{
+    if (mask8_ready)
+        return;
+    for (int b = 0; b < 256; b++)
+        for (int i = 0; i < 8; i++)
+            mask8[b][i] = (b & (0x80 >> i)) ? 0xFFFFFFFFu : 0;
+    mask8_ready = 1;
+}
+
+/* ── CPU path ─────────────────────────────────────────────── */
+static void glyph_full(uint32_t *dst, int stride_px, const uint8_t *glyph,
+                       uint32_t fg, uint32_t bg, unsigned flags)
+{
+    if (flags & FB_TEXT_TRANSPARENT) {
+        for (int row = 0; row < FB_GLYPH_H; row++, dst += stride_px) {
+            uint8_t bits = glyph[row];
+            if (!bits)
+                continue;
+            const uint32_t *m = mask8[bits];
+            for (int i = 0; i < 8; i++)
+                dst[i] ^= (dst[i] ^ fg) & m[i];
+        }
+    } else {
+        uint32_t diff = fg ^ bg;
+        for (int row = 0; row < FB_GLYPH_H; row++, dst += stride_px) {
+            const uint32_t *m = mask8[glyph[row]];
+            for (int i = 0; i < 8; i++)
+                dst[i] = bg ^ (diff & m[i]);
+        }
+    }
+}
+
+/* Glyph straddling the surface edge: same selects, clipped box */
+static void glyph_clipped(const struct fb_surface *s, int x, int y,
+                          const uint8_t *glyph, uint32_t fg, uint32_t bg,
+                          unsigned flags)
+{
+    int sx = 0, sy = 0, w = FB_GLYPH_W, h = FB_GLYPH_H;
+    if (!fb_clip(s, &x, &y, &w, &h, &sx, &sy))
+        return;
+
+    for (int row = 0; row < h; row++) {
+        const uint32_t *m = mask8[glyph[sy + row]] + sx;
+        uint32_t *dst = fb_row(s, y + row) + x;
+        for (int i = 0; i < w; i++) {
+            uint32_t base = (flags & FB_TEXT_TRANSPARENT) ? dst[i] : bg;
+            dst[i] = base ^ ((base ^ fg) & m[i]);
+        }
+    }
+}
+
+void fb_text_draw(const struct fb_surface *s, int x, int y, const char *str,
+                  uint32_t fg, uint32_t bg, unsigned flags)
+{
+    mask8_init();
+
+    int stride_px = s->stride / 4;
+    int inside_y = y >= 0 && y + FB_GLYPH_H <= s->height;
+
+    for (; *str; str++, x += FB_GLYPH_W) {
+        const uint8_t *glyph = font_8x16[(uint8_t)*str];
+        if (inside_y && x >= 0 && x + FB_GLYPH_W <= s->width)
+            glyph_full(fb_row(s, y) + x, stride_px, glyph, fg, bg, flags);
+        else
+            glyph_clipped(s, x, y, glyph, fg, bg, flags);
+    }
+}
+
+/* ── Draw Engine glyph atlas ──────────────────────────────── */
+int fb_text_atlas_init(struct fb_text_atlas *a, void *vram, uint32_t phys)
+{
+    memset(a, 0, sizeof(*a));
+    return fb_tex_alloc(&a->tex, FB_TEXT_ATLAS_W, FB_TEXT_ATLAS_H, vram, phys);
+}
+
+static void atlas_expand(struct fb_text_atlas *a, uint32_t fg)
+{
+    uint32_t key = ~fg;     /* any color != fg works as the stencil key */
+
+    mask8_init();
+    for (int c = 0; c < 256; c++) {
+        uint32_t *dst = a->tex.pixels +
+            (size_t)(c / FB_TEXT_ATLAS_COLS) * FB_GLYPH_H * FB_TEXT_ATLAS_W +
+            (c % FB_TEXT_ATLAS_COLS) * FB_GLYPH_W;
+        for (int row = 0; row < FB_GLYPH_H; row++, dst += FB_TEXT_ATLAS_W) {
+            const uint32_t *m = mask8[font_8x16[c][row]];
+            for (int i = 0; i < 8; i++)
+                dst[i] = key ^ ((key ^ fg) & m[i]);
+        }
+    }
+    msync(a->tex.pixels, FB_TEXT_ATLAS_SIZE, MS_SYNC);
+
+    a->fg = fg;
+    a->key = key;
+    a->valid = 1;
+}
+
+static int glyph_blank(uint8_t c)
+{
+    for (int row = 0; row < FB_GLYPH_H; row++)
+        if (font_8x16[c][row])
+            return 0;
+    return 1;
+}
+
+void fb_text_dl(struct draw_dl *dl, struct fb_text_atlas *a, int x, int y,
+                const char *str, uint32_t fg, uint32_t bg, unsigned flags)
+{
+    if (!a->valid || a->fg != fg)
+        atlas_expand(a, fg);
+
+    if (!(flags & FB_TEXT_TRANSPARENT)) {
+        draw_dl_setfcolor(dl, bg);
+        draw_dl_patblt(dl, x, y, (int)strlen(str) * FB_GLYPH_W, FB_GLYPH_H);
+    }
+
+    draw_dl_settexture(dl, a->tex.phys, FB_TEXT_ATLAS_W, FB_TEXT_ATLAS_H);
+    draw_dl_setblendoff(dl);
+    draw_dl_setstcolor(dl, a->key);
+    draw_dl_setstmode(dl, 1);
+    for (; *str; str++, x += FB_GLYPH_W) {
+        uint8_t c = (uint8_t)*str;
+        if (glyph_blank(c))
+            continue;
+        draw_dl_bitblt(dl, x, y, FB_GLYPH_W, FB_GLYPH_H,
+                       (c % FB_TEXT_ATLAS_COLS) * FB_GLYPH_W,
+                       (c / FB_TEXT_ATLAS_COLS) * FB_GLYPH_H);
+    }
+    draw_dl_setstmode(dl, 0);
+}
@@ -0,0 +1,57 @@
+/*
+ * fb_text.h — 8x16 text renderer: mask-table CPU path + VRAM glyph atlas
+ *
+ * CPU: each glyph row byte indexes a 256-entry table of eight 32-bit
+ * pixel masks, so a row is eight branch-free select-stores.  With
+ * FB_TEXT_TRANSPARENT the background pixels are left untouched.
+ *
+ * Draw Engine: all 256 glyphs are expanded once, in the foreground
+ * color, into an atlas texture in VRAM.  Unset pixels hold a key
+ * color, and a line of text becomes one stencil-keyed BITBLT per
+ * glyph in a single display list.
+ */
+#ifndef FB_TEXT_H
+#define FB_TEXT_H
+
+#include <stdint.h>
+
+#include "draw_dl.h"
+#include "fb_span.h"
+#include "fb_tex.h"
+
+#define FB_GLYPH_W           8
+#define FB_GLYPH_H           16
+
+#define FB_TEXT_TRANSPARENT  (1u << 0)   /* don't write the background */
+
+/* Draw @str at (x, y); clipped to the surface */
+void fb_text_draw(const struct fb_surface *s, int x, int y, const char *str,
+                  uint32_t fg, uint32_t bg, unsigned flags);
+
+/* ── Draw Engine glyph atlas ──────────────────────────────── */
+#define FB_TEXT_ATLAS_COLS   32
+#define FB_TEXT_ATLAS_W      (FB_TEXT_ATLAS_COLS * FB_GLYPH_W)          /* 256 */
+#define FB_TEXT_ATLAS_H      ((256 / FB_TEXT_ATLAS_COLS) * FB_GLYPH_H)  /* 128 */
+#define FB_TEXT_ATLAS_SIZE   (FB_TEXT_ATLAS_W * FB_TEXT_ATLAS_H * 4)
+
+struct fb_text_atlas {
+    struct fb_tex tex;      /* FB_TEXT_ATLAS_W × FB_TEXT_ATLAS_H in VRAM */
+    uint32_t      fg;       /* color the glyphs are expanded in */
+    uint32_t      key;      /* stencil color of unset pixels */
+    int           valid;
+};
+
+/* @vram maps @phys; FB_TEXT_ATLAS_SIZE bytes, page aligned */
+int  fb_text_atlas_init(struct fb_text_atlas *a, void *vram, uint32_t phys);
+
+/*
+ * Append @str to @dl: an optional background PATBLT for the whole line,
+ * then one keyed BITBLT per non-blank glyph.  Re-expands the atlas
+ * first if @fg differs from the color it holds — submit any list that
+ * still references the old color before that.  Leaves blending and
+ * stencil off again afterwards.
+ */
+void fb_text_dl(struct draw_dl *dl, struct fb_text_atlas *a, int x, int y,
+                const char *str, uint32_t fg, uint32_t bg, unsigned flags);
+
+#endif /* FB_TEXT_H */
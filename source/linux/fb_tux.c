@@ -9,13 +9,37 @@
  *   fb_tux gradient     — Draw RGB gradient
  *   fb_tux clear        — Clear framebuffer to black
  *   fb_tux fill RRGGBB  — Fill with color (hex)
+ *   fb_tux print TEXT   — Draw one line of 8x16 text at the top left
+ *   fb_tux scene [FILE] — Run a scene command stream (FILE or stdin, one
+ *                         primitive per line, see fb_scene.h); output
+ *                         only on "flush"
+ *   fb_tux scene --listen PATH
+ *                       — Same, as a daemon on a UNIX socket
  *   fb_tux text         — Restore fbcon text mode
  *
+ *   fb_tux anim [N]     — Bouncing square for N frames (damage flushes)
+ *   fb_tux bench [csv|json] [FILE]
+ *                       — Time fill/copy/blend/text/logo on the CPU and
+ *                         the Draw Engine, VGA … SXGA, plus fbdev flush
+ *
+ *   fb_tux --drm MODE   — Render MODE through DRM/KMS: three dumb buffers
+ *                         on /dev/dri/card0, async page flips, no
+ *                         KD_GRAPHICS needed.  Holds the display until
+ *                         Ctrl+C, then fbcon takes the CRTC back.
+ *   fb_tux --hw MODE    — Render MODE with the Draw Engine instead of
+ *                         the CPU (logo, tux, color, gradient,
+ *                         clear, fill, print, scene; zoom [nearest]
+ *                         scales the logo to full height).  Display lists
+ *                         go through the legacy register window
+ *                         (/dev/uio0) straight into the scanout region.
+ *
  * Framebuffer: 640×480, XRGB8888 (32bpp, little-endian)
  *
  * NOTE: Switches /dev/tty0 to KD_GRAPHICS mode to suppress fbcon
  *       text overlay.  Use "fb_tux text" to restore.
  */
+#include <errno.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,20 +47,41 @@
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <linux/fb.h>
 #include <linux/kd.h>
 #include <linux/vt.h>
 
 #include "logo_tux_data.h"
+#include "draw_dl.h"
+#include "fb_bench.h"
+#include "fb_blend.h"
+#include "fb_damage.h"
+#include "fb_drm.h"
+#include "fb_scene.h"
+#include "fb_shape.h"
+#include "fb_span.h"
+#include "fb_tex.h"
+#include "fb_text.h"
 
 #define FB_WIDTH   640
 #define FB_HEIGHT  480
 #define FB_BPP     4  /* bytes per pixel (XRGB8888) */
 #define FB_SIZE    (FB_WIDTH * FB_HEIGHT * FB_BPP)
 
+/* Draw Engine path: scanout at DRAW_VRAM_BASE, textures right after it */
+#define HW_FB_ADDR   DRAW_VRAM_BASE
+#define HW_TEX_ADDR  (DRAW_VRAM_BASE + ((FB_SIZE + 0xFFF) & ~0xFFFu))
+#define HW_FONT_ADDR (HW_TEX_ADDR + 0x40000)    /* after the 224x208 logo */
+#define HW_BENCH_ADDR (HW_FONT_ADDR + FB_TEXT_ATLAS_SIZE) /* bench source, up to the ring */
+
 /* ── Framebuffer file descriptor (global for flush) ───────── */
 static int fb_fd = -1;
 
+/* ── Damage accumulated since the last fb_flush() ─────────── */
+static struct fb_damage fb_dmg;
+
 /* ── Suppress / restore fbcon text overlay ────────────────── */
 static int tty_fd = -1;
 
@@ -68,135 +113,100 @@ static void fbcon_restore(void)
  * RESOURCE_FLUSH via the VirtIO virtqueue.
  *
  * Solution: Use standard fbdev flush ioctls to trigger the update.
+ *
+ * Only the damaged rows are synced.  The DRM fbdev emulation tracks
+ * written pages through deferred I/O and transfers just those lines,
+ * so the forced FBIOPAN_DISPLAY (which re-commits the whole plane and
+ * pushes a full 1.2 MB TRANSFER_TO_HOST_2D) is reserved for frames
+ * that really touched the whole screen.
  */
 static unsigned char *fb_mmap_ptr = NULL;
+static size_t fb_map_size = FB_SIZE;
+static int fb_line_length = FB_WIDTH * FB_BPP;
+
+static void fb_sync_rows(int y1, int y2)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)fb_mmap_ptr + (uintptr_t)y1 * fb_line_length;
+    uintptr_t end   = (uintptr_t)fb_mmap_ptr + (uintptr_t)y2 * fb_line_length;
+
+    start &= ~(uintptr_t)(page - 1);
+    msync((void *)start, end - start, MS_SYNC);
+}
 
 static void fb_flush(void)
 {
     if (fb_fd < 0 || !fb_mmap_ptr || fb_mmap_ptr == MAP_FAILED)
         return;
+    if (fb_dmg.count == 0)
+        return;
 
-    /* ── Standard fbdev flush ioctls ─────────── */
-    msync(fb_mmap_ptr, FB_SIZE, MS_SYNC);
-    fsync(fb_fd);
+    if (fb_damage_is_full(&fb_dmg)) {
+        /* ── Standard fbdev flush ioctls ─────────── */
+        msync(fb_mmap_ptr, fb_map_size, MS_SYNC);
+        fsync(fb_fd);
 
-    struct fb_var_screeninfo vi;
-    if (ioctl(fb_fd, FBIOGET_VSCREENINFO, &vi) == 0) {
-        vi.xoffset = 0;
-        vi.yoffset = 0;
-        vi.activate = FB_ACTIVATE_NOW | FB_ACTIVATE_FORCE;
-        ioctl(fb_fd, FBIOPAN_DISPLAY, &vi);
+        struct fb_var_screeninfo vi;
+        if (ioctl(fb_fd, FBIOGET_VSCREENINFO, &vi) == 0) {
+            vi.xoffset = 0;
+            vi.yoffset = 0;
+            vi.activate = FB_ACTIVATE_NOW | FB_ACTIVATE_FORCE;
+            ioctl(fb_fd, FBIOPAN_DISPLAY, &vi);
+        }
+    } else {
+        for (int i = 0; i < fb_dmg.count; i++)
+            fb_sync_rows(fb_dmg.rects[i].y1, fb_dmg.rects[i].y2);
+        fsync(fb_fd);
     }
 
     int dummy = 0;
     ioctl(fb_fd, FBIO_WAITFORVSYNC, &dummy);
+
+    fb_damage_reset(&fb_dmg);
 }
 
 /* ── Pixel drawing primitives ─────────────────────────────── */
-static inline void put_pixel(unsigned char *fb, int x, int y, uint32_t color)
+/*
+ * Rect-shaped work goes through the span layer (fb_span.c); put_pixel
+ * is left for the shapes that are still rasterized point by point.
+ */
+static inline void put_pixel(const struct fb_surface *fb, int x, int y, uint32_t color)
 {
-    if (x < 0 || x >= FB_WIDTH || y < 0 || y >= FB_HEIGHT)
+    if ((unsigned)x >= (unsigned)fb->width || (unsigned)y >= (unsigned)fb->height)
         return;
-    ((uint32_t *)fb)[(y * FB_WIDTH) + x] = color;
-}
-
-static void draw_rect(unsigned char *fb, int x, int y, int w, int h, uint32_t color)
-{
-    for (int dy = 0; dy < h; dy++)
-        for (int dx = 0; dx < w; dx++)
-            put_pixel(fb, x + dx, y + dy, color);
-}
-
-/* ── Alpha blending (Porter-Duff "over" operator) ──────────── */
-static inline uint32_t blend_over(uint32_t src, uint32_t dst)
-{
-    uint32_t sa = (src >> 24) & 0xFF;
-    uint32_t sr = (src >> 16) & 0xFF;
-    uint32_t sg = (src >>  8) & 0xFF;
-    uint32_t sb = (src >>  0) & 0xFF;
-
-    uint32_t da = (dst >> 24) & 0xFF;
-    uint32_t dr = (dst >> 16) & 0xFF;
-    uint32_t dg = (dst >>  8) & 0xFF;
-    uint32_t db = (dst >>  0) & 0xFF;
-
-    /* result = src + dst * (1 - src_alpha) */
-    uint32_t inv_sa = 255 - sa;
-    uint32_t ra = sa + ((da * inv_sa) / 255);
-    uint32_t rr = sr + ((dr * inv_sa) / 255);
-    uint32_t rg = sg + ((dg * inv_sa) / 255);
-    uint32_t rb = sb + ((db * inv_sa) / 255);
-
-    return (ra << 24) | (rr << 16) | (rg << 8) | rb;
-}
-
-static void blit_rgba(unsigned char *fb, int dx, int dy,
-                     const unsigned char *src, int sw, int sh)
-{
-    for (int y = 0; y < sh; y++) {
-        for (int x = 0; x < sw; x++) {
-            int sx_pos = (y * sw + x) * 4;
-            uint32_t src_px = ((uint32_t)src[sx_pos + 3] << 24) |  /* A */
-                             ((uint32_t)src[sx_pos + 0] << 16) |  /* R */
-                             ((uint32_t)src[sx_pos + 1] <<  8) |  /* G */
-                             ((uint32_t)src[sx_pos + 2] <<  0);   /* B */
-
-            int fx = dx + x;
-            int fy = dy + y;
-            if (fx >= 0 && fx < FB_WIDTH && fy >= 0 && fy < FB_HEIGHT) {
-                uint32_t *dst_ptr = ((uint32_t *)fb) + (fy * FB_WIDTH + fx);
-                *dst_ptr = blend_over(src_px, *dst_ptr);
-            }
-        }
-    }
+    fb_row(fb, y)[x] = color;
 }
 
-/* ── Text rendering (8x16 embedded font) ───────────────────── */
-static const unsigned char font_8x16[256][16] = {
-    /* Simple embedded 8x16 ASCII font - only printable chars */
-    [' '] = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
-             0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00},
-    ['A'] = {0x00,0x00,0x10,0x28,0x28,0x44,0x44,0x7C,
-             0x44,0x82,0x82,0x82,0x00,0x00,0x00,0x00},
-    /* ... (truncated for brevity - full font would be here) ... */
-};
-
-static void draw_char(unsigned char *fb, int x, int y, char c, uint32_t fg, uint32_t bg)
+static void draw_rect(const struct fb_surface *fb, int x, int y, int w, int h, uint32_t color)
 {
-    const unsigned char *glyph = font_8x16[(unsigned char)c];
-    for (int row = 0; row < 16; row++) {
-        unsigned char bits = glyph[row];
-        for (int col = 0; col < 8; col++) {
-            uint32_t color = (bits & (0x80 >> col)) ? fg : bg;
-            put_pixel(fb, x + col, y + row, color);
-        }
-    }
+    fb_damage_add(&fb_dmg, x, y, w, h);
+    fb_fill_rect(fb, x, y, w, h, color);
 }
 
-static void draw_string(unsigned char *fb, int x, int y, const char *str,
-                       uint32_t fg, uint32_t bg)
+/* ── Text rendering (8x16 VGA font, see fb_text.c) ────────── */
+static void draw_string(const struct fb_surface *fb, int x, int y, const char *str,
+                       uint32_t fg, uint32_t bg, unsigned flags)
 {
-    while (*str) {
-        draw_char(fb, x, y, *str, fg, bg);
-        x += 8;
-        str++;
-    }
+    fb_damage_add(&fb_dmg, x, y, (int)strlen(str) * FB_GLYPH_W, FB_GLYPH_H);
+    fb_text_draw(fb, x, y, str, fg, bg, flags);
 }
 
 /* ── Draw test patterns ───────────────────────────────────── */
-static void draw_gradient_rgb(unsigned char *fb)
+static void draw_gradient_rgb(const struct fb_surface *fb)
 {
+    fb_damage_add_full(&fb_dmg);
     for (int y = 0; y < FB_HEIGHT; y++) {
+        uint32_t *row = fb_row(fb, y);
+        uint8_t g = (y * 255) / FB_HEIGHT;
         for (int x = 0; x < FB_WIDTH; x++) {
             uint8_t r = (x * 255) / FB_WIDTH;
-            uint8_t g = (y * 255) / FB_HEIGHT;
             uint8_t b = ((x + y) * 127) / (FB_WIDTH + FB_HEIGHT);
-            put_pixel(fb, x, y, 0xFF000000 | (r << 16) | (g << 8) | b);
+            row[x] = 0xFF000000 | (r << 16) | (g << 8) | b;
         }
     }
 }
 
-static void draw_color_bars(unsigned char *fb)
+static void draw_color_bars(const struct fb_surface *fb)
 {
     uint32_t colors[8] = {
         0xFFFFFFFF, 0xFFFFFF00, 0xFF00FFFF, 0xFF00FF00,
@@ -208,30 +218,41 @@ static void draw_color_bars(unsigned char *fb)
     }
 }
 
-/* ── Official Linux boot logo (224x208, centered) ──────────── */
-static void draw_official_logo(unsigned char *fb, int center_x, int center_y)
+/* ── Logo texture: CLUT expanded once, then row copies ────── */
+static struct fb_tex logo_tex;
+
+static const struct fb_tex *logo_texture(void)
 {
-    int x = center_x - (logo_linux_clut224_width / 2);
-    int y = center_y - (logo_linux_clut224_height / 2);
-    
-    /* The logo data is indexed color (CLUT), convert to ARGB */
-    for (int py = 0; py < logo_linux_clut224_height; py++) {
-        for (int px = 0; px < logo_linux_clut224_width; px++) {
-            unsigned char idx = logo_linux_clut224_data[py * logo_linux_clut224_width + px];
-            unsigned char r = logo_linux_clut224_clut[idx * 3 + 0];
-            unsigned char g = logo_linux_clut224_clut[idx * 3 + 1];
-            unsigned char b = logo_linux_clut224_clut[idx * 3 + 2];
-            uint32_t color = 0xFF000000 | (r << 16) | (g << 8) | b;
-            put_pixel(fb, x + px, y + py, color);
-        }
+    if (!logo_tex.pixels) {
+        if (fb_tex_alloc(&logo_tex, logo_linux_clut224_width,
+                         logo_linux_clut224_height, NULL, 0) < 0)
+            return NULL;
+        fb_tex_load_clut(&logo_tex, logo_linux_clut224_data,
+                         logo_linux_clut224_clut,
+                         (int)sizeof(logo_linux_clut224_clut) / 3);
     }
+    return &logo_tex;
+}
+
+/* ── Official Linux boot logo (224x208, centered) ──────────── */
+static void draw_official_logo(const struct fb_surface *fb, int center_x, int center_y)
+{
+    const struct fb_tex *tex = logo_texture();
+    if (!tex)
+        return;
+
+    int x = center_x - (tex->width / 2);
+    int y = center_y - (tex->height / 2);
+
+    fb_damage_add(&fb_dmg, x, y, tex->width, tex->height);
+    fb_tex_draw(fb, tex, x, y);
 }
 
 /* ── Draw multiple boot logos (like kernel boot) ───────────── */
-static void draw_multiple_logos(unsigned char *fb, int count)
+static void draw_multiple_logos(const struct fb_surface *fb, int count)
 {
     /* Clear to black first */
-    memset(fb, 0, FB_SIZE);
+    draw_rect(fb, 0, 0, FB_WIDTH, FB_HEIGHT, 0xFF000000);
     
     int logo_w = logo_linux_clut224_width;
     int logo_h = logo_linux_clut224_height;
@@ -255,88 +276,883 @@ static void draw_multiple_logos(unsigned char *fb, int count)
 }
 
 /* ── High-resolution vector Tux rendering ──────────────────── */
-static void draw_vector_tux(unsigned char *fb)
+/*
+ * Shapes come out of fb_shape.c as spans; a "pen" routes them either
+ * to the CPU span filler or into a Draw Engine display list as one
+ * PATBLT per span, so both paths draw the same pixels.  An engine with
+ * DRAW_CAPS_SHAPES rasterises them itself from one command each, and
+ * the clip becomes its draw area (coordinates relative to the origin).
+ */
+struct tux_pen {
+    const struct fb_surface *fb;    /* CPU target, or NULL */
+    struct draw_dl          *dl;    /* Draw Engine target, or NULL */
+    int                      shapes;    /* dl takes LINE/TRIANGLE/ELLIPSE */
+    uint32_t                 color;
+    int clip_x1, clip_y1, clip_x2, clip_y2;     /* inclusive */
+};
+
+static void pen_span(void *ctx, int y, int x1, int x2)
+{
+    struct tux_pen *pen = ctx;
+
+    if (y < pen->clip_y1 || y > pen->clip_y2)
+        return;
+    if (x1 < pen->clip_x1) x1 = pen->clip_x1;
+    if (x2 > pen->clip_x2) x2 = pen->clip_x2;
+    if (x1 > x2)
+        return;
+
+    if (pen->dl)
+        draw_dl_patblt(pen->dl, x1, y, x2 - x1 + 1, 1);
+    else
+        fb_hspan(pen->fb, y, x1, x2, pen->color);
+}
+
+static void pen_color(struct tux_pen *pen, uint32_t color)
+{
+    pen->color = color;
+    if (pen->dl)
+        draw_dl_setfcolor(pen->dl, color);
+}
+
+static void pen_clip(struct tux_pen *pen, int x1, int y1, int x2, int y2)
+{
+    if (pen->dl && pen->shapes &&
+        (x1 != pen->clip_x1 || y1 != pen->clip_y1 ||
+         x2 != pen->clip_x2 || y2 != pen->clip_y2))
+        draw_dl_setdrawarea(pen->dl, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+    pen->clip_x1 = x1;
+    pen->clip_y1 = y1;
+    pen->clip_x2 = x2;
+    pen->clip_y2 = y2;
+}
+
+static void pen_noclip(struct tux_pen *pen)
+{
+    pen_clip(pen, 0, 0, FB_WIDTH - 1, FB_HEIGHT - 1);
+}
+
+/* Pen on a display list whose draw area is still the full screen (hw_begin) */
+#define PEN_DL(list, caps) {                                    \
+        .dl = (list), .shapes = !!((caps) & DRAW_CAPS_SHAPES),  \
+        .clip_x2 = FB_WIDTH - 1, .clip_y2 = FB_HEIGHT - 1 }
+
+static void pen_rect(struct tux_pen *pen, int x, int y, int w, int h)
+{
+    if (pen->dl && pen->shapes)
+        draw_dl_patblt(pen->dl, x - pen->clip_x1, y - pen->clip_y1, w, h);
+    else if (pen->dl)
+        draw_dl_patblt(pen->dl, x, y, w, h);
+    else
+        fb_fill_rect(pen->fb, x, y, w, h, pen->color);
+}
+
+static void pen_ellipse(struct tux_pen *pen, int cx, int cy, int rx, int ry)
+{
+    if (pen->dl && pen->shapes)
+        draw_dl_ellipse(pen->dl, cx - pen->clip_x1, cy - pen->clip_y1, rx, ry);
+    else
+        fb_ellipse_spans(cx, cy, rx, ry, pen_span, pen);
+}
+
+static void pen_triangle(struct tux_pen *pen, int x0, int y0,
+                         int x1, int y1, int x2, int y2)
+{
+    int ox = pen->clip_x1, oy = pen->clip_y1;
+
+    if (pen->dl && pen->shapes)
+        draw_dl_triangle(pen->dl, x0 - ox, y0 - oy, x1 - ox, y1 - oy,
+                         x2 - ox, y2 - oy);
+    else
+        fb_triangle_spans(x0, y0, x1, y1, x2, y2, pen_span, pen);
+}
+
+static void pen_line(struct tux_pen *pen, int x0, int y0, int x1, int y1)
+{
+    int ox = pen->clip_x1, oy = pen->clip_y1;
+
+    if (pen->dl && pen->shapes)
+        draw_dl_line(pen->dl, x0 - ox, y0 - oy, x1 - ox, y1 - oy);
+    else
+        fb_line_spans(x0, y0, x1, y1, pen_span, pen);
+}
+
+static void vector_tux(struct tux_pen *pen)
 {
     int cx = FB_WIDTH / 2;
     int cy = FB_HEIGHT / 2;
-    
+
+    pen_noclip(pen);
+
     /* Body (black ellipse) */
-    for (int y = -80; y <= 80; y++) {
-        for (int x = -50; x <= 50; x++) {
-            if (x*x/2500.0 + y*y/6400.0 <= 1.0)
-                put_pixel(fb, cx + x, cy + y, 0xFF000000);
+    pen_color(pen, 0xFF000000);
+    pen_ellipse(pen, cx, cy, 50, 80);
+
+    /* Belly (white ellipse, top 10 rows cut off) */
+    pen_color(pen, 0xFFFFFFFF);
+    pen_clip(pen, 0, cy - 30, FB_WIDTH - 1, FB_HEIGHT - 1);
+    pen_ellipse(pen, cx, cy + 10, 30, 50);
+    pen_noclip(pen);
+
+    /* Eyes (white circles with black pupils) */
+    pen_ellipse(pen, cx - 20, cy - 30, 8, 8);
+    pen_ellipse(pen, cx + 20, cy - 30, 8, 8);
+    pen_color(pen, 0xFF000000);
+    pen_ellipse(pen, cx - 20, cy - 28, 4, 4);
+    pen_ellipse(pen, cx + 20, cy - 28, 4, 4);
+
+    /* Beak (orange, tip cut off after 10 rows) */
+    pen_color(pen, 0xFFFFA500);
+    pen_clip(pen, 0, cy - 10, FB_WIDTH - 1, cy - 1);
+    pen_triangle(pen, cx - 8, cy - 10, cx + 8, cy - 10, cx, cy + 6);
+    pen_noclip(pen);
+
+    /* Feet (orange pad + three toes each) */
+    for (int foot = 0; foot < 2; foot++) {
+        int foot_x = cx + (foot == 0 ? -25 : 25);
+        int foot_y = cy + 75;
+
+        pen_rect(pen, foot_x - 12, foot_y, 25, 15);
+        for (int toe = 0; toe < 3; toe++)
+            pen_rect(pen, foot_x + (toe - 1) * 10 - 3, foot_y + 15, 7, 20);
+    }
+
+    /* Wings/flippers: outer half of an ellipse on each side */
+    pen_color(pen, 0xFF000000);
+    pen_clip(pen, cx - 50 - 24, 0, cx - 50, FB_HEIGHT - 1);
+    pen_ellipse(pen, cx - 50, cy, 25, 30);
+    pen_clip(pen, cx + 50, 0, cx + 50 + 24, FB_HEIGHT - 1);
+    pen_ellipse(pen, cx + 50, cy, 25, 30);
+    pen_noclip(pen);
+}
+
+static void draw_vector_tux(const struct fb_surface *fb)
+{
+    struct tux_pen pen = { .fb = fb };
+
+    /* Bounding box: flippers ±75, body top -80, toes +110 */
+    fb_damage_add(&fb_dmg, FB_WIDTH / 2 - 75, FB_HEIGHT / 2 - 80, 151, 191);
+    vector_tux(&pen);
+}
+
+/* ── Draw Engine (HW) rendering path ──────────────────────── */
+/*
+ * The engine writes the scanout region directly over AXI, so nothing
+ * goes through the /dev/fb0 GEM buffer and fb_flush() must NOT run
+ * afterwards — a TRANSFER_TO_HOST_2D would overwrite the result with
+ * the stale shadow buffer.
+ */
+static struct draw_dev  hw_dev  = { .fd = -1 };
+static struct draw_vram hw_vram = { .fd = -1 };
+
+static int hw_open(void)
+{
+    if (draw_dev_open(&hw_dev, "/dev/uio0") < 0)
+        return -1;
+    if (draw_vram_map(&hw_vram, DRAW_VRAM_BASE, DRAW_VRAM_SIZE) < 0) {
+        draw_dev_close(&hw_dev);
+        return -1;
+    }
+    /* Let the engine fetch lists itself when it can; else feed DRAWCMD */
+    draw_dev_ring_init(&hw_dev, &hw_vram, DRAW_RING_ADDR, DRAW_RING_SIZE);
+    return 0;
+}
+
+static void hw_close(void)
+{
+    draw_vram_unmap(&hw_vram);
+    draw_dev_close(&hw_dev);
+}
+
+/* Common prologue: target the scanout, opaque, no color key */
+static void hw_begin(struct draw_dl *dl)
+{
+    draw_dl_setframe(dl, HW_FB_ADDR, FB_WIDTH, FB_HEIGHT);
+    draw_dl_setdrawarea(dl, 0, 0, FB_WIDTH, FB_HEIGHT);
+    draw_dl_setblendoff(dl);
+    draw_dl_setstmode(dl, 0);
+}
+
+static void hw_fill(struct draw_dl *dl, int x, int y, int w, int h, uint32_t color)
+{
+    draw_dl_setfcolor(dl, color);
+    draw_dl_patblt(dl, x, y, w, h);
+}
+
+/* draw_gradient_rgb() as one horizontal GRADIENT per row (r and b are linear in x) */
+static void hw_gradient(struct draw_dl *dl)
+{
+    for (int y = 0; y < FB_HEIGHT; y++) {
+        uint32_t g = (y * 255) / FB_HEIGHT;
+        uint32_t r1 = ((FB_WIDTH - 1) * 255) / FB_WIDTH;
+        uint32_t b0 = (y * 127) / (FB_WIDTH + FB_HEIGHT);
+        uint32_t b1 = ((FB_WIDTH - 1 + y) * 127) / (FB_WIDTH + FB_HEIGHT);
+
+        draw_dl_gradient(dl, 0, y, FB_WIDTH, 1,
+                         0xFF000000 | (g << 8) | b0,
+                         0xFF000000 | (r1 << 16) | (g << 8) | b1, 0);
+    }
+}
+
+/*
+ * Put the CLUT logo into the VRAM texture region once: as indices plus
+ * palette when the engine expands CLUT8 itself, else expanded here.
+ */
+static struct fb_tex hw_logo_tex;
+
+static void hw_upload_logo(void)
+{
+    int clut_len = (int)sizeof(logo_linux_clut224_clut) / 3;
+
+    if (hw_logo_tex.pixels)
+        return;
+    fb_tex_alloc(&hw_logo_tex, logo_linux_clut224_width, logo_linux_clut224_height,
+                 draw_vram_ptr(&hw_vram, HW_TEX_ADDR), HW_TEX_ADDR);
+    if (!(hw_dev.caps & DRAW_CAPS_TEXFMT) ||
+        fb_tex_load_clut8(&hw_logo_tex, logo_linux_clut224_data,
+                          logo_linux_clut224_clut, clut_len) < 0)
+        fb_tex_load_clut(&hw_logo_tex, logo_linux_clut224_data,
+                         logo_linux_clut224_clut, clut_len);
+    msync(hw_logo_tex.pixels,
+          ((size_t)hw_logo_tex.width * hw_logo_tex.height * 4 + 0xFFF) & ~(size_t)0xFFF,
+          MS_SYNC);
+}
+
+/* Glyph atlas after the logo; expanded lazily by fb_text_dl() */
+static struct fb_text_atlas hw_font;
+
+static struct fb_text_atlas *hw_font_atlas(void)
+{
+    if (!hw_font.tex.pixels)
+        fb_text_atlas_init(&hw_font, draw_vram_ptr(&hw_vram, HW_FONT_ADDR),
+                           HW_FONT_ADDR);
+    return &hw_font;
+}
+
+static void hw_logos(struct draw_dl *dl, int count)
+{
+    int logo_w = logo_linux_clut224_width;
+    int logo_h = logo_linux_clut224_height;
+
+    hw_upload_logo();
+    hw_fill(dl, 0, 0, FB_WIDTH, FB_HEIGHT, 0xFF000000);
+    fb_tex_bind(dl, &hw_logo_tex);
+
+    if (count == 1) {
+        draw_dl_bitblt(dl, (FB_WIDTH - logo_w) / 2, (FB_HEIGHT - logo_h) / 2,
+                       logo_w, logo_h, 0, 0);
+        return;
+    }
+
+    /* Same grid as draw_multiple_logos() */
+    int margin = 20;
+    int cols = 4;
+    int start_x = (FB_WIDTH - (logo_w * cols + margin * (cols - 1))) / 2;
+    for (int i = 0; i < count; i++) {
+        int x = start_x + (i % cols) * (logo_w + margin);
+        int y = margin + (i / cols) * (logo_h + margin);
+        if (y + logo_h > FB_HEIGHT)
+            break;
+        draw_dl_bitblt(dl, x, y, logo_w, logo_h, 0, 0);
+    }
+}
+
+/* Logo stretched to the full screen height by SCALEBLT */
+static void hw_zoom(struct draw_dl *dl, int bilinear)
+{
+    int logo_w = logo_linux_clut224_width;
+    int logo_h = logo_linux_clut224_height;
+    int h = FB_HEIGHT;
+    int w = logo_w * h / logo_h;
+
+    hw_upload_logo();
+    hw_fill(dl, 0, 0, FB_WIDTH, FB_HEIGHT, 0xFF000000);
+    fb_tex_bind(dl, &hw_logo_tex);
+    draw_dl_setscale(dl, draw_scale_step(logo_w, w), draw_scale_step(logo_h, h),
+                     bilinear);
+    draw_dl_scaleblt(dl, (FB_WIDTH - w) / 2, 0, w, h, 0, 0);
+}
+
+static int scene_main(const struct fb_surface *fb, struct draw_dl *dl,
+                      int argc, char *argv[]);
+
+static int hw_main(const char *mode, int argc, char *argv[])
+{
+    static const uint32_t bars[8] = {
+        0xFFFFFFFF, 0xFFFFFF00, 0xFF00FFFF, 0xFF00FF00,
+        0xFFFF00FF, 0xFFFF0000, 0xFF0000FF, 0xFF000000
+    };
+    struct draw_dl dl;
+    int ret = 0;
+
+    if (hw_open() < 0)
+        return 1;
+    fbcon_disable();
+
+    draw_dl_init(&dl);
+    hw_begin(&dl);
+
+    if (strcmp(mode, "logo") == 0) {
+        int count = (argc > 2) ? atoi(argv[2]) : 1;
+        hw_logos(&dl, count);
+        printf("HW: %d Linux boot logo(s) via BITBLT\n", count);
+    }
+    else if (strcmp(mode, "tux") == 0) {
+        struct tux_pen pen = PEN_DL(&dl, hw_dev.caps);
+        hw_fill(&dl, 0, 0, FB_WIDTH, FB_HEIGHT, 0x40404040);
+        vector_tux(&pen);
+        printf("HW: vector Tux via %s\n",
+               pen.shapes ? "ELLIPSE/TRIANGLE" : "PATBLT spans");
+    }
+    else if (strcmp(mode, "print") == 0) {
+        const char *msg = (argc > 2) ? argv[2] : "Hello from fb_tux";
+        fb_text_dl(&dl, hw_font_atlas(), 8, 8, msg, 0xFFFFFFFF, 0xFF000000, 0);
+        printf("HW: %zu characters via keyed BITBLT from the glyph atlas\n", strlen(msg));
+    }
+    else if (strcmp(mode, "scene") == 0) {
+        if (scene_main(NULL, &dl, argc, argv) < 0)
+            ret = 1;
+    }
+    else if (strcmp(mode, "zoom") == 0) {
+        int nearest = argc > 2 && strcmp(argv[2], "nearest") == 0;
+        if (!(hw_dev.caps & DRAW_CAPS_TEXFMT)) {
+            fprintf(stderr, "Draw Engine has no SCALEBLT command (DRAWCAPS 0x%08X)\n",
+                    hw_dev.caps);
+            ret = 1;
+        } else {
+            hw_zoom(&dl, !nearest);
+            printf("HW: boot logo scaled to %d rows via %s SCALEBLT\n",
+                   FB_HEIGHT, nearest ? "nearest" : "bilinear");
         }
     }
-    
-    /* Belly (white ellipse) */
-    for (int y = -40; y <= 60; y++) {
-        for (int x = -30; x <= 30; x++) {
-            if (x*x/900.0 + y*y/2500.0 <= 1.0)
-                put_pixel(fb, cx + x, cy + y + 10, 0xFFFFFFFF);
+    else if (strcmp(mode, "gradient") == 0) {
+        if (!(hw_dev.caps & DRAW_CAPS_SHAPES)) {
+            fprintf(stderr, "Draw Engine has no GRADIENT command (DRAWCAPS 0x%08X)\n",
+                    hw_dev.caps);
+            ret = 1;
+        } else {
+            hw_gradient(&dl);
+            printf("HW: RGB gradient via GRADIENT rows\n");
         }
     }
-    
-    /* Eyes (white circles with black pupils) */
-    for (int dy = -8; dy <= 8; dy++) {
-        for (int dx = -8; dx <= 8; dx++) {
-            if (dx*dx + dy*dy <= 64) {
-                put_pixel(fb, cx - 20 + dx, cy - 30 + dy, 0xFFFFFFFF);
-                put_pixel(fb, cx + 20 + dx, cy - 30 + dy, 0xFFFFFFFF);
-            }
-            if (dx*dx + dy*dy <= 16) {
-                put_pixel(fb, cx - 20 + dx, cy - 28 + dy, 0xFF000000);
-                put_pixel(fb, cx + 20 + dx, cy - 28 + dy, 0xFF000000);
+    else if (strcmp(mode, "color") == 0) {
+        int bar_w = FB_WIDTH / 8;
+        for (int i = 0; i < 8; i++)
+            hw_fill(&dl, i * bar_w, 0, bar_w, FB_HEIGHT, bars[i]);
+        printf("HW: color bars via PATBLT\n");
+    }
+    else if (strcmp(mode, "clear") == 0) {
+        hw_fill(&dl, 0, 0, FB_WIDTH, FB_HEIGHT, 0xFF000000);
+        printf("HW: cleared framebuffer\n");
+    }
+    else if (strcmp(mode, "fill") == 0) {
+        uint32_t color = 0xFF000000;
+        if (argc > 2)
+            color = 0xFF000000 | (uint32_t)strtol(argv[2], NULL, 16);
+        hw_fill(&dl, 0, 0, FB_WIDTH, FB_HEIGHT, color);
+        printf("HW: filled with color 0x%08X\n", color);
+    }
+    else {
+        fprintf(stderr, "Mode '%s' has no Draw Engine path\n", mode);
+        fprintf(stderr, "Usage: fb_tux --hw [logo|zoom|tux|color|gradient|clear|fill|print|scene]\n");
+        ret = 1;
+    }
+
+    if (ret == 0) {
+        printf("  display list: %zu words\n", dl.len + 1);
+        if (draw_dev_submit(&hw_dev, &dl) < 0) {
+            fprintf(stderr, "Draw Engine submission failed\n");
+            ret = 1;
+        }
+    }
+
+    draw_dl_free(&dl);
+    hw_close();
+    return ret;
+}
+
+/* ── Animation: bouncing square (exercises damage + flips) ── */
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static struct fb_drm drm = { .fd = -1 };
+static int use_drm;
+
+/* Hand the finished frame to the display backend */
+static void present(void)
+{
+    if (use_drm) {
+        fb_drm_present(&drm, &fb_dmg);
+        fb_damage_reset(&fb_dmg);
+    } else {
+        fb_flush();
+    }
+}
+
+/* Surface for the framebuffer (fbdev mmap, or the DRM back buffer) */
+static struct fb_surface fb_surf;
+
+/* Next buffer to draw into (DRM: one that no queued flip still owns) */
+static const struct fb_surface *next_frame(const struct fb_surface *fb)
+{
+    if (!use_drm)
+        return fb;
+    fb_drm_begin_frame(&drm);
+    fb_surf.base = fb_drm_back(&drm);
+    return &fb_surf;
+}
+
+/* ── Benchmarks (fb_bench.c) ──────────────────────────────── */
+static void bench_flush(int x, int y, int w, int h)
+{
+    fb_damage_add(&fb_dmg, x, y, w, h);
+    fb_flush();
+}
+
+static int run_bench(const struct fb_surface *fb, int argc, char *argv[])
+{
+    struct fb_bench_cfg cfg = {
+        .json = argc > 2 && strcmp(argv[2], "json") == 0,
+        .logo = logo_texture(),
+        .screen = fb,
+        .flush = use_drm ? NULL : bench_flush,
+    };
+    FILE *out = stdout;
+    int hw = 0;
+
+    if (argc > 3 && !(out = fopen(argv[3], "w"))) {
+        perror(argv[3]);
+        return -1;
+    }
+
+    if (hw_open() == 0) {
+        hw = 1;
+        hw_upload_logo();
+        cfg.hw = &hw_dev;
+        cfg.hw_frame = HW_FB_ADDR;
+        cfg.hw_frame_size = HW_TEX_ADDR - HW_FB_ADDR;
+        cfg.hw_src = HW_BENCH_ADDR;
+        cfg.hw_src_px = draw_vram_ptr(&hw_vram, HW_BENCH_ADDR);
+        cfg.hw_src_size = DRAW_RING_ADDR - HW_BENCH_ADDR;
+        cfg.hw_logo = &hw_logo_tex;
+        cfg.hw_font = hw_font_atlas();
+    } else {
+        fprintf(stderr, "bench: Draw Engine not available, CPU only\n");
+    }
+
+    int ret = fb_bench_run(&cfg, out);
+
+    if (hw)
+        hw_close();
+    if (out != stdout)
+        fclose(out);
+    return ret;
+}
+
+/* ── Scene / batch mode (fb_scene.c) ─────────────────────── */
+/*
+ * One process, one mapping, one KD_GRAPHICS switch: primitives are
+ * read line by line and only reach the display on "flush" — as one
+ * damage flush / page flip on the CPU path, or one display-list
+ * submission on the Draw Engine path.  Whatever is left unflushed at
+ * the end of the stream goes out with the caller's final present.
+ */
+struct scene {
+    const struct fb_surface *fb;    /* CPU target, or NULL */
+    struct draw_dl          *dl;    /* Draw Engine target, or NULL */
+    uint32_t                 color;
+    int                      key_on;
+    uint32_t                 key;
+};
+
+static void scene_shape(struct scene *sc, const struct fb_scene_cmd *cmd,
+                        uint32_t color)
+{
+    struct tux_pen pen = PEN_DL(sc->dl, hw_dev.caps);
+    const int *a = cmd->arg;
+
+    pen.fb = sc->fb;
+
+    pen_noclip(&pen);
+    pen_color(&pen, color);
+    if (cmd->op == FB_SCENE_TRI) {
+        if (!sc->dl) {
+            int x1 = a[0], x2 = a[0], y1 = a[1], y2 = a[1];
+            for (int i = 2; i < 6; i += 2) {
+                if (a[i] < x1) x1 = a[i];
+                if (a[i] > x2) x2 = a[i];
+                if (a[i + 1] < y1) y1 = a[i + 1];
+                if (a[i + 1] > y2) y2 = a[i + 1];
             }
+            fb_damage_add(&fb_dmg, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
         }
+        pen_triangle(&pen, a[0], a[1], a[2], a[3], a[4], a[5]);
+    } else if (cmd->op == FB_SCENE_LINE) {
+        if (!sc->dl) {
+            int x1 = a[0] < a[2] ? a[0] : a[2];
+            int y1 = a[1] < a[3] ? a[1] : a[3];
+            fb_damage_add(&fb_dmg, x1, y1, abs(a[2] - a[0]) + 1,
+                          abs(a[3] - a[1]) + 1);
+        }
+        pen_line(&pen, a[0], a[1], a[2], a[3]);
+    } else {
+        if (!sc->dl)
+            fb_damage_add(&fb_dmg, a[0] - a[2], a[1] - a[3],
+                          2 * a[2] + 1, 2 * a[3] + 1);
+        pen_ellipse(&pen, a[0], a[1], a[2], a[3]);
     }
-    
-    /* Beak (yellow/orange) */
-    for (int y = 0; y < 10; y++) {
-        for (int x = -8 + y/2; x <= 8 - y/2; x++) {
-            put_pixel(fb, cx + x, cy - 10 + y, 0xFFFFA500);
+}
+
+static void scene_flush(struct scene *sc)
+{
+    if (sc->dl) {
+        if (draw_dev_submit(&hw_dev, sc->dl) < 0)
+            fprintf(stderr, "scene: Draw Engine submission failed\n");
+        draw_dl_reset(sc->dl);
+        hw_begin(sc->dl);
+    } else {
+        present();
+        sc->fb = next_frame(sc->fb);
+    }
+}
+
+static void scene_exec(struct scene *sc, const struct fb_scene_cmd *cmd)
+{
+    const struct fb_surface *fb = sc->fb;
+    struct draw_dl *dl = sc->dl;
+    const int *a = cmd->arg;
+    uint32_t color = cmd->has_color ? cmd->color : sc->color;
+
+    switch (cmd->op) {
+    case FB_SCENE_COLOR:
+        sc->color = cmd->color;
+        break;
+    case FB_SCENE_CLEAR:
+        if (dl)
+            hw_fill(dl, 0, 0, FB_WIDTH, FB_HEIGHT, cmd->has_color ? color : 0xFF000000);
+        else
+            draw_rect(fb, 0, 0, FB_WIDTH, FB_HEIGHT, cmd->has_color ? color : 0xFF000000);
+        break;
+    case FB_SCENE_RECT:
+        if (dl)
+            hw_fill(dl, a[0], a[1], a[2], a[3], color);
+        else
+            draw_rect(fb, a[0], a[1], a[2], a[3], color);
+        break;
+    case FB_SCENE_BLEND: {
+        uint8_t alpha = (uint8_t)a[4];
+        if (dl) {
+            draw_dl_setfcolor(dl, color);
+            draw_dl_setblendalpha(dl, alpha);
+            draw_dl_patblt(dl, a[0], a[1], a[2], a[3]);
+            draw_dl_setblendoff(dl);
+        } else {
+            uint8_t rgba[4] = { color >> 16, color >> 8, color, alpha };
+            uint32_t src;
+            fb_blend_prepare_rgba(&src, rgba, 1);
+            fb_damage_add(&fb_dmg, a[0], a[1], a[2], a[3]);
+            fb_blend_fill_rect(fb, a[0], a[1], a[2], a[3], src);
         }
+        break;
     }
-    
-    /* Feet (yellow) */
-    for (int foot = 0; foot < 2; foot++) {
-        int foot_x = cx + (foot == 0 ? -25 : 25);
-        int foot_y = cy + 75;
-        
-        /* Foot pad */
-        for (int y = 0; y < 15; y++) {
-            for (int x = -12; x <= 12; x++) {
-                put_pixel(fb, foot_x + x, foot_y + y, 0xFFFFA500);
+    case FB_SCENE_TRI:
+    case FB_SCENE_ELLIPSE:
+    case FB_SCENE_LINE:
+        scene_shape(sc, cmd, color);
+        break;
+    case FB_SCENE_LOGO:
+        if (dl) {
+            hw_upload_logo();
+            fb_tex_bind(dl, &hw_logo_tex);
+            if (sc->key_on) {
+                draw_dl_setstcolor(dl, sc->key);
+                draw_dl_setstmode(dl, 1);
             }
+            draw_dl_bitblt(dl, a[0], a[1], hw_logo_tex.width,
+                           hw_logo_tex.height, 0, 0);
+            draw_dl_setstmode(dl, 0);
+        } else {
+            const struct fb_tex *tex = logo_texture();
+            if (!tex)
+                break;
+            fb_damage_add(&fb_dmg, a[0], a[1], tex->width, tex->height);
+            if (sc->key_on)
+                fb_tex_draw_keyed(fb, tex, a[0], a[1], sc->key);
+            else
+                fb_tex_draw(fb, tex, a[0], a[1]);
         }
-        
-        /* Three toes */
-        for (int toe = 0; toe < 3; toe++) {
-            int toe_x = foot_x + (toe - 1) * 10;
-            for (int y = 0; y < 20; y++) {
-                for (int x = -3; x <= 3; x++) {
-                    put_pixel(fb, toe_x + x, foot_y + 15 + y, 0xFFFFA500);
-                }
-            }
+        break;
+    case FB_SCENE_KEY:
+        sc->key_on = cmd->has_color;
+        sc->key = cmd->color;
+        break;
+    case FB_SCENE_TEXT:
+        if (dl) {
+            /* Glyphs queued in @dl would change color with the atlas */
+            struct fb_text_atlas *font = hw_font_atlas();
+            if (font->valid && font->fg != color)
+                scene_flush(sc);
+            fb_text_dl(sc->dl, font, a[0], a[1], cmd->text,
+                       color, 0, FB_TEXT_TRANSPARENT);
+        } else
+            draw_string(fb, a[0], a[1], cmd->text, color, 0, FB_TEXT_TRANSPARENT);
+        break;
+    case FB_SCENE_TUX:
+        if (dl) {
+            struct tux_pen pen = PEN_DL(dl, hw_dev.caps);
+            vector_tux(&pen);
+        } else {
+            draw_vector_tux(fb);
         }
+        break;
+    case FB_SCENE_FLUSH:
+        scene_flush(sc);
+        break;
+    case FB_SCENE_QUIT:
+        break;
     }
-    
-    /* Wings/flippers */
-    for (int wing = 0; wing < 2; wing++) {
-        int wing_x = cx + (wing == 0 ? -50 : 50);
-        int dir = (wing == 0 ? -1 : 1);
-        
-        for (int y = -30; y <= 30; y++) {
-            for (int x = 0; x < 25; x++) {
-                if (y*y/900.0 + x*x/625.0 <= 1.0)
-                    put_pixel(fb, wing_x + dir * x, cy + y, 0xFF000000);
-            }
+}
+
+/* Returns 1 when the stream ended with "quit" */
+static int scene_stream(struct scene *sc, FILE *in, FILE *reply)
+{
+    char line[FB_SCENE_LINE_MAX], err[128];
+    struct fb_scene_cmd cmd;
+    int lineno = 0;
+
+    while (!stop_requested && fgets(line, sizeof(line), in)) {
+        lineno++;
+        int r = fb_scene_parse(line, &cmd, err, sizeof(err));
+        if (r < 0) {
+            fprintf(reply ? reply : stderr, "error: line %d: %s\n", lineno, err);
+            if (reply)
+                fflush(reply);
+            continue;
+        }
+        if (r == 0)
+            continue;
+        if (cmd.op == FB_SCENE_QUIT)
+            return 1;
+
+        scene_exec(sc, &cmd);
+        if (cmd.op == FB_SCENE_FLUSH && reply) {
+            fputs("ok\n", reply);
+            fflush(reply);
+        }
+    }
+    return 0;
+}
+
+/* Daemon: serve one client at a time; state persists across clients */
+static int scene_listen(struct scene *sc, const char *path)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    int srv = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (srv < 0) {
+        perror("socket");
+        return -1;
+    }
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (bind(srv, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(srv, 4) < 0) {
+        perror(path);
+        close(srv);
+        return -1;
+    }
+
+    /* No SA_RESTART: Ctrl+C / SIGTERM must break out of accept() */
+    struct sigaction sa = { .sa_handler = on_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("scene: listening on %s\n", path);
+    fflush(stdout);
+
+    int quit = 0;
+    while (!stop_requested && !quit) {
+        int c = accept(srv, NULL, NULL);
+        if (c < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("accept");
+            break;
         }
+        FILE *in = fdopen(c, "r");
+        FILE *out = fdopen(dup(c), "w");
+        if (in && out)
+            quit = scene_stream(sc, in, out);
+        if (in) fclose(in); else close(c);
+        if (out) fclose(out);
+    }
+
+    close(srv);
+    unlink(path);
+    return 0;
+}
+
+/* fb_tux [--hw|--drm] scene [FILE | - | --listen PATH] */
+static int scene_main(const struct fb_surface *fb, struct draw_dl *dl,
+                      int argc, char *argv[])
+{
+    struct scene sc = { .fb = fb, .dl = dl, .color = 0xFFFFFFFF };
+    const char *arg = (argc > 2) ? argv[2] : "-";
+
+    if (strcmp(arg, "--listen") == 0)
+        return scene_listen(&sc, (argc > 3) ? argv[3] : "/run/fb_tux.sock");
+
+    FILE *in = strcmp(arg, "-") == 0 ? stdin : fopen(arg, "r");
+    if (!in) {
+        perror(arg);
+        return -1;
     }
+    scene_stream(&sc, in, NULL);
+    if (in != stdin)
+        fclose(in);
+    return 0;
+}
+
+static void run_anim(const struct fb_surface *fb, int frames)
+{
+    const int size = 48;
+    const uint32_t bg = 0xFF404040, fg = 0xFFFFA500;
+    int x = 0, y = 0, vx = 5, vy = 3;
+    int px = x, py = y;
+
+    draw_rect(fb, 0, 0, FB_WIDTH, FB_HEIGHT, bg);
+    for (int f = 0; f < frames && !stop_requested; f++) {
+        /* Erase where the previous frame drew, then draw the new box */
+        draw_rect(fb, px, py, size, size, bg);
+        draw_rect(fb, x, y, size, size, fg);
+        present();
+        fb = next_frame(fb);
+
+        px = x;
+        py = y;
+        x += vx;
+        y += vy;
+        if (x < 0 || x + size > FB_WIDTH)  { vx = -vx; x += 2 * vx; }
+        if (y < 0 || y + size > FB_HEIGHT) { vy = -vy; y += 2 * vy; }
+    }
+}
+
+/* ── Render one mode into fb ──────────────────────────────── */
+static int render_mode(const struct fb_surface *fb, const char *mode, int argc, char *argv[])
+{
+    if (strcmp(mode, "logo") == 0) {
+        int count = (argc > 2) ? atoi(argv[2]) : 1;
+        if (count == 1) {
+            draw_rect(fb, 0, 0, FB_WIDTH, FB_HEIGHT, 0xFF000000);
+            draw_official_logo(fb, FB_WIDTH/2, FB_HEIGHT/2);
+            printf("Drew official Linux boot logo (centered)\n");
+        } else {
+            draw_multiple_logos(fb, count);
+            printf("Drew %d Linux boot logos\n", count);
+        }
+    }
+    else if (strcmp(mode, "tux") == 0) {
+        draw_rect(fb, 0, 0, FB_WIDTH, FB_HEIGHT, 0x40404040);  /* dark gray background */
+        draw_vector_tux(fb);
+        printf("Drew hi-res vector Tux\n");
+    }
+    else if (strcmp(mode, "color") == 0) {
+        draw_color_bars(fb);
+        printf("Drew color bars\n");
+    }
+    else if (strcmp(mode, "gradient") == 0) {
+        draw_gradient_rgb(fb);
+        printf("Drew RGB gradient\n");
+    }
+    else if (strcmp(mode, "clear") == 0) {
+        draw_rect(fb, 0, 0, FB_WIDTH, FB_HEIGHT, 0xFF000000);
+        printf("Cleared framebuffer\n");
+    }
+    else if (strcmp(mode, "fill") == 0) {
+        uint32_t color = 0xFF000000;
+        if (argc > 2)
+            color = 0xFF000000 | (uint32_t)strtol(argv[2], NULL, 16);
+        draw_rect(fb, 0, 0, FB_WIDTH, FB_HEIGHT, color);
+        printf("Filled with color 0x%08X\n", color);
+    }
+    else if (strcmp(mode, "print") == 0) {
+        const char *msg = (argc > 2) ? argv[2] : "Hello from fb_tux";
+        draw_string(fb, 8, 8, msg, 0xFFFFFFFF, 0xFF000000, 0);
+        printf("Printed %zu characters\n", strlen(msg));
+    }
+    else if (strcmp(mode, "scene") == 0) {
+        if (scene_main(fb, NULL, argc, argv) < 0)
+            return -1;
+        printf("Scene done\n");
+    }
+    else if (strcmp(mode, "bench") == 0) {
+        return run_bench(fb, argc, argv);
+    }
+    else if (strcmp(mode, "anim") == 0) {
+        int frames = (argc > 2) ? atoi(argv[2]) : 200;
+        run_anim(fb, frames);
+        printf("Animated %d frames\n", frames);
+        return 0;   /* frames already presented */
+    }
+    else {
+        fprintf(stderr, "Unknown mode: %s\n", mode);
+        fprintf(stderr, "Usage: fb_tux [--hw|--drm] [logo|tux|color|gradient|clear|fill|print|scene|anim|bench|text]\n");
+        return -1;
+    }
+
+    present();
+    return 0;
+}
+
+/* ── DRM/KMS backend main ─────────────────────────────────── */
+/*
+ * Renders into a dumb back buffer and page-flips; the picture stays up
+ * while fb_tux holds DRM master, so wait for Ctrl+C before handing the
+ * CRTC back to fbcon.
+ */
+static int drm_main(const char *mode, int argc, char *argv[])
+{
+    if (fb_drm_open(&drm, "/dev/dri/card0", FB_WIDTH, FB_HEIGHT) < 0)
+        return 1;
+    use_drm = 1;
+    fb_damage_init(&fb_dmg, FB_WIDTH, FB_HEIGHT);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    fb_drm_begin_frame(&drm);
+    fb_surf = (struct fb_surface){ fb_drm_back(&drm), FB_WIDTH, FB_HEIGHT,
+                                   (int)fb_drm_pitch(&drm) };
+    int ret = render_mode(&fb_surf, mode, argc, argv) < 0 ? 1 : 0;
+
+    if (ret == 0) {
+        fb_drm_wait_flip(&drm, 1000);
+        printf("Holding display — Ctrl+C to return to fbcon\n");
+        while (!stop_requested)
+            pause();
+    }
+    fb_drm_close(&drm);
+    return ret;
 }
 
 /* ── Main ─────────────────────────────────────────────────── */
 int main(int argc, char *argv[])
 {
+    if (argc > 1 && strcmp(argv[1], "--hw") == 0) {
+        argc--;
+        argv++;
+        return hw_main((argc > 1) ? argv[1] : "logo", argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--drm") == 0) {
+        argc--;
+        argv++;
+        return drm_main((argc > 1) ? argv[1] : "logo", argc, argv);
+    }
+
     const char *mode = (argc > 1) ? argv[1] : "logo";
     
     if (strcmp(mode, "text") == 0) {
@@ -362,10 +1178,14 @@ int main(int argc, char *argv[])
     if (ioctl(fb_fd, FBIOGET_FSCREENINFO, &finfo) == 0) {
         printf("  Type: %d, Line length: %d\n",
                finfo.type, finfo.line_length);
+        if (finfo.line_length >= FB_WIDTH * FB_BPP) {
+            fb_line_length = finfo.line_length;
+            fb_map_size = (size_t)fb_line_length * FB_HEIGHT;
+        }
     }
     
     /* Map framebuffer */
-    unsigned char *fb = mmap(NULL, FB_SIZE, PROT_READ | PROT_WRITE,
+    unsigned char *fb = mmap(NULL, fb_map_size, PROT_READ | PROT_WRITE,
                             MAP_SHARED, fb_fd, 0);
     if (fb == MAP_FAILED) {
         perror("mmap");
@@ -374,60 +1194,22 @@ int main(int argc, char *argv[])
     }
     
     fb_mmap_ptr = fb;  /* store for fb_flush() msync */
+    fb_damage_init(&fb_dmg, FB_WIDTH, FB_HEIGHT);
     
     /* Suppress fbcon text overlay */
     fbcon_disable();
     
-    /* Render based on mode */
-    if (strcmp(mode, "logo") == 0) {
-        int count = (argc > 2) ? atoi(argv[2]) : 1;
-        if (count == 1) {
-            memset(fb, 0, FB_SIZE);
-            draw_official_logo(fb, FB_WIDTH/2, FB_HEIGHT/2);
-            printf("Drew official Linux boot logo (centered)\n");
-        } else {
-            draw_multiple_logos(fb, count);
-            printf("Drew %d Linux boot logos\n", count);
-        }
-    }
-    else if (strcmp(mode, "tux") == 0) {
-        memset(fb, 0x40, FB_SIZE);  /* dark gray background */
-        draw_vector_tux(fb);
-        printf("Drew hi-res vector Tux\n");
-    }
-    else if (strcmp(mode, "color") == 0) {
-        draw_color_bars(fb);
-        printf("Drew color bars\n");
-    }
-    else if (strcmp(mode, "gradient") == 0) {
-        draw_gradient_rgb(fb);
-        printf("Drew RGB gradient\n");
-    }
-    else if (strcmp(mode, "clear") == 0) {
-        memset(fb, 0, FB_SIZE);
-        printf("Cleared framebuffer\n");
-    }
-    else if (strcmp(mode, "fill") == 0) {
-        uint32_t color = 0xFF000000;
-        if (argc > 2)
-            color = 0xFF000000 | (uint32_t)strtol(argv[2], NULL, 16);
-        for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
-            ((uint32_t *)fb)[i] = color;
-        printf("Filled with color 0x%08X\n", color);
-    }
-    else {
-        fprintf(stderr, "Unknown mode: %s\n", mode);
-        fprintf(stderr, "Usage: fb_tux [logo|tux|color|gradient|clear|fill|text]\n");
-        munmap(fb, FB_SIZE);
+    fb_surf = (struct fb_surface){ fb, FB_WIDTH, FB_HEIGHT, fb_line_length };
+
+    /* Render based on mode, then flush to display */
+    if (render_mode(&fb_surf, mode, argc, argv) < 0) {
+        munmap(fb, fb_map_size);
         close(fb_fd);
         return 1;
     }
     
-    /* Flush to display */
-    fb_flush();
-    
     /* Cleanup */
-    munmap(fb, FB_SIZE);
+    munmap(fb, fb_map_size);
     close(fb_fd);
     fb_fd = -1;
     
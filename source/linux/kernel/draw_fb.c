@@ -0,0 +1,673 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * draw_fb.c — fbdev driver for the Draw Engine scanout, with fbcon
+ * acceleration through the legacy register window
+ *
+ * Registers the reserved scanout region (memory-region, 0x43E0_0000)
+ * as /dev/fb0 and maps the fbcon hooks onto Draw Engine display lists
+ * fed through DRAWCMD:
+ *
+ *   fb_fillrect   → PATBLT
+ *   fb_copyarea   → BITBLT with the frame as its own texture, split into
+ *                   strips whose source and destination never overlap
+ *   fb_imageblit  → background PATBLT + one stencil-keyed BITBLT per 8-px
+ *                   tile, from a glyph cache expanded in VRAM
+ *
+ * so a console scroll is a few dozen command words instead of a 1.2 MB
+ * memmove on the CPU.  Lists are started and left running; the next one
+ * (or fb_sync) waits for DRAWSTAT.BUSY to clear.
+ *
+ * The driver also takes over the generic-uio role for the register
+ * window: /dev/uio0 still maps the 4 KiB window and delivers DRW_IRQ
+ * with the same mask-on-interrupt semantics.  While a process holds it
+ * open (fb_tux --hw, fb_bench) the engine is theirs, and fbcon falls
+ * back to the cfb_* helpers.  The glyph cache is dropped on the last
+ * close, since userspace is free to reuse that VRAM.
+ *
+ * Dropped into drivers/video/fbdev by source/scripts/build_linux.sh
+ * (CONFIG_FB_DRAW_ENGINE).  Register and opcode values mirror
+ * source/linux/draw_dl.h.
+ */
+#include <linux/bitops.h>
+#include <linux/delay.h>
+#include <linux/fb.h>
+#include <linux/interrupt.h>
+#include <linux/io.h>
+#include <linux/iopoll.h>
+#include <linux/jhash.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/of_address.h>
+#include <linux/platform_device.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/uio_driver.h>
+
+/* Legacy register window (draw_dl.h DRAW_REG_*) */
+#define DRAW_REG_CTRL		0x00
+#define DRAW_REG_STAT		0x04
+#define DRAW_REG_BUFSTAT	0x08
+#define DRAW_REG_CMD		0x0C
+#define DRAW_REG_INT		0x10
+#define DRAW_REG_CAPS		0x14
+#define DRAW_REG_RINGSIZE	0x24
+
+#define DRAW_CTRL_EXE		BIT(0)
+#define DRAW_CTRL_RST		BIT(1)
+#define DRAW_STAT_BUSY		BIT(0)
+#define DRAW_STAT_ERR(s)	(((s) >> 16) & 0x7)
+#define DRAW_BUF_FULL		BIT(17)
+#define DRAW_INT_CLR		BIT(1)
+#define DRAW_CAPS_RING		BIT(0)
+
+#define DRAW_OP_EODL		0x0F
+#define DRAW_OP_SETFRAME	0x20
+#define DRAW_OP_SETDRAWAREA	0x21
+#define DRAW_OP_SETTEXTURE	0x22
+#define DRAW_OP_SETFCOLOR	0x23
+#define DRAW_OP_SETSTCOLOR	0x24
+#define DRAW_OP_SETSTMODE	0x30
+#define DRAW_OP_SETBLENDOFF	0x32
+#define DRAW_OP_PATBLT		0x81
+#define DRAW_OP_BITBLT		0x82
+
+#define DRAW_CMD(op, arg)	(((u32)(op) << 24) | ((u32)(arg) & 0xFFFFFF))
+#define DRAW_XY(x, y)		((((u32)(x) & 0xFFFF) << 16) | ((u32)(y) & 0xFFFF))
+
+#define DFB_TIMEOUT_US		100000
+#define DFB_DL_WORDS		512	/* one list, flushed early when full */
+
+/*
+ * Glyph cache: 8 × DFB_TILE_H ARGB tiles, DFB_TILE_COLS to a row of
+ * the atlas texture, placed after the frame.  A tile is keyed on its
+ * 1-bpp rows and the color it was expanded in; unset pixels hold ~fg,
+ * the stencil key.
+ */
+#define DFB_TILE_W		8
+#define DFB_TILE_H		32
+#define DFB_TILE_COLS		32
+#define DFB_TILES		512
+#define DFB_ATLAS_W		(DFB_TILE_COLS * DFB_TILE_W)
+#define DFB_ATLAS_H		(DFB_TILES / DFB_TILE_COLS * DFB_TILE_H)
+#define DFB_ATLAS_SIZE		(DFB_ATLAS_W * DFB_ATLAS_H * 4)
+
+struct dfb_tile {
+	u32 fg;
+	u32 seq;		/* last list that referenced it */
+	u8 h;
+	u8 bits[DFB_TILE_H];
+};
+
+struct draw_fb {
+	struct device *dev;
+	void __iomem *regs;
+	void __iomem *vram;
+	phys_addr_t vram_phys;
+	u32 caps;
+
+	spinlock_t lock;	/* engine, list and glyph cache */
+	unsigned int users;	/* /dev/uio0 holders */
+	bool broken;		/* timed out once; CPU only from then on */
+
+	u32 dl[DFB_DL_WORDS];
+	unsigned int len;
+	u32 seq;		/* list being built */
+
+	struct dfb_tile *tiles;	/* NULL: no room for the atlas */
+	u32 __iomem *atlas;
+	phys_addr_t atlas_phys;
+
+	struct uio_info uio;
+	unsigned long irq_disabled;
+
+	u32 pseudo_palette[16];
+};
+
+/* ── Engine ───────────────────────────────────────────────── */
+static int dfb_wait_idle(struct draw_fb *dfb)
+{
+	u32 stat;
+
+	if (dfb->broken)
+		return -EIO;
+	if (readl_poll_timeout_atomic(dfb->regs + DRAW_REG_STAT, stat,
+				      !(stat & DRAW_STAT_BUSY), 1, DFB_TIMEOUT_US)) {
+		dev_err(dfb->dev, "timeout (DRAWSTAT=0x%08x), acceleration off\n", stat);
+		writel(DRAW_CTRL_RST, dfb->regs + DRAW_REG_CTRL);
+		dfb->broken = true;
+		return -ETIMEDOUT;
+	}
+	if (DRAW_STAT_ERR(stat))
+		dev_warn_ratelimited(dfb->dev, "error %u (DRAWSTAT=0x%08x)\n",
+				     DRAW_STAT_ERR(stat), stat);
+	return 0;
+}
+
+static bool dfb_accel(struct draw_fb *dfb)
+{
+	return !dfb->users && !dfb->broken;
+}
+
+static void dfb_emit(struct draw_fb *dfb, u32 word)
+{
+	dfb->dl[dfb->len++] = word;
+}
+
+/* Full state at the head of every list: userspace may have changed it */
+static void dfb_begin(struct draw_fb *dfb, struct fb_info *info)
+{
+	dfb->len = 0;
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETFRAME, 0));
+	dfb_emit(dfb, dfb->vram_phys);
+	dfb_emit(dfb, DRAW_XY(info->var.xres, info->var.yres));
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETDRAWAREA, 0));
+	dfb_emit(dfb, DRAW_XY(0, 0));
+	dfb_emit(dfb, DRAW_XY(info->var.xres, info->var.yres));
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETBLENDOFF, 0));
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETSTMODE, 0));
+}
+
+/*
+ * Feed the list to DRAWCMD and start it; as in draw_dev_submit(), a
+ * list longer than the FIFO is started once the FIFO fills and topped
+ * up while the engine drains it.
+ */
+static int dfb_submit(struct draw_fb *dfb)
+{
+	bool started = false;
+	unsigned int i;
+	u32 buf;
+
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_EODL, 0));
+	if (dfb_wait_idle(dfb))
+		return -EIO;
+
+	wmb();	/* glyph tiles written through the WC mapping */
+	for (i = 0; i < dfb->len; i++) {
+		if (readl(dfb->regs + DRAW_REG_BUFSTAT) & DRAW_BUF_FULL) {
+			if (!started) {
+				writel(DRAW_CTRL_EXE, dfb->regs + DRAW_REG_CTRL);
+				started = true;
+			}
+			if (readl_poll_timeout_atomic(dfb->regs + DRAW_REG_BUFSTAT, buf,
+						      !(buf & DRAW_BUF_FULL), 1,
+						      DFB_TIMEOUT_US)) {
+				dev_err(dfb->dev, "command FIFO stalled, acceleration off\n");
+				writel(DRAW_CTRL_RST, dfb->regs + DRAW_REG_CTRL);
+				dfb->broken = true;
+				return -ETIMEDOUT;
+			}
+		}
+		writel(dfb->dl[i], dfb->regs + DRAW_REG_CMD);
+	}
+	if (!started)
+		writel(DRAW_CTRL_EXE, dfb->regs + DRAW_REG_CTRL);
+
+	dfb->len = 0;
+	dfb->seq++;
+	return 0;
+}
+
+/*
+ * Make room for @n words plus a closing one and the EODL; false when
+ * the list had to be restarted, with only the dfb_begin() state left.
+ */
+static bool dfb_reserve(struct draw_fb *dfb, struct fb_info *info, unsigned int n)
+{
+	if (dfb->len + n + 2 <= DFB_DL_WORDS)
+		return true;
+	dfb_submit(dfb);
+	dfb_begin(dfb, info);
+	return false;
+}
+
+static u32 dfb_color(struct fb_info *info, u32 color)
+{
+	return ((u32 *)info->pseudo_palette)[color];
+}
+
+/* ── fbcon hooks ──────────────────────────────────────────── */
+static void dfb_fillrect(struct fb_info *info, const struct fb_fillrect *rect)
+{
+	struct draw_fb *dfb = info->par;
+	unsigned long flags;
+
+	spin_lock_irqsave(&dfb->lock, flags);
+	if (!dfb_accel(dfb) || rect->rop != ROP_COPY) {
+		if (!dfb->users)
+			dfb_wait_idle(dfb);
+		cfb_fillrect(info, rect);
+		goto out;
+	}
+
+	dfb_begin(dfb, info);
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETFCOLOR, 0));
+	dfb_emit(dfb, dfb_color(info, rect->color));
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_PATBLT, 0));
+	dfb_emit(dfb, DRAW_XY(rect->dx, rect->dy));
+	dfb_emit(dfb, DRAW_XY(rect->width, rect->height));
+	dfb_submit(dfb);
+out:
+	spin_unlock_irqrestore(&dfb->lock, flags);
+}
+
+/* The frame is its own texture for copyarea */
+static void dfb_frame_texture(struct draw_fb *dfb, struct fb_info *info)
+{
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETTEXTURE, 0));
+	dfb_emit(dfb, dfb->vram_phys);
+	dfb_emit(dfb, DRAW_XY(info->var.xres, info->var.yres));
+}
+
+static void dfb_blt(struct draw_fb *dfb, struct fb_info *info, u32 dx, u32 dy,
+		    u32 w, u32 h, u32 sx, u32 sy)
+{
+	if (!dfb_reserve(dfb, info, 4))
+		dfb_frame_texture(dfb, info);
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_BITBLT, 0));
+	dfb_emit(dfb, DRAW_XY(dx, dy));
+	dfb_emit(dfb, DRAW_XY(w, h));
+	dfb_emit(dfb, DRAW_XY(sx, sy));
+}
+
+/*
+ * The engine makes no promise about the order it walks a BITBLT in, so
+ * an overlapping move is cut, along the direction it moves, into strips
+ * as thick as the distance moved.  Each strip then reads only pixels no
+ * earlier strip has written.
+ */
+static void dfb_copyarea(struct fb_info *info, const struct fb_copyarea *area)
+{
+	struct draw_fb *dfb = info->par;
+	u32 w = area->width, h = area->height;
+	u32 sx = area->sx, sy = area->sy, dx = area->dx, dy = area->dy;
+	unsigned long flags;
+	u32 step, i;
+
+	spin_lock_irqsave(&dfb->lock, flags);
+	if (!dfb_accel(dfb)) {
+		if (!dfb->users)
+			dfb_wait_idle(dfb);
+		cfb_copyarea(info, area);
+		goto out;
+	}
+
+	dfb_begin(dfb, info);
+	dfb_frame_texture(dfb, info);
+
+	if (abs((int)dx - (int)sx) >= (int)w || abs((int)dy - (int)sy) >= (int)h) {
+		dfb_blt(dfb, info, dx, dy, w, h, sx, sy);
+	} else if (dy < sy) {
+		for (step = sy - dy, i = 0; i < h; i += step)
+			dfb_blt(dfb, info, dx, dy + i, w, min(step, h - i), sx, sy + i);
+	} else if (dy > sy) {
+		for (step = dy - sy, i = h; i > 0; i -= min(step, i))
+			dfb_blt(dfb, info, dx, dy + i - min(step, i), w, min(step, i),
+				sx, sy + i - min(step, i));
+	} else if (dx < sx) {
+		for (step = sx - dx, i = 0; i < w; i += step)
+			dfb_blt(dfb, info, dx + i, dy, min(step, w - i), h, sx + i, sy);
+	} else if (dx > sx) {
+		for (step = dx - sx, i = w; i > 0; i -= min(step, i))
+			dfb_blt(dfb, info, dx + i - min(step, i), dy, min(step, i), h,
+				sx + i - min(step, i), sy);
+	}
+	dfb_submit(dfb);
+out:
+	spin_unlock_irqrestore(&dfb->lock, flags);
+}
+
+static void dfb_glyph_state(struct draw_fb *dfb, u32 fg)
+{
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETTEXTURE, 0));
+	dfb_emit(dfb, dfb->atlas_phys);
+	dfb_emit(dfb, DRAW_XY(DFB_ATLAS_W, DFB_ATLAS_H));
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETSTCOLOR, 0));
+	dfb_emit(dfb, ~fg);
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETSTMODE, 1));
+}
+
+/*
+ * Cache slot holding @bits (@h rows) in @fg, expanding it on a miss.
+ * The slot being replaced may still be read by a list already started,
+ * or by the one being built: finish both before overwriting it.
+ */
+static unsigned int dfb_tile(struct draw_fb *dfb, struct fb_info *info,
+			     const u8 *bits, u32 h, u32 fg)
+{
+	unsigned int slot = jhash(bits, h, fg) % DFB_TILES;
+	struct dfb_tile *t = &dfb->tiles[slot];
+	u32 __iomem *dst;
+	u32 key = ~fg, r, b;
+
+	if (t->h == h && t->fg == fg && !memcmp(t->bits, bits, h))
+		goto hit;
+
+	if (t->h && t->seq == dfb->seq) {
+		dfb_submit(dfb);
+		dfb_begin(dfb, info);
+		dfb_glyph_state(dfb, fg);
+	}
+	dfb_wait_idle(dfb);
+
+	dst = dfb->atlas + (slot / DFB_TILE_COLS) * DFB_TILE_H * DFB_ATLAS_W +
+	      (slot % DFB_TILE_COLS) * DFB_TILE_W;
+	for (r = 0; r < h; r++, dst += DFB_ATLAS_W)
+		for (b = 0; b < DFB_TILE_W; b++)
+			writel_relaxed(bits[r] & (0x80 >> b) ? fg : key, dst + b);
+
+	t->h = h;
+	t->fg = fg;
+	memcpy(t->bits, bits, h);
+hit:
+	t->seq = dfb->seq;
+	return slot;
+}
+
+static void dfb_imageblit(struct fb_info *info, const struct fb_image *image)
+{
+	struct draw_fb *dfb = info->par;
+	u32 pitch = DIV_ROUND_UP(image->width, 8), h = image->height;
+	u32 fg, bg, col, r, w;
+	u8 bits[DFB_TILE_H], mask, any;
+	unsigned long flags;
+	unsigned int slot;
+
+	spin_lock_irqsave(&dfb->lock, flags);
+	if (!dfb_accel(dfb) || !dfb->tiles || image->depth != 1 || h > DFB_TILE_H) {
+		if (!dfb->users)
+			dfb_wait_idle(dfb);
+		cfb_imageblit(info, image);
+		goto out;
+	}
+
+	fg = dfb_color(info, image->fg_color);
+	bg = dfb_color(info, image->bg_color);
+
+	dfb_begin(dfb, info);
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETFCOLOR, 0));
+	dfb_emit(dfb, bg);
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_PATBLT, 0));
+	dfb_emit(dfb, DRAW_XY(image->dx, image->dy));
+	dfb_emit(dfb, DRAW_XY(image->width, h));
+	dfb_glyph_state(dfb, fg);
+
+	for (col = 0; col < pitch; col++) {
+		w = min_t(u32, DFB_TILE_W, image->width - col * DFB_TILE_W);
+		mask = 0xFF << (DFB_TILE_W - w);
+		for (any = 0, r = 0; r < h; r++) {
+			bits[r] = image->data[r * pitch + col] & mask;
+			any |= bits[r];
+		}
+		if (!any)
+			continue;	/* background only */
+
+		if (!dfb_reserve(dfb, info, 4))
+			dfb_glyph_state(dfb, fg);
+		slot = dfb_tile(dfb, info, bits, h, fg);
+		dfb_emit(dfb, DRAW_CMD(DRAW_OP_BITBLT, 0));
+		dfb_emit(dfb, DRAW_XY(image->dx + col * DFB_TILE_W, image->dy));
+		dfb_emit(dfb, DRAW_XY(w, h));
+		dfb_emit(dfb, DRAW_XY((slot % DFB_TILE_COLS) * DFB_TILE_W,
+				      (slot / DFB_TILE_COLS) * DFB_TILE_H));
+	}
+	dfb_emit(dfb, DRAW_CMD(DRAW_OP_SETSTMODE, 0));
+	dfb_submit(dfb);
+out:
+	spin_unlock_irqrestore(&dfb->lock, flags);
+}
+
+static int dfb_sync(struct fb_info *info)
+{
+	struct draw_fb *dfb = info->par;
+	unsigned long flags;
+
+	spin_lock_irqsave(&dfb->lock, flags);
+	if (!dfb->users)
+		dfb_wait_idle(dfb);
+	spin_unlock_irqrestore(&dfb->lock, flags);
+	return 0;
+}
+
+static int dfb_setcolreg(unsigned int regno, unsigned int red, unsigned int green,
+			 unsigned int blue, unsigned int transp, struct fb_info *info)
+{
+	if (regno >= 16)
+		return -EINVAL;
+	/* Always opaque: the scanout is ARGB8888 */
+	((u32 *)info->pseudo_palette)[regno] = 0xFF000000 |
+		(red >> 8) << 16 | (green >> 8) << 8 | (blue >> 8);
+	return 0;
+}
+
+static const struct fb_ops dfb_ops = {
+	.owner		= THIS_MODULE,
+	.fb_setcolreg	= dfb_setcolreg,
+	.fb_fillrect	= dfb_fillrect,
+	.fb_copyarea	= dfb_copyarea,
+	.fb_imageblit	= dfb_imageblit,
+	.fb_sync	= dfb_sync,
+};
+
+/* ── /dev/uio0 ────────────────────────────────────────────── */
+static irqreturn_t dfb_uio_handler(int irq, struct uio_info *uio)
+{
+	struct draw_fb *dfb = uio->priv;
+
+	/* Same as generic-uio: masked until userspace writes 1 to the fd */
+	if (!test_and_set_bit(0, &dfb->irq_disabled))
+		disable_irq_nosync(irq);
+	return IRQ_HANDLED;
+}
+
+static int dfb_uio_irqcontrol(struct uio_info *uio, s32 on)
+{
+	struct draw_fb *dfb = uio->priv;
+
+	if (on) {
+		if (test_and_clear_bit(0, &dfb->irq_disabled))
+			enable_irq(uio->irq);
+	} else if (!test_and_set_bit(0, &dfb->irq_disabled)) {
+		disable_irq_nosync(uio->irq);
+	}
+	return 0;
+}
+
+static int dfb_uio_open(struct uio_info *uio, struct inode *inode)
+{
+	struct draw_fb *dfb = uio->priv;
+	unsigned long flags;
+
+	spin_lock_irqsave(&dfb->lock, flags);
+	if (!dfb->users++)
+		dfb_wait_idle(dfb);	/* let the last console list finish */
+	spin_unlock_irqrestore(&dfb->lock, flags);
+	return 0;
+}
+
+static int dfb_uio_release(struct uio_info *uio, struct inode *inode)
+{
+	struct draw_fb *dfb = uio->priv;
+	unsigned long flags;
+
+	spin_lock_irqsave(&dfb->lock, flags);
+	if (!--dfb->users) {
+		u32 stat;
+
+		/*
+		 * A client killed mid-list can leave the engine busy, and a
+		 * busy engine ignores ring writes: let the list finish, else
+		 * abandon it with a reset.
+		 */
+		if (readl_poll_timeout_atomic(dfb->regs + DRAW_REG_STAT, stat,
+					      !(stat & DRAW_STAT_BUSY), 1, DFB_TIMEOUT_US))
+			writel(DRAW_CTRL_RST, dfb->regs + DRAW_REG_CTRL);
+		/* Back to the FIFO with interrupts off, as the driver left it */
+		if (dfb->caps & DRAW_CAPS_RING)
+			writel(0, dfb->regs + DRAW_REG_RINGSIZE);
+		writel(DRAW_INT_CLR, dfb->regs + DRAW_REG_INT);
+		if (dfb->tiles)
+			memset(dfb->tiles, 0, DFB_TILES * sizeof(*dfb->tiles));
+	}
+	spin_unlock_irqrestore(&dfb->lock, flags);
+	return 0;
+}
+
+/* ── Probe ────────────────────────────────────────────────── */
+static int dfb_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct device_node *mem;
+	struct resource *regs, vram;
+	struct fb_info *info;
+	struct draw_fb *dfb;
+	u32 width = 640, height = 480, frame;
+	int irq, ret;
+
+	regs = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+	if (!regs)
+		return -EINVAL;
+	irq = platform_get_irq(pdev, 0);
+	if (irq < 0)
+		return irq;
+
+	mem = of_parse_phandle(dev->of_node, "memory-region", 0);
+	if (!mem)
+		return dev_err_probe(dev, -EINVAL, "no memory-region\n");
+	ret = of_address_to_resource(mem, 0, &vram);
+	of_node_put(mem);
+	if (ret)
+		return ret;
+
+	of_property_read_u32(dev->of_node, "width", &width);
+	of_property_read_u32(dev->of_node, "height", &height);
+	frame = PAGE_ALIGN(width * height * 4);
+	if (resource_size(&vram) < frame)
+		return dev_err_probe(dev, -EINVAL, "memory-region too small\n");
+
+	info = framebuffer_alloc(sizeof(*dfb), dev);
+	if (!info)
+		return -ENOMEM;
+	dfb = info->par;
+	dfb->dev = dev;
+	spin_lock_init(&dfb->lock);
+
+	dfb->regs = devm_ioremap_resource(dev, regs);
+	if (IS_ERR(dfb->regs)) {
+		ret = PTR_ERR(dfb->regs);
+		goto err_release;
+	}
+	dfb->vram = devm_ioremap_wc(dev, vram.start, resource_size(&vram));
+	if (!dfb->vram) {
+		ret = -ENOMEM;
+		goto err_release;
+	}
+	dfb->vram_phys = vram.start;
+	dfb->caps = readl(dfb->regs + DRAW_REG_CAPS);
+
+	if (resource_size(&vram) >= frame + DFB_ATLAS_SIZE) {
+		dfb->tiles = devm_kcalloc(dev, DFB_TILES, sizeof(*dfb->tiles), GFP_KERNEL);
+		dfb->atlas = dfb->vram + frame;
+		dfb->atlas_phys = vram.start + frame;
+	}
+	if (!dfb->tiles)
+		dev_info(dev, "no room for the glyph cache, imageblit on the CPU\n");
+
+	writel(DRAW_CTRL_RST, dfb->regs + DRAW_REG_CTRL);
+	usleep_range(1000, 2000);
+	if (dfb->caps & DRAW_CAPS_RING)
+		writel(0, dfb->regs + DRAW_REG_RINGSIZE);
+	writel(DRAW_INT_CLR, dfb->regs + DRAW_REG_INT);
+
+	strscpy(info->fix.id, "draw_fb", sizeof(info->fix.id));
+	info->fix.type = FB_TYPE_PACKED_PIXELS;
+	info->fix.visual = FB_VISUAL_TRUECOLOR;
+	info->fix.smem_start = vram.start;
+	info->fix.smem_len = frame;
+	info->fix.line_length = width * 4;
+	info->fix.accel = FB_ACCEL_NONE;
+
+	info->var.xres = info->var.xres_virtual = width;
+	info->var.yres = info->var.yres_virtual = height;
+	info->var.bits_per_pixel = 32;
+	info->var.red = (struct fb_bitfield){ 16, 8, 0 };
+	info->var.green = (struct fb_bitfield){ 8, 8, 0 };
+	info->var.blue = (struct fb_bitfield){ 0, 8, 0 };
+	info->var.activate = FB_ACTIVATE_NOW;
+	info->var.height = info->var.width = -1;
+	info->var.vmode = FB_VMODE_NONINTERLACED;
+
+	info->fbops = &dfb_ops;
+	info->screen_base = dfb->vram;
+	info->screen_size = frame;
+	info->pseudo_palette = dfb->pseudo_palette;
+	info->flags = FBINFO_HWACCEL_FILLRECT | FBINFO_HWACCEL_COPYAREA |
+		      FBINFO_HWACCEL_IMAGEBLIT;
+
+	ret = fb_alloc_cmap(&info->cmap, 16, 0);
+	if (ret)
+		goto err_release;
+
+	dfb->uio.name = "draw-engine";
+	dfb->uio.version = "1";
+	dfb->uio.mem[0].name = "regs";
+	dfb->uio.mem[0].addr = regs->start;
+	dfb->uio.mem[0].size = resource_size(regs);
+	dfb->uio.mem[0].memtype = UIO_MEM_PHYS;
+	dfb->uio.irq = irq;
+	dfb->uio.handler = dfb_uio_handler;
+	dfb->uio.irqcontrol = dfb_uio_irqcontrol;
+	dfb->uio.open = dfb_uio_open;
+	dfb->uio.release = dfb_uio_release;
+	dfb->uio.priv = dfb;
+	ret = uio_register_device(dev, &dfb->uio);
+	if (ret)
+		goto err_cmap;
+
+	ret = register_framebuffer(info);
+	if (ret)
+		goto err_uio;
+
+	platform_set_drvdata(pdev, info);
+	fb_info(info, "%ux%u at %pa, caps 0x%x\n", width, height, &vram.start, dfb->caps);
+	return 0;
+
+err_uio:
+	uio_unregister_device(&dfb->uio);
+err_cmap:
+	fb_dealloc_cmap(&info->cmap);
+err_release:
+	framebuffer_release(info);
+	return ret;
+}
+
+static void dfb_remove(struct platform_device *pdev)
+{
+	struct fb_info *info = platform_get_drvdata(pdev);
+	struct draw_fb *dfb = info->par;
+
+	unregister_framebuffer(info);
+	dfb_sync(info);
+	uio_unregister_device(&dfb->uio);
+	fb_dealloc_cmap(&info->cmap);
+	framebuffer_release(info);
+}
+
+static const struct of_device_id dfb_of_match[] = {
+	{ .compatible = "litex,draw-engine" },
+	{ }
+};
+MODULE_DEVICE_TABLE(of, dfb_of_match);
+
+static struct platform_driver dfb_driver = {
+	.probe = dfb_probe,
+	.remove_new = dfb_remove,
+	.driver = {
+		.name = "draw_fb",
+		.of_match_table = dfb_of_match,
+	},
+};
+module_platform_driver(dfb_driver);
+
+MODULE_DESCRIPTION("Draw Engine framebuffer with accelerated fbcon");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""
+bench_check.py — Compare a draw_bench report against a baseline.
+
+Fails when any case's memory efficiency (px_per_beat, beats_per_burst) or
+modelled throughput (px_per_clk, px_per_clk_4p) drops by more than the
+tolerance, or when a baseline case is missing.  Metrics the baseline does
+not record yet are skipped.
+
+Usage:
+  python3 bench_check.py results/bench.json results/bench_baseline.json \
+      [--tolerance 10]
+"""
+
+import argparse
+import json
+import sys
+
+METRICS = ("px_per_beat", "beats_per_burst", "px_per_clk", "px_per_clk_4p")
+
+
+def load(path: str) -> dict:
+    with open(path) as f:
+        report = json.load(f)
+    return {(r["op"], r["res"], r["shape"]): r for r in report["results"]}
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("report")
+    parser.add_argument("baseline")
+    parser.add_argument("--tolerance", type=float, default=10.0,
+                        help="allowed drop in percent (default: 10)")
+    args = parser.parse_args()
+
+    report = load(args.report)
+    baseline = load(args.baseline)
+    failures = 0
+
+    for key, base in sorted(baseline.items()):
+        name = "/".join(key)
+        cur = report.get(key)
+        if cur is None:
+            print(f"  ✗ {name}: missing from report")
+            failures += 1
+            continue
+        for m in METRICS:
+            if m not in base:
+                continue
+            limit = base[m] * (1 - args.tolerance / 100)
+            if cur[m] < limit:
+                print(f"  ✗ {name}: {m} {cur[m]:.4f} < {base[m]:.4f} "
+                      f"(-{args.tolerance:g}%)")
+                failures += 1
+
+    print(f"  Benchmark cases: {len(report)} "
+          f"(baseline {len(baseline)}, tolerance {args.tolerance:g}%)")
+    if failures:
+        print(f"  ✗ {failures} regression(s)")
+        return 1
+    print("  ✓ No throughput regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -3,7 +3,8 @@
 #
 # Produces:
 #   boot/fw_jump.bin                    OpenSBI firmware (fw_jump, rv32)
-#   boot/Image                          Linux kernel Image (rv32ima, minimal)
+#   boot/Image                          Linux kernel Image (rv32ima, minimal,
+#                                       with the draw_fb fbcon driver)
 #   boot/rootfs.cpio                    Minimal initramfs with busybox + UIO test
 #   boot/draw_engine_soc_virtio.dtb     Compiled device tree
 #
@@ -120,6 +121,35 @@ fi
 # ══════════════════════════════════════════════════════════════
 LINUX_SRC_DIR="$BUILD_DIR/linux"
 LINUX_VERSION="v6.6"
+DRAW_FB_SRC="$PROJECT_ROOT/linux/kernel/draw_fb.c"
+
+# Drop draw_fb.c into the fbdev directory and register it once
+install_draw_fb() {
+    local fbdev="$LINUX_SRC_DIR/drivers/video/fbdev"
+
+    cp "$DRAW_FB_SRC" "$fbdev/draw_fb.c"
+    if ! grep -q FB_DRAW_ENGINE "$fbdev/Kconfig"; then
+        cat >> "$fbdev/Kconfig" <<'KCONFIG'
+
+config FB_DRAW_ENGINE
+	bool "Draw Engine framebuffer with accelerated fbcon"
+	depends on FB && OF && UIO && HAS_IOMEM
+	select FB_CFB_FILLRECT
+	select FB_CFB_COPYAREA
+	select FB_CFB_IMAGEBLIT
+	help
+	  Scanout of the Draw Engine SoC as /dev/fb0, with fbcon fills,
+	  scrolls and glyphs drawn by the engine, and /dev/uio0 for
+	  userspace access to its register window.
+KCONFIG
+        echo 'obj-$(CONFIG_FB_DRAW_ENGINE) += draw_fb.o' >> "$fbdev/Makefile"
+    fi
+}
+
+if [[ -f "$BOOT_DIR/Image" && "$DRAW_FB_SRC" -nt "$BOOT_DIR/Image" ]]; then
+    info "draw_fb.c is newer than Image — rebuilding kernel..."
+    rm -f "$BOOT_DIR/Image"
+fi
 
 if [[ ! -f "$BOOT_DIR/Image" ]]; then
     info "Building Linux kernel $LINUX_VERSION..."
@@ -130,6 +160,7 @@ if [[ ! -f "$BOOT_DIR/Image" ]]; then
     fi
 
     cd "$LINUX_SRC_DIR"
+    install_draw_fb
 
     # Create seed config — KCONFIG_ALLCONFIG forces these during allnoconfig
     # so arch-level settings like 32-bit are applied from the start
@@ -173,13 +204,17 @@ CONFIG_VIRTIO_MMIO=y
 CONFIG_DRM=y
 CONFIG_DRM_VIRTIO_GPU=y
 CONFIG_DRM_VIRTIO_GPU_KMS=y
-CONFIG_DRM_FBDEV_EMULATION=y
+# fbcon runs on draw_fb (/dev/fb0), not on a virtio-gpu shadow buffer
+# CONFIG_DRM_FBDEV_EMULATION is not set
 CONFIG_FB=y
 CONFIG_FB_DEVICE=y
 CONFIG_FRAMEBUFFER_CONSOLE=y
+# Scroll with fb_copyarea instead of redrawing every glyph
+CONFIG_FRAMEBUFFER_CONSOLE_LEGACY_ACCELERATION=y
 
-# ── UIO for legacy draw_engine path ──
+# ── Draw Engine fbdev + UIO for the legacy draw_engine path ──
 CONFIG_UIO=y
+CONFIG_FB_DRAW_ENGINE=y
 
 # ── /dev/mem for direct physical memory access (FB flush) ──
 CONFIG_DEVMEM=y
@@ -476,7 +511,17 @@ INITEOF
             -O2 -static \
             -I"$PROJECT_ROOT/linux" \
             -o "$ROOTFS_DIR/usr/bin/fb_tux" \
-            "$PROJECT_ROOT/linux/fb_tux.c" 2>&1 \
+            "$PROJECT_ROOT/linux/fb_tux.c" \
+            "$PROJECT_ROOT/linux/fb_bench.c" \
+            "$PROJECT_ROOT/linux/fb_blend.c" \
+            "$PROJECT_ROOT/linux/fb_damage.c" \
+            "$PROJECT_ROOT/linux/fb_drm.c" \
+            "$PROJECT_ROOT/linux/fb_scene.c" \
+            "$PROJECT_ROOT/linux/fb_shape.c" \
+            "$PROJECT_ROOT/linux/fb_span.c" \
+            "$PROJECT_ROOT/linux/fb_tex.c" \
+            "$PROJECT_ROOT/linux/fb_text.c" \
+            "$PROJECT_ROOT/linux/draw_dl.c" 2>&1 \
             && ok "fb_tux included in rootfs" \
             || warn "fb_tux compilation failed (non-fatal)"
     fi
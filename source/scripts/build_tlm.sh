@@ -0,0 +1,90 @@
+#!/usr/bin/env bash
+# build_tlm.sh — Build the transaction-level Draw Engine co-sim library
+#
+# Produces:
+#   lib/libdraw_tlm.so    Functional model with the same co-simulation
+#                         ABI as lib/libVtop_virtio.so (see source/cosim)
+#
+# Requirements (via nix develop .#cosim):
+#   - g++ (C++17)
+#   - Renode with its co-simulation IntegrationLibrary sources; found
+#     next to the renode binary, or set RENODE_INTEGRATION explicitly
+#
+# Usage:
+#   nix develop .#cosim
+#   ./source/scripts/build_tlm.sh [--clean]
+#   make demo-linux COSIM=tlm
+#
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+PROJECT_ROOT="$(cd "$SCRIPT_DIR/../.." && pwd)"
+SRC_DIR="$PROJECT_ROOT/source/cosim"
+BUILD_DIR="$PROJECT_ROOT/source/cosim/build"
+OUT="$PROJECT_ROOT/lib/libdraw_tlm.so"
+
+CXX="${CXX:-g++}"
+CXXFLAGS="${CXXFLAGS:--O2 -g}"
+
+# ── Color output ─────────────────────────────────────────────
+info()  { printf "\033[1;34m[INFO]\033[0m  %s\n" "$*"; }
+ok()    { printf "\033[1;32m[OK]\033[0m    %s\n" "$*"; }
+err()   { printf "\033[1;31m[ERR]\033[0m   %s\n" "$*" >&2; }
+
+# ── Clean ────────────────────────────────────────────────────
+if [[ "${1:-}" == "--clean" ]]; then
+    info "Cleaning build artifacts..."
+    rm -rf "$BUILD_DIR" "$OUT"
+    ok "Clean done."
+    exit 0
+fi
+
+# ── Locate IntegrationLibrary ────────────────────────────────
+find_integration() {
+    local root
+    root="$(dirname "$(readlink -f "$(command -v renode)")")/.."
+    for d in "$root/plugins/IntegrationLibrary" \
+             "$root/src/Plugins/CoSimulationPlugin/IntegrationLibrary" \
+             "$root/share/renode/plugins/IntegrationLibrary"; do
+        [[ -f "$d/src/renode_bus.h" ]] && { readlink -f "$d"; return; }
+    done
+}
+
+if ! command -v "$CXX" &>/dev/null; then
+    err "$CXX not found. Enter 'nix develop .#cosim' first."
+    exit 1
+fi
+
+INTEG="${RENODE_INTEGRATION:-}"
+if [[ -z "$INTEG" ]] && command -v renode &>/dev/null; then
+    INTEG="$(find_integration || true)"
+fi
+if [[ -z "$INTEG" || ! -f "$INTEG/src/renode_bus.h" ]]; then
+    err "Renode IntegrationLibrary not found; set RENODE_INTEGRATION=<dir>."
+    exit 1
+fi
+info "IntegrationLibrary: $INTEG"
+
+# Agent + socket transport only; no Verilator bus adapters or DPI
+SOURCES=("$SRC_DIR/draw_tlm.cpp" "$SRC_DIR/sim_main_tlm.cpp")
+while IFS= read -r f; do
+    SOURCES+=("$f")
+done < <(find "$INTEG/src" "$INTEG/libs/socket-cpp/Socket" -maxdepth 2 -name '*.cpp' \
+             \( -path '*/src/renode_bus.cpp' -o -path '*/src/buses/bus.cpp' \
+                -o -path '*/communication/socket_channel.cpp' -o -path '*/Socket/*.cpp' \) | sort)
+
+mkdir -p "$BUILD_DIR" "$(dirname "$OUT")"
+
+# ── Compile ──────────────────────────────────────────────────
+info "Compiling ${#SOURCES[@]} sources..."
+OBJS=()
+for src in "${SOURCES[@]}"; do
+    obj="$BUILD_DIR/$(basename "${src%.cpp}").o"
+    "$CXX" -std=c++17 -fPIC $CXXFLAGS \
+        -I"$SRC_DIR" -I"$INTEG/src" -I"$INTEG/libs/socket-cpp/Socket" \
+        -c "$src" -o "$obj"
+    OBJS+=("$obj")
+done
+
+"$CXX" -shared -o "$OUT" "${OBJS[@]}" -lpthread
+ok "Library: $OUT"
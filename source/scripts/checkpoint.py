@@ -0,0 +1,63 @@
+"""
+checkpoint.py — Save a booted Linux co-sim machine for later resume.
+
+Runs inside Renode's monitor (IronPython).  Advances the emulation in
+short steps until the UART log shows the rootfs prompt, then saves the
+co-simulated model state (through its DBG_SNAPSHOT register) and the
+Renode machine snapshot next to each other.  draw_linux_resume.resc
+loads both back.
+
+Only the transaction-level model (lib/libdraw_tlm.so) implements
+DBG_SNAPSHOT; the Verilator build cannot be checkpointed.
+
+    include @scripts/checkpoint.py
+    python "checkpoint_boot('/tmp/uart_checkpoint.txt', 'Ready.')"
+
+The machine snapshot goes to $DRAW_LINUX_SNAPSHOT (default
+/tmp/draw_linux.save); the model writes $DRAW_TLM_SNAPSHOT.
+"""
+
+from System import Environment
+from System.IO import File, FileAccess, FileMode, FileShare, StreamReader
+
+CHECKPOINT_DBG_SNAPSHOT = 0x8200101C
+CHECKPOINT_SAVE = 1
+CHECKPOINT_STEP = "00:00:00.500"
+CHECKPOINT_STEP_S = 0.5
+
+
+def _uart_text(path):
+    if not File.Exists(path):
+        return ""
+    # The file backend keeps the log open for writing
+    fs = File.Open(path, FileMode.Open, FileAccess.Read, FileShare.ReadWrite)
+    try:
+        return StreamReader(fs).ReadToEnd()
+    finally:
+        fs.Close()
+
+
+def checkpoint_boot(uart_log, marker, max_seconds=900):
+    """Run until @marker appears in @uart_log, then save everything."""
+    path = Environment.GetEnvironmentVariable("DRAW_LINUX_SNAPSHOT") \
+        or "/tmp/draw_linux.save"
+    bus = monitor.Machine.SystemBus
+
+    for _ in range(int(max_seconds / CHECKPOINT_STEP_S)):
+        monitor.Parse('emulation RunFor "%s"' % CHECKPOINT_STEP)
+        if marker in _uart_text(uart_log):
+            break
+    else:
+        print("checkpoint: '%s' not seen after %ds of guest time"
+              % (marker, max_seconds))
+        return False
+
+    bus.WriteDoubleWord(CHECKPOINT_DBG_SNAPSHOT, CHECKPOINT_SAVE)
+    if bus.ReadDoubleWord(CHECKPOINT_DBG_SNAPSHOT) != 0:
+        print("checkpoint: co-sim model did not save its state "
+              "(the Verilator build has no snapshot support)")
+        return False
+
+    monitor.Parse("Save @%s" % path)
+    print("checkpoint: saved %s" % path)
+    return True
@@ -0,0 +1,162 @@
+"""
+fb_export.py — Renode-side shared-memory export of the scanout region.
+
+Runs inside Renode's monitor (IronPython).  A background thread copies
+the framebuffer out of the emulated bus straight into a memory-mapped
+file, so viewers (vnc_server.py --capture shm) can mmap it instead of
+round-tripping every frame through the telnet monitor and a temp file.
+
+Only frames that differ from the previous one are published: each row
+is hashed in-process, and a changed frame bumps the generation counter
+and records the damaged rows, so an idle screen costs the viewer
+nothing and an update costs it only the rows that moved.
+
+Load and start from the monitor:
+    include @scripts/fb_export.py
+    python "fb_export_start(self.Machine, 0x43E00000, 640, 480, '/dev/shm/renode_fb', 30)"
+
+With @base_reg set (the TLM model's DBG_FB_ADDR, 0x82001014) the
+exported address follows the device's scanout base, so a blob scanout
+flipped by SET_SCANOUT_BLOB is read straight from guest memory.  A zero
+read keeps the current address.
+
+File layout (little-endian u32 header, pixels at FB_EXPORT_DATA):
+    0  magic    'RFBX'
+    4  version  2
+    8  seq      odd while a frame is being written (seqlock)
+   12  width
+   16  height
+   20  stride   bytes per row
+   24  fb_addr  bus address of the exported region
+   32  gen      frame generation, +1 per changed frame
+   36  dmg_xy   damage vs. generation gen-1: x | y << 16
+   40  dmg_wh                                w | h << 16
+   64  pixels   ARGB8888, width * height * 4 bytes
+"""
+
+import clr
+clr.AddReference("System.Core")
+
+from System import BitConverter, Byte, Int32, Int64
+from System.IO import FileMode
+from System.IO.MemoryMappedFiles import MemoryMappedFile
+from System.Security.Cryptography import MD5
+from System.Threading import Thread, ThreadStart
+
+FB_EXPORT_MAGIC = 0x58424652    # 'RFBX'
+FB_EXPORT_VERSION = 2
+FB_EXPORT_DATA = 64
+FB_EXPORT_GEN = 32
+
+_fb_export = None
+
+
+class _FbExport(object):
+    def __init__(self, machine, addr, width, height, path, fps, base_reg=0):
+        self.machine = machine
+        self.addr = int(addr)
+        self.base_reg = int(base_reg)
+        self.width = int(width)
+        self.height = int(height)
+        self.size = self.width * self.height * 4
+        self.interval = max(1, int(1000.0 / max(1.0, float(fps))))
+        self.stride = self.width * 4
+        self.seq = 0
+        self.gen = 0
+        self.rows = None            # per-row hashes of the last frame
+        self.md5 = MD5.Create()
+        self.running = True
+
+        self.mmf = MemoryMappedFile.CreateFromFile(
+            path, FileMode.OpenOrCreate, None,
+            Int64(FB_EXPORT_DATA + self.size))
+        self.view = self.mmf.CreateViewAccessor(
+            Int64(0), Int64(FB_EXPORT_DATA + self.size))
+
+        self._put(8, 0)
+        self._put(12, self.width)
+        self._put(16, self.height)
+        self._put(20, self.stride)
+        self._put(24, self.addr)
+        self._put(FB_EXPORT_GEN, 0)
+        self._put(4, FB_EXPORT_VERSION)
+        self._put(0, FB_EXPORT_MAGIC)   # last: header is now valid
+
+        self.thread = Thread(ThreadStart(self._run))
+        self.thread.IsBackground = True
+        self.thread.Start()
+
+    def _put(self, off, val):
+        # Int32 overload; values above 2^31 (addresses) wrap to the same bits
+        if val >= 0x80000000:
+            val -= 0x100000000
+        self.view.Write(Int64(off), Int32(val))
+
+    def _damage(self, data):
+        """Rows [y0, y1) that differ from the previous frame, or None."""
+        rows = [BitConverter.ToString(
+                    self.md5.ComputeHash(data, y * self.stride, self.stride))
+                for y in range(self.height)]
+        old, self.rows = self.rows, rows
+        if old is None:
+            return 0, self.height
+        changed = [y for y in range(self.height) if rows[y] != old[y]]
+        if not changed:
+            return None
+        return changed[0], changed[-1] + 1
+
+    def _follow_base(self):
+        """Pick up a moved scanout base; the next frame is then fully damaged."""
+        base = self.machine.SystemBus.ReadDoubleWord(Int64(self.base_reg))
+        if base and base != self.addr:
+            self.addr = base
+            self.rows = None
+            self._put(24, self.addr)
+
+    def _run(self):
+        while self.running:
+            try:
+                if self.base_reg:
+                    self._follow_base()
+                data = self.machine.SystemBus.ReadBytes(
+                    Int64(self.addr), Int32(self.size))
+                damage = self._damage(data)
+                if damage is not None:
+                    y0, y1 = damage
+                    self.gen = (self.gen + 1) & 0x7FFFFFFF
+                    self.seq = (self.seq + 1) & 0x7FFFFFFF
+                    self._put(8, self.seq)                  # odd: writing
+                    self.view.WriteArray[Byte](
+                        Int64(FB_EXPORT_DATA + y0 * self.stride), data,
+                        y0 * self.stride, (y1 - y0) * self.stride)
+                    self._put(FB_EXPORT_GEN + 4, y0 << 16)
+                    self._put(FB_EXPORT_GEN + 8,
+                              self.width | ((y1 - y0) << 16))
+                    self._put(FB_EXPORT_GEN, self.gen)
+                    self.seq = (self.seq + 1) & 0x7FFFFFFF
+                    self._put(8, self.seq)                  # even: stable
+            except Exception:
+                pass
+            Thread.Sleep(self.interval)
+
+    def stop(self):
+        self.running = False
+        self.thread.Join(1000)
+        self.view.Dispose()
+        self.mmf.Dispose()
+
+
+def fb_export_start(machine, addr, width, height, path, fps=30, base_reg=0):
+    """(Re)start exporting @width x @height ARGB8888 at @addr into @path."""
+    global _fb_export
+    fb_export_stop()
+    _fb_export = _FbExport(machine, addr, width, height, path, fps, base_reg)
+    print("fb_export: 0x%08X %dx%d -> %s" % (int(addr), int(width),
+                                              int(height), path))
+
+
+def fb_export_stop():
+    global _fb_export
+    if _fb_export is not None:
+        _fb_export.stop()
+        _fb_export = None
@@ -6,17 +6,26 @@ Produces:
   <output>.bin   — raw pixel data (ARGB8888, little-endian)
   <output>.hdr   — 8-byte header: uint32 width, uint32 height
 
+  or, with --batch:
+  <output>.ring  — every frame of a directory / animation / video as
+                   fixed-size header+pixel slots (see RING_* below)
+
 Usage:
   python3 img2raw.py input.png output [--max-width W] [--max-height H]
+  python3 img2raw.py frames/ output --batch [--sepia]
 
 The header file is loaded into RAM so the firmware can read the image
-dimensions at runtime without hardcoding.
+dimensions at runtime without hardcoding.  Ring files are consumed by
+scripts/imgproc_batch.py in one Renode session.
 """
 
 import argparse
+import shutil
 import struct
+import subprocess
 import sys
 import os
+import tempfile
 
 try:
     from PIL import Image
@@ -28,6 +37,17 @@ except ImportError:
 FB_WIDTH  = 640
 FB_HEIGHT = 480
 
+# Ring file: 16-byte file header, then <count> slots of <slot_size> bytes.
+#   file header: "IMGR", u32 count, u32 slot_size, u32 reserved
+#   slot:        u32 width, u32 height, u32 index, u32 reserved,
+#                ARGB8888 pixels (zero-padded to slot_size)
+RING_MAGIC    = b"IMGR"
+RING_HDR_SIZE = 16
+SLOT_HDR_SIZE = 16
+SLOT_ALIGN    = 4096
+IMAGE_EXTS    = (".png", ".jpg", ".jpeg", ".bmp", ".gif", ".tif", ".tiff",
+                 ".webp", ".ppm")
+
 
 def _to_argb(pixels: 'np.ndarray') -> 'np.ndarray':
     """Convert (h,w,4) RGBA uint8 array to (h,w) ARGB8888 uint32 array."""
@@ -51,6 +71,15 @@ def _apply_sepia(pixels: 'np.ndarray') -> None:
     pixels[:, :, 2] = np.clip(gray, 0, 255).astype(np.uint8)
 
 
+def _fit(img: 'Image.Image', max_w: int, max_h: int) -> 'Image.Image':
+    """Downscale to fit max_w×max_h, keeping the aspect ratio."""
+    w, h = img.size
+    if w > max_w or h > max_h:
+        ratio = min(max_w / w, max_h / h)
+        img = img.resize((int(w * ratio), int(h * ratio)), Image.LANCZOS)
+    return img
+
+
 def convert(input_path: str, output_base: str,
             max_w: int = 640, max_h: int = 480,
             sepia: bool = False,
@@ -58,14 +87,10 @@ def convert(input_path: str, output_base: str,
     import numpy as np
 
     img = Image.open(input_path).convert("RGBA")
+    size = img.size
+    img = _fit(img, max_w, max_h)
     w, h = img.size
-
-    # Resize if necessary (keep aspect ratio)
-    if w > max_w or h > max_h:
-        ratio = min(max_w / w, max_h / h)
-        w = int(w * ratio)
-        h = int(h * ratio)
-        img = img.resize((w, h), Image.LANCZOS)
+    if img.size != size:
         print(f"Resized to {w}×{h}")
 
     pixels = np.array(img, dtype=np.uint8)  # shape (h, w, 4) — R, G, B, A
@@ -143,10 +168,72 @@ def _compose_framebuffer(pixels: 'np.ndarray', w: int, h: int,
     print(f"FB     : {fb_path}  ({size} bytes, {size/1024:.1f} KiB)")
 
 
+def _iter_frames(input_path: str):
+    """Yield RGBA frames from a directory, a multi-frame image or a video."""
+    if os.path.isdir(input_path):
+        for name in sorted(os.listdir(input_path)):
+            if name.lower().endswith(IMAGE_EXTS):
+                with Image.open(os.path.join(input_path, name)) as img:
+                    yield img.convert("RGBA")
+        return
+
+    try:
+        img = Image.open(input_path)
+    except OSError:
+        img = None
+    if img is not None:
+        with img:
+            for i in range(getattr(img, "n_frames", 1)):
+                img.seek(i)
+                yield img.convert("RGBA")
+        return
+
+    # Not an image: let ffmpeg split the video into PNG frames
+    if not shutil.which("ffmpeg"):
+        raise SystemExit(f"ERROR: {input_path}: not an image and ffmpeg not found")
+    with tempfile.TemporaryDirectory() as tmp:
+        subprocess.run(["ffmpeg", "-loglevel", "error", "-i", input_path,
+                        os.path.join(tmp, "frame_%05d.png")], check=True)
+        yield from _iter_frames(tmp)
+
+
+def convert_batch(input_path: str, output_base: str,
+                  max_w: int = 640, max_h: int = 480,
+                  sepia: bool = False) -> int:
+    """Write every frame of @input_path into <output_base>.ring."""
+    import numpy as np
+
+    slot_size = SLOT_HDR_SIZE + max_w * max_h * 4
+    slot_size = (slot_size + SLOT_ALIGN - 1) // SLOT_ALIGN * SLOT_ALIGN
+    ring_path = output_base + ".ring"
+    count = 0
+
+    with open(ring_path, "wb") as f:
+        f.write(struct.pack("<4sIII", RING_MAGIC, 0, slot_size, 0))
+        for img in _iter_frames(input_path):
+            img = _fit(img, max_w, max_h)
+            w, h = img.size
+            pixels = np.array(img, dtype=np.uint8)
+            if sepia:
+                _apply_sepia(pixels)
+            data = _to_argb(pixels).tobytes()
+            f.write(struct.pack("<IIII", w, h, count, 0))
+            f.write(data)
+            f.write(b"\0" * (slot_size - SLOT_HDR_SIZE - len(data)))
+            count += 1
+        f.seek(0)
+        f.write(struct.pack("<4sIII", RING_MAGIC, count, slot_size, 0))
+
+    size = RING_HDR_SIZE + count * slot_size
+    print(f"Ring   : {ring_path}  ({count} frames, {size/1048576:.1f} MiB)")
+    return count
+
+
 def main():
     parser = argparse.ArgumentParser(
         description="Convert image to raw ARGB8888 binary for Renode")
-    parser.add_argument("input", help="Input image file (PNG/JPG/BMP/…)")
+    parser.add_argument("input", help="Input image file (PNG/JPG/BMP/…), "
+                        "or with --batch a directory, animation or video")
     parser.add_argument("output", help="Output base name (without extension)")
     parser.add_argument("--max-width", type=int, default=640,
                         help="Max width (default: 640)")
@@ -156,12 +243,22 @@ def main():
                         help="Apply sepia tone filter")
     parser.add_argument("--compose-fb", action="store_true",
                         help="Also output a pre-composited 640×480 framebuffer")
+    parser.add_argument("--batch", action="store_true",
+                        help="Write all frames to <output>.ring")
     args = parser.parse_args()
 
-    if not os.path.isfile(args.input):
+    if not os.path.exists(args.input):
         print(f"ERROR: {args.input} not found", file=sys.stderr)
         sys.exit(1)
 
+    if args.batch:
+        if convert_batch(args.input, args.output, args.max_width,
+                         args.max_height, sepia=args.sepia) == 0:
+            print(f"ERROR: no frames in {args.input}", file=sys.stderr)
+            sys.exit(1)
+        print("Done.")
+        return
+
     convert(args.input, args.output, args.max_width, args.max_height,
             sepia=args.sepia, compose_fb=args.compose_fb)
     print("Done.")
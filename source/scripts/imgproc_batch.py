@@ -0,0 +1,201 @@
+"""
+imgproc_batch.py — Run the imgproc demo over many frames in one session.
+
+Runs inside Renode's monitor (IronPython).  Reads a ring file written by
+img2raw.py --batch, stages RING_SLOTS frames at a time into a ring of
+header+pixel slots in RAM, and has the Draw Engine compose each one into
+the framebuffer through the legacy register window: background fill,
+centred BitBlt of the slot, blended corner vignette and the two-tone
+border (the same picture img2raw.py --compose-fb draws on the host).
+Each frame is dumped as soon as the engine reports idle.
+
+    include @scripts/imgproc_batch.py
+    python "imgproc_batch()"
+
+The ring comes from $IMGPROC_RING (default /tmp/draw_imgproc/frames.ring);
+frames go to $IMGPROC_OUT (default /tmp/draw_imgproc/out) as
+frame_NNNNN.raw (640×480 ARGB8888), followed by a "done" marker.
+"""
+
+from Antmicro.Renode.Peripherals.Bus import SystemBusExtensions
+from System import Array, Byte, Environment
+from System.IO import Directory, File, FileMode, Path
+
+import struct
+
+# Ring file / slot layout (img2raw.py RING_*)
+RING_MAGIC = "IMGR"
+RING_HDR_SIZE = 16
+SLOT_HDR_SIZE = 16
+
+RING_BASE = 0x41000000      # past the framebuffer; 8 VGA slots need ~9.4 MiB
+RING_SLOTS = 8
+
+FB_ADDR = 0x40C00000
+FB_WIDTH = 640
+FB_HEIGHT = 480
+
+# Legacy Draw Engine window (draw_dl.h)
+DRAW_REG = 0x82002000
+DRAW_REG_CTRL = DRAW_REG + 0x00
+DRAW_REG_STAT = DRAW_REG + 0x04
+DRAW_REG_BUFSTAT = DRAW_REG + 0x08
+DRAW_REG_CMD = DRAW_REG + 0x0C
+DRAW_CTRL_EXE = 1
+DRAW_STAT_BUSY = 1
+DRAW_BUF_FULL = 1 << 17
+
+OP_EODL = 0x0F
+OP_SETFRAME = 0x20
+OP_SETDRAWAREA = 0x21
+OP_SETTEXTURE = 0x22
+OP_SETFCOLOR = 0x23
+OP_SETBLENDALPHA = 0x31
+OP_SETBLENDOFF = 0x32
+OP_PATBLT = 0x81
+OP_BITBLT = 0x82
+
+BG_COLOR = 0xFF1A1A2E
+BORDER_COLOR = 0xFFC8A87E
+ACCENT_COLOR = 0xFF806030
+BORDER_W = 3
+VIGNETTE = 24
+VIGNETTE_ALPHA = 158        # black over dst at 158/255 leaves dst * 0.38
+
+WAIT_STEP = "00:00:00.001"
+WAIT_STEPS = 2000
+
+
+def _cmd(op, arg=0):
+    return (op << 24) | (arg & 0xFFFFFF)
+
+
+def _xy(x, y):
+    return ((x & 0xFFFF) << 16) | (y & 0xFFFF)
+
+
+def _rect(x, y, w, h):
+    return [_cmd(OP_PATBLT), _xy(x, y), _xy(w, h)]
+
+
+def _compose_list(tex, w, h):
+    """Display list: frame @FB_ADDR ← slot pixels @tex (w×h)."""
+    dx = (FB_WIDTH - w) // 2 if w < FB_WIDTH else 0
+    dy = (FB_HEIGHT - h) // 2 if h < FB_HEIGHT else 0
+    bw, bh = min(w, FB_WIDTH), min(h, FB_HEIGHT)
+    b = BORDER_W
+
+    dl = [_cmd(OP_SETFRAME), FB_ADDR, _xy(FB_WIDTH, FB_HEIGHT),
+          _cmd(OP_SETDRAWAREA), _xy(0, 0), _xy(FB_WIDTH, FB_HEIGHT),
+          _cmd(OP_SETBLENDOFF),
+          _cmd(OP_SETFCOLOR), BG_COLOR]
+    dl += _rect(0, 0, FB_WIDTH, FB_HEIGHT)
+
+    dl += [_cmd(OP_SETTEXTURE), tex, _xy(w, h),
+           _cmd(OP_BITBLT), _xy(dx, dy), _xy(bw, bh), _xy(0, 0)]
+
+    dl += [_cmd(OP_SETFCOLOR), 0xFF000000,
+           _cmd(OP_SETBLENDALPHA, VIGNETTE_ALPHA)]
+    for cx, cy in ((dx, dy), (dx + bw - VIGNETTE, dy),
+                   (dx, dy + bh - VIGNETTE), (dx + bw - VIGNETTE, dy + bh - VIGNETTE)):
+        dl += _rect(cx, cy, VIGNETTE, VIGNETTE)
+    dl.append(_cmd(OP_SETBLENDOFF))
+
+    dl += [_cmd(OP_SETFCOLOR), BORDER_COLOR]
+    dl += _rect(0, 0, FB_WIDTH, b) + _rect(0, FB_HEIGHT - b, FB_WIDTH, b)
+    dl += _rect(0, b, b, FB_HEIGHT - 2 * b) + _rect(FB_WIDTH - b, b, b, FB_HEIGHT - 2 * b)
+
+    dl += [_cmd(OP_SETFCOLOR), ACCENT_COLOR]
+    dl += _rect(b, b, FB_WIDTH - 2 * b, 1) + _rect(b, FB_HEIGHT - b - 1, FB_WIDTH - 2 * b, 1)
+    dl += _rect(b, b + 1, 1, FB_HEIGHT - 2 * b - 2)
+    dl += _rect(FB_WIDTH - b - 1, b + 1, 1, FB_HEIGHT - 2 * b - 2)
+
+    dl.append(_cmd(OP_EODL))
+    return dl
+
+
+def _wait(bus, reg, mask):
+    """Run the emulation until @reg & @mask reads 0; False on timeout."""
+    for _ in range(WAIT_STEPS):
+        if not bus.ReadDoubleWord(reg) & mask:
+            return True
+        monitor.Parse('emulation RunFor "%s"' % WAIT_STEP)
+    return not bus.ReadDoubleWord(reg) & mask
+
+
+def _draw_submit(bus, dl):
+    # Same feed as draw_dev_submit(): a list longer than the command FIFO
+    # is started once the FIFO fills, then topped up as the engine drains it.
+    started = False
+    for word in dl:
+        if bus.ReadDoubleWord(DRAW_REG_BUFSTAT) & DRAW_BUF_FULL:
+            if not started:
+                bus.WriteDoubleWord(DRAW_REG_CTRL, DRAW_CTRL_EXE)
+                started = True
+            if not _wait(bus, DRAW_REG_BUFSTAT, DRAW_BUF_FULL):
+                return False
+        bus.WriteDoubleWord(DRAW_REG_CMD, word)
+    if not started:
+        bus.WriteDoubleWord(DRAW_REG_CTRL, DRAW_CTRL_EXE)
+    for _ in range(WAIT_STEPS):
+        monitor.Parse('emulation RunFor "%s"' % WAIT_STEP)
+        if not bus.ReadDoubleWord(DRAW_REG_STAT) & DRAW_STAT_BUSY:
+            return True
+    return False
+
+
+def _read(stream, n):
+    buf = Array.CreateInstance(Byte, n)
+    got = 0
+    while got < n:
+        r = stream.Read(buf, got, n - got)
+        if r == 0:
+            raise IOError("ring file truncated")
+        got += r
+    return buf
+
+
+def imgproc_batch(ring_path=None, out_dir=None, slots=RING_SLOTS):
+    """Compose every frame of @ring_path and dump it into @out_dir."""
+    ring_path = ring_path or Environment.GetEnvironmentVariable("IMGPROC_RING") \
+        or "/tmp/draw_imgproc/frames.ring"
+    out_dir = out_dir or Environment.GetEnvironmentVariable("IMGPROC_OUT") \
+        or "/tmp/draw_imgproc/out"
+    bus = monitor.Machine.SystemBus
+    Directory.CreateDirectory(out_dir)
+
+    ring = File.Open(ring_path, FileMode.Open)
+    try:
+        magic, count, slot_size, _ = struct.unpack(
+            "<4sIII", bytes(bytearray(_read(ring, RING_HDR_SIZE))))
+        if magic != RING_MAGIC or count == 0:
+            print("imgproc_batch: %s is not a frame ring" % ring_path)
+            return False
+        print("imgproc_batch: %d frames, %d slots of %d KiB"
+              % (count, slots, slot_size // 1024))
+
+        done = 0
+        while done < count:
+            # Stage the next batch into the RAM ring, then run it back to back
+            batch = min(slots, count - done)
+            for s in range(batch):
+                bus.WriteBytes(_read(ring, slot_size), long(RING_BASE + s * slot_size))
+
+            for s in range(batch):
+                slot = RING_BASE + s * slot_size
+                w = bus.ReadDoubleWord(slot)
+                h = bus.ReadDoubleWord(slot + 4)
+                index = bus.ReadDoubleWord(slot + 8)
+                if not _draw_submit(bus, _compose_list(slot + SLOT_HDR_SIZE, w, h)):
+                    print("imgproc_batch: frame %d: Draw Engine timeout" % index)
+                    return False
+                data = SystemBusExtensions.ReadBytes(bus, long(FB_ADDR),
+                                                     int(FB_WIDTH * FB_HEIGHT * 4))
+                File.WriteAllBytes(Path.Combine(out_dir, "frame_%05d.raw" % index), data)
+                print("imgproc_batch: frame %d/%d (%dx%d)" % (index + 1, count, w, h))
+            done += batch
+    finally:
+        ring.Close()
+
+    File.WriteAllBytes(Path.Combine(out_dir, "done"), bytearray(b"OK"))
+    return True
@@ -7,9 +7,17 @@ memory region, and serves it via:
   1. RFB/VNC protocol on port 5900 (native VNC clients)
   2. HTTP on port 5800 (browser-based viewer — works everywhere)
 
+Capture backends (--capture):
+  shm     fb_export.py runs inside Renode and copies the scanout region
+          into a memory-mapped file; frames are read straight from the
+          mapping and the monitor is only used for control
+  telnet  one SystemBus.ReadBytes round trip + temp file per frame (slow)
+  auto    shm, falling back to telnet if the export cannot be set up
+
 Usage:
     python3 vnc_server.py [--port 5900] [--web-port 5800]
                           [--renode-port 1234] [--fps 2]
+                          [--capture auto|shm|telnet] [--shm-path PATH]
 
 Connect from Mac:
     open http://<host>:5800             # Browser (recommended)
@@ -17,9 +25,14 @@ Connect from Mac:
 """
 
 import argparse
+import base64
+import collections
 import hashlib
 import http.server
+import io
+import itertools
 import logging
+import mmap
 import os
 import re
 import signal
@@ -30,6 +43,12 @@ import sys
 import telnetlib
 import threading
 import time
+import zlib
+
+try:
+    from PIL import Image       # optional: Tight JPEG for photo content
+except ImportError:
+    Image = None
 
 logging.basicConfig(
     level=logging.INFO,
@@ -48,6 +67,39 @@ MSG_POINTER_EVENT = 5
 MSG_CLIENT_CUT_TEXT = 6
 MSG_FB_UPDATE = 0
 ENC_RAW = 0
+ENC_COPYRECT = 1
+ENC_HEXTILE = 5
+ENC_TIGHT = 7
+ENC_ZRLE = 16
+ENC_QUALITY_LEVEL_0 = -32       # Tight JPEG quality pseudo-encodings
+ENC_COMPRESS_LEVEL_0 = -256     # zlib level pseudo-encodings
+ENC_SUPPORTED = (ENC_TIGHT, ENC_ZRLE, ENC_HEXTILE, ENC_RAW)
+
+HEX_RAW = 1
+HEX_BG = 2
+HEX_FG = 4
+HEX_ANY_SUBRECTS = 8
+HEX_COLOURED = 16
+TIGHT_FILTER_PALETTE = 1
+
+# ─── Shared-memory export (see fb_export.py) ──────────────────────────
+FB_EXPORT_SCRIPT = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                "fb_export.py")
+FB_EXPORT_MAGIC = 0x58424652    # 'RFBX'
+FB_EXPORT_DATA = 64
+FB_EXPORT_GEN = 32               # gen, damage x|y<<16, damage w|h<<16
+DEBUG_INTERVAL = 2.5            # seconds between debug register dumps
+DEBUG_REGS = [
+    (0x82001000, "state"), (0x82001004, "last_cmd"),
+    (0x82001010, "cmd_cnt"), (0x8200100C, "backing1"),
+    (0x82001014, "fb_addr"), (0x82001018, "wxh"),
+    # DRAWPERF counters (TLM model only; zero on the RTL build)
+    (0x82002104, "cmds"), (0x8200210C, "fifo_full"),
+    (0x82002110, "fifo_empty"), (0x82002114, "rd_beats"),
+    (0x82002118, "wr_beats"), (0x8200212C, "blend_px"),
+    (0x8200213C, "vq_bufs"), (0x82002140, "vq_irqs"),
+    (0x82002148, "cycles"),
+]
 
 
 def _recv_exact(sock: socket.socket, n: int) -> bytes:
@@ -61,27 +113,388 @@ def _recv_exact(sock: socket.socket, n: int) -> bytes:
     return bytes(buf)
 
 
+# ─── RFB Encoders ─────────────────────────────────────────────────────
+#
+# Pixels go out in the server pixel format (32bpp, depth 24, little-endian,
+# shifts 16/8/0) — the framebuffer's own B,G,R,X bytes.  ZRLE's CPIXEL is
+# the low three of those (B,G,R); Tight's TPIXEL is R,G,B.
+
+TILE = 64           # dirty-tracking granularity (and ZRLE's tile size)
+HEXTILE = 16
+SCROLL_MIN_ROWS = 32
+
+
+def _rect_bytes(fb, stride: int, x: int, y: int, w: int, h: int) -> bytes:
+    """Pack a rectangle of the framebuffer into contiguous rows."""
+    if x == 0 and w * 4 == stride:
+        return bytes(fb[y * stride:(y + h) * stride])
+    a = y * stride + x * 4
+    return b"".join(fb[a + r * stride:a + r * stride + w * 4]
+                    for r in range(h))
+
+
+def _pixels(d: bytes) -> list:
+    """32-bit pixel values (0xXXRRGGBB) of packed BGRX bytes."""
+    return memoryview(d).cast("I").tolist()
+
+
+def _bgrx_to_cpixel(d: bytes) -> bytearray:
+    out = bytearray(len(d) // 4 * 3)
+    out[0::3], out[1::3], out[2::3] = d[0::4], d[1::4], d[2::4]
+    return out
+
+
+def _bgrx_to_rgb(d: bytes) -> bytearray:
+    out = bytearray(len(d) // 4 * 3)
+    out[0::3], out[1::3], out[2::3] = d[2::4], d[1::4], d[0::4]
+    return out
+
+
+def _cpixel(p: int) -> bytes:
+    return (p & 0xFFFFFF).to_bytes(3, "little")
+
+
+def _tpixel(p: int) -> bytes:
+    return bytes(((p >> 16) & 0xFF, (p >> 8) & 0xFF, p & 0xFF))
+
+
+def _run_length(n: int) -> bytes:
+    """ZRLE run length: (n - 1) as 255s plus a final byte < 255."""
+    n -= 1
+    return b"\xff" * (n // 255) + bytes((n % 255,))
+
+
+def _compact_length(n: int) -> bytes:
+    """Tight 1–3 byte length prefix."""
+    out = bytearray((n & 0x7F,))
+    if n > 0x7F:
+        out[0] |= 0x80
+        out.append((n >> 7) & 0x7F)
+        if n > 0x3FFF:
+            out[1] |= 0x80
+            out.append((n >> 14) & 0xFF)
+    return bytes(out)
+
+
+def _pack_indices(px: list, index: dict, w: int, h: int, bits: int) -> bytearray:
+    """Palette indices, MSB first, each row padded to a byte."""
+    out = bytearray()
+    per = 8 // bits
+    for r in range(h):
+        row = px[r * w:(r + 1) * w]
+        for i in range(0, w, per):
+            b = 0
+            for j, c in enumerate(row[i:i + per]):
+                b |= index[c] << (8 - bits * (j + 1))
+            out.append(b)
+    return out
+
+
+def dirty_tiles(old, new, width: int, height: int, stride: int) -> list:
+    """(x, y, w, h) of every TILE x TILE block where @new differs from @old."""
+    tiles = []
+    for ty in range(0, height, TILE):
+        th = min(TILE, height - ty)
+        a, b = ty * stride, (ty + th) * stride
+        if old[a:b] == new[a:b]:
+            continue
+        for tx in range(0, width, TILE):
+            tw = min(TILE, width - tx)
+            for r in range(th):
+                o = a + r * stride + tx * 4
+                if old[o:o + tw * 4] != new[o:o + tw * 4]:
+                    tiles.append((tx, ty, tw, th))
+                    break
+    return tiles
+
+
+def find_scroll(old, new, height: int, stride: int):
+    """Detect a vertical scroll of @old into @new.
+
+    Returns (y0, y1, dy): rows [y0, y1) of @new equal rows [y0+dy, y1+dy)
+    of @old, or None.  Only rows unique within @old vote, so flat
+    backgrounds cannot fake a match.
+    """
+    seen = {}
+    for y in range(height):
+        row = bytes(old[y * stride:(y + 1) * stride])
+        seen[row] = -1 if row in seen else y
+    votes = {}
+    for y in range(0, height, 4):
+        oy = seen.get(bytes(new[y * stride:(y + 1) * stride]), -1)
+        if oy >= 0 and oy != y:
+            votes[oy - y] = votes.get(oy - y, 0) + 1
+    if not votes:
+        return None
+    dy = max(votes, key=votes.get)
+    if votes[dy] < 4:
+        return None
+
+    best, y0 = None, None
+    for y in range(max(0, -dy), min(height, height - dy) + 1):
+        same = (y < min(height, height - dy) and
+                new[y * stride:(y + 1) * stride] ==
+                old[(y + dy) * stride:(y + dy + 1) * stride])
+        if same and y0 is None:
+            y0 = y
+        elif not same and y0 is not None:
+            if best is None or y - y0 > best[1] - best[0]:
+                best = (y0, y)
+            y0 = None
+    if best is None or best[1] - best[0] < SCROLL_MIN_ROWS:
+        return None
+    return best[0], best[1], dy
+
+
+class RFBEncoder:
+    """Per-connection encoder state: the client's encodings and zlib streams."""
+
+    def __init__(self, width: int, height: int):
+        self.width = width
+        self.height = height
+        self.stride = width * 4
+        self.set_encodings([ENC_RAW])
+        self._zrle = None
+        self._tight = [None] * 4
+
+    def set_encodings(self, encodings: list):
+        self.encodings = encodings
+        self.copyrect = ENC_COPYRECT in encodings
+        self.encoding = next((e for e in encodings if e in ENC_SUPPORTED),
+                             ENC_RAW)
+        self.zlib_level = 6
+        self.jpeg_quality = None
+        for e in encodings:
+            if ENC_COMPRESS_LEVEL_0 <= e <= ENC_COMPRESS_LEVEL_0 + 9:
+                self.zlib_level = e - ENC_COMPRESS_LEVEL_0
+            elif ENC_QUALITY_LEVEL_0 <= e <= ENC_QUALITY_LEVEL_0 + 9:
+                self.jpeg_quality = 10 + 9 * (e - ENC_QUALITY_LEVEL_0)
+        if Image is None:
+            self.jpeg_quality = None
+
+    def _zlib(self, stream):
+        return stream or zlib.compressobj(self.zlib_level)
+
+    # ── Update message ───────────────────────────────────────────
+
+    def update(self, fb, model, full: bool):
+        """FramebufferUpdate turning @model (what the client shows) into @fb.
+
+        Returns None when nothing differs.
+        """
+        rects = []
+        if full or model is None:
+            tiles = [(x, y, min(TILE, self.width - x), min(TILE, self.height - y))
+                     for y in range(0, self.height, TILE)
+                     for x in range(0, self.width, TILE)]
+        else:
+            tiles = dirty_tiles(model, fb, self.width, self.height, self.stride)
+            if self.copyrect and len(tiles) * TILE >= 2 * self.width:
+                scroll = find_scroll(model, fb, self.height, self.stride)
+                if scroll:
+                    y0, y1, dy = scroll
+                    rects.append(struct.pack("!HHHHiHH", 0, y0, self.width,
+                                             y1 - y0, ENC_COPYRECT, 0, y0 + dy))
+                    moved = bytearray(model)
+                    moved[y0 * self.stride:y1 * self.stride] = \
+                        model[(y0 + dy) * self.stride:(y1 + dy) * self.stride]
+                    tiles = dirty_tiles(moved, fb, self.width, self.height,
+                                        self.stride)
+        if not tiles and not rects:
+            return None
+
+        for x, y, w, h in tiles:
+            rects.append(self.encode(fb, x, y, w, h))
+        return struct.pack("!BxH", MSG_FB_UPDATE, len(rects)) + b"".join(rects)
+
+    def encode(self, fb, x: int, y: int, w: int, h: int) -> bytes:
+        """One rectangle (header + payload) in the negotiated encoding."""
+        enc = self.encoding
+        if enc == ENC_ZRLE:
+            body = self._enc_zrle(fb, x, y, w, h)
+        elif enc == ENC_TIGHT:
+            body = self._enc_tight(_rect_bytes(fb, self.stride, x, y, w, h), w, h)
+        elif enc == ENC_HEXTILE:
+            body = self._enc_hextile(fb, x, y, w, h)
+        else:
+            enc, body = ENC_RAW, _rect_bytes(fb, self.stride, x, y, w, h)
+        return struct.pack("!HHHHi", x, y, w, h, enc) + body
+
+    # ── Hextile (5) ──────────────────────────────────────────────
+
+    def _enc_hextile(self, fb, x, y, w, h) -> bytes:
+        out = bytearray()
+        bg = fg = None
+        for sy in range(y, y + h, HEXTILE):
+            for sx in range(x, x + w, HEXTILE):
+                sw, sh = min(HEXTILE, x + w - sx), min(HEXTILE, y + h - sy)
+                d = _rect_bytes(fb, self.stride, sx, sy, sw, sh)
+                px = _pixels(d)
+                count = collections.Counter(px)
+                if len(count) == 1:
+                    if px[0] == bg:
+                        out.append(0)
+                    else:
+                        bg = px[0]
+                        out.append(HEX_BG)
+                        out += struct.pack("<I", bg)
+                    continue
+
+                tile_bg = count.most_common(1)[0][0]
+                subs = []
+                for r in range(sh):
+                    i = 0
+                    for c, g in itertools.groupby(px[r * sw:(r + 1) * sw]):
+                        n = sum(1 for _ in g)
+                        if c != tile_bg:
+                            subs.append((c, i, r, n))
+                        i += n
+                mono = len(count) == 2
+                size = 6 + (4 if mono else 0) + len(subs) * (2 if mono else 6)
+                if len(subs) > 255 or size >= len(d):
+                    out.append(HEX_RAW)
+                    out += d
+                    bg = fg = None
+                    continue
+
+                mask = HEX_ANY_SUBRECTS
+                if tile_bg != bg:
+                    mask |= HEX_BG
+                if not mono:
+                    mask |= HEX_COLOURED
+                elif subs[0][0] != fg:
+                    mask |= HEX_FG
+                out.append(mask)
+                if mask & HEX_BG:
+                    bg = tile_bg
+                    out += struct.pack("<I", bg)
+                if mask & HEX_FG:
+                    fg = subs[0][0]
+                    out += struct.pack("<I", fg)
+                if not mono:
+                    fg = None
+                out.append(len(subs))
+                for c, sx_, sy_, n in subs:
+                    if not mono:
+                        out += struct.pack("<I", c)
+                    out.append((sx_ << 4) | sy_)
+                    out.append((n - 1) << 4)
+        return bytes(out)
+
+    # ── ZRLE (16) ────────────────────────────────────────────────
+
+    def _enc_zrle(self, fb, x, y, w, h) -> bytes:
+        raw = bytearray()
+        for ty in range(y, y + h, TILE):
+            for tx in range(x, x + w, TILE):
+                tw, th = min(TILE, x + w - tx), min(TILE, y + h - ty)
+                raw += self._zrle_tile(
+                    _rect_bytes(fb, self.stride, tx, ty, tw, th), tw, th)
+        self._zrle = self._zlib(self._zrle)
+        z = self._zrle.compress(bytes(raw)) + self._zrle.flush(zlib.Z_SYNC_FLUSH)
+        return struct.pack("!I", len(z)) + z
+
+    @staticmethod
+    def _zrle_tile(d: bytes, w: int, h: int) -> bytes:
+        px = _pixels(d)
+        palette = list(dict.fromkeys(px))
+        n = len(palette)
+        if n == 1:
+            return b"\x01" + _cpixel(px[0])
+        index = {c: i for i, c in enumerate(palette)} if n <= 127 else None
+        if n <= 16:
+            bits = 1 if n == 2 else 2 if n <= 4 else 4
+            return (bytes((n,)) + b"".join(_cpixel(c) for c in palette) +
+                    _pack_indices(px, index, w, h, bits))
+
+        runs = [(c, sum(1 for _ in g)) for c, g in itertools.groupby(px)]
+        if index is not None and len(runs) * 2 < len(px):
+            out = bytearray((128 + n,))
+            out += b"".join(_cpixel(c) for c in palette)
+            for c, k in runs:
+                if k == 1:
+                    out.append(index[c])
+                else:
+                    out.append(index[c] | 128)
+                    out += _run_length(k)
+            return bytes(out)
+        if len(runs) * 4 < len(px):
+            return b"\x80" + b"".join(_cpixel(c) + _run_length(k)
+                                      for c, k in runs)
+        return b"\x00" + _bgrx_to_cpixel(d)
+
+    # ── Tight (7) ────────────────────────────────────────────────
+
+    def _tight_data(self, stream: int, data: bytes) -> bytes:
+        if len(data) < 12:
+            return data
+        self._tight[stream] = self._zlib(self._tight[stream])
+        z = self._tight[stream]
+        z = z.compress(data) + z.flush(zlib.Z_SYNC_FLUSH)
+        return _compact_length(len(z)) + z
+
+    def _enc_tight(self, d: bytes, w: int, h: int) -> bytes:
+        px = _pixels(d)
+        palette = list(dict.fromkeys(px))
+        n = len(palette)
+        if n == 1:
+            return b"\x80" + _tpixel(px[0])                 # fill
+        if n <= 256 and n * 3 < len(px):
+            index = {c: i for i, c in enumerate(palette)}
+            if n == 2:
+                data = _pack_indices(px, index, w, h, 1)
+            else:
+                data = bytes(index[c] for c in px)
+            return (bytes((0x40 | (1 << 4), TIGHT_FILTER_PALETTE, n - 1)) +
+                    b"".join(_tpixel(c) for c in palette) +
+                    self._tight_data(1, bytes(data)))
+        rgb = _bgrx_to_rgb(d)
+        if self.jpeg_quality is not None:
+            buf = io.BytesIO()
+            Image.frombuffer("RGB", (w, h), bytes(rgb), "raw", "RGB", 0, 1) \
+                .save(buf, "JPEG", quality=self.jpeg_quality)
+            jpeg = buf.getvalue()
+            return b"\x90" + _compact_length(len(jpeg)) + jpeg
+        return b"\x00" + self._tight_data(0, bytes(rgb))     # copy filter
+
+
 # ─── Renode Framebuffer Reader ────────────────────────────────────────
 
 class RenodeFramebufferReader:
-    """Reads framebuffer data from Renode via telnet monitor."""
+    """Reads framebuffer data from Renode (shared-memory export or telnet)."""
 
     def __init__(self, renode_host: str, renode_port: int,
                  fb_addr: int, width: int, height: int,
-                 uart_log_path: str = "/tmp/uart_output_interactive.txt"):
+                 uart_log_path: str = "/tmp/uart_output_interactive.txt",
+                 capture: str = "auto",
+                 shm_path: str = "/dev/shm/renode_fb",
+                 export_fps: float = 30.0,
+                 scanout_reg: int = 0):
         self.host = renode_host
         self.port = renode_port
         self.fb_addr = fb_addr
+        self.scanout_reg = scanout_reg    # follow the device's scanout base
         self.width = width
         self.height = height
         self.fb_size = width * height * 4  # ARGB8888
         self.uart_log_path = uart_log_path
+        self.capture = capture
+        self.shm_path = shm_path
+        self.export_fps = export_fps
         self._tn = None
-        self._lock = threading.Lock()
-        self._framebuffer = bytearray(self.fb_size)
-        self._fb_hash = b"\x00"
+        self._lock = threading.Lock()       # telnet monitor
+        self._fb_lock = threading.Lock()    # _framebuffer / _generation
+        self._framebuffer = bytes(self.fb_size)
+        self._generation = 0
+        self._fb_cond = threading.Condition(self._fb_lock)
+        self._bmp_cache = None
         self._connected = False
         self._read_count = 0
+        self._last_debug = time.monotonic()
+        self._shm = None
+        self._shm_seq = -1
+        self._shm_version = 0
+        self._shm_gen = -1
 
     def connect(self) -> bool:
         """Connect to Renode telnet monitor."""
@@ -95,7 +508,7 @@ class RenodeFramebufferReader:
                 self._connected = True
                 log.info("Connected to Renode monitor at %s:%d",
                          self.host, self.port)
-                return True
+                return self._setup_capture()
             except (ConnectionRefusedError, OSError) as e:
                 if attempt < 29:
                     time.sleep(2)
@@ -119,39 +532,152 @@ class RenodeFramebufferReader:
             self._connected = False
             return ""
 
+    # ── Capture backend setup ────────────────────────────────────────
+
+    def _setup_capture(self) -> bool:
+        """Start the shared-memory export unless --capture telnet."""
+        if self.capture == "telnet":
+            log.info("Capture: telnet ReadBytes")
+            return True
+        if self._start_shm():
+            log.info("Capture: shared memory %s", self.shm_path)
+            return True
+        if self.capture == "shm":
+            log.error("Shared-memory capture unavailable (%s)", self.shm_path)
+            return False
+        log.warning("Shared-memory capture unavailable, using telnet")
+        self.capture = "telnet"
+        return True
+
+    def _start_shm(self) -> bool:
+        """Load fb_export.py into Renode and map the file it writes."""
+        with self._lock:
+            resp = self._send_command(f"include @{FB_EXPORT_SCRIPT}")
+            resp += self._send_command(
+                f'python "fb_export_start(self.Machine, {self.fb_addr}, '
+                f'{self.width}, {self.height}, \'{self.shm_path}\', '
+                f'{self.export_fps}, {self.scanout_reg})"')
+        if "error" in resp.lower():
+            log.warning("fb_export: %s", resp.strip()[:200])
+            return False
+
+        need = FB_EXPORT_DATA + self.fb_size
+        for _ in range(50):
+            try:
+                with open(self.shm_path, "rb") as f:
+                    if os.fstat(f.fileno()).st_size >= need:
+                        mm = mmap.mmap(f.fileno(), need,
+                                       access=mmap.ACCESS_READ)
+                        magic, ver, _, w, h = struct.unpack_from("<5I", mm, 0)
+                        if magic == FB_EXPORT_MAGIC:
+                            if (w, h) != (self.width, self.height):
+                                log.warning("fb_export is %dx%d, expected "
+                                            "%dx%d", w, h,
+                                            self.width, self.height)
+                                mm.close()
+                                return False
+                            self._shm = mm
+                            self._shm_version = ver
+                            return True
+                        mm.close()
+            except (FileNotFoundError, ValueError, OSError):
+                pass
+            time.sleep(0.1)
+        return False
+
+    # ── Frame capture ────────────────────────────────────────────────
+
+    def _read_debug_regs(self):
+        """Log the draw_engine debug registers (telnet, rate limited)."""
+        now = time.monotonic()
+        if now - self._last_debug < DEBUG_INTERVAL:
+            return
+        self._last_debug = now
+        with self._lock:
+            if not self._connected:
+                return
+            try:
+                # All registers in one monitor round trip; the "DBG" marker
+                # keeps the echoed command's addresses out of the match
+                addrs = ", ".join(f"0x{a:08X}" for a, _ in DEBUG_REGS)
+                resp = self._send_command(
+                    'python "b = self.Machine.SystemBus; '
+                    "print('DBG ' + ' '.join('0x%08X' % b.ReadDoubleWord(a) "
+                    f'for a in ({addrs})))"')
+                m = re.search(r"DBG((?: 0x[0-9A-Fa-f]{8})+)", resp)
+                vals = m.group(1).split() if m else []
+                vals += ["???"] * (len(DEBUG_REGS) - len(vals))
+                log.info("DBG: %s", " | ".join(
+                    f"{name}={val}" for (_, name), val in zip(DEBUG_REGS, vals)))
+            except Exception as e:
+                log.warning("Debug read error: %s", e)
+
+    def _publish(self, data: bytes) -> bool:
+        """Install a new frame if it differs from the current one."""
+        with self._fb_lock:
+            if data == self._framebuffer:
+                return False
+            self._framebuffer = data
+            self._generation += 1
+            self._fb_cond.notify_all()
+        self._read_count += 1
+        if self._read_count <= 3 or self._read_count % 100 == 0:
+            log.info("Framebuffer updated (#%d)", self._read_count)
+        return True
+
     def read_framebuffer(self) -> bool:
         """Read framebuffer from Renode. Returns True if changed."""
+        self._read_debug_regs()
+        if self._shm is not None:
+            return self._read_framebuffer_shm()
+        return self._read_framebuffer_telnet()
+
+    def _read_framebuffer_shm(self) -> bool:
+        """Seqlock read of the exported frame; no monitor traffic.
+
+        Version 2 exports carry a generation counter and the rows damaged
+        since the previous generation: an unchanged generation costs one
+        header read, the next one only the damaged rows.
+        """
+        mm = self._shm
+        stride = self.width * 4
+        for _ in range(4):
+            seq = struct.unpack_from("<I", mm, 8)[0]
+            if seq == self._shm_seq:
+                return False        # exporter has not published since
+            if seq & 1:
+                time.sleep(0.001)   # frame being written
+                continue
+            gen, xy, wh = struct.unpack_from("<3I", mm, FB_EXPORT_GEN)
+            if self._shm_version >= 2 and gen == self._shm_gen + 1:
+                y0, y1 = xy >> 16, (xy >> 16) + (wh >> 16)
+                cur = self.framebuffer
+                data = (cur[:y0 * stride] +
+                        mm[FB_EXPORT_DATA + y0 * stride:
+                           FB_EXPORT_DATA + y1 * stride] +
+                        cur[y1 * stride:])
+            else:
+                data = mm[FB_EXPORT_DATA:FB_EXPORT_DATA + self.fb_size]
+            if struct.unpack_from("<I", mm, 8)[0] == seq:
+                self._shm_seq, self._shm_gen = seq, gen
+                return self._publish(data)
+        return False
+
+    def _read_framebuffer_telnet(self) -> bool:
+        """One ReadBytes round trip through the monitor and a temp file."""
         with self._lock:
             if not self._connected:
                 return False
 
-            # --- Read debug registers every 50 reads ---
-            if self._read_count > 0 and self._read_count % 5 == 0:
-                try:
-                    results = []
-                    for addr, name in [
-                        (0x82001000, "state"), (0x82001004, "last_cmd"),
-                        (0x82001010, "cmd_cnt"), (0x8200100C, "backing1"),
-                        (0x82001014, "fb_addr"), (0x82001018, "wxh"),
-                    ]:
-                        resp = self._send_command(
-                            f"sysbus ReadDoubleWord 0x{addr:08X}"
-                        )
-                        # Renode response: "<echo>\r\n0x00000000\r\n(monitor)"
-                        # Find all hex values; the last one is the result
-                        # (the first is the address in the echoed command)
-                        matches = re.findall(r'(0x[0-9A-Fa-f]+)', resp)
-                        val = matches[-1] if matches else "???"
-                        results.append(f"{name}={val}")
-                    log.info("DBG: %s", " | ".join(results))
-                except Exception as e:
-                    log.warning("Debug read error: %s", e)
-
             tmp_path = "/tmp/renode_vnc_fb.raw"
+            addr = str(self.fb_addr)
+            if self.scanout_reg:
+                addr = (f"(self.Machine.SystemBus.ReadDoubleWord({self.scanout_reg})"
+                        f" or {self.fb_addr})")
             cmd = (
                 'python "from System.IO import File; '
                 f'data = self.Machine.SystemBus.ReadBytes('
-                f'long({self.fb_addr}), int({self.fb_size})); '
+                f'long({addr}), int({self.fb_size})); '
                 f'File.WriteAllBytes(\\"{tmp_path}\\", data)"'
             )
             resp = self._send_command(cmd)
@@ -167,29 +693,24 @@ class RenodeFramebufferReader:
                     data = f.read()
                 if len(data) != self.fb_size:
                     return False
-
-                new_hash = hashlib.md5(data).digest()
-                if new_hash == self._fb_hash:
-                    return False
-
-                self._fb_hash = new_hash
-                self._framebuffer = bytearray(data)
-                self._read_count += 1
-                if self._read_count <= 3 or self._read_count % 5 == 0:
-                    log.info("Framebuffer updated (#%d)", self._read_count)
-                return True
-
             except FileNotFoundError:
                 return False
             except Exception as e:
                 log.warning("FB read error: %s", e)
                 return False
+        return self._publish(data)
 
     @property
     def framebuffer(self) -> bytes:
         """Current framebuffer (BGRA in memory, little-endian ARGB)."""
-        with self._lock:
-            return bytes(self._framebuffer)
+        with self._fb_lock:
+            return self._framebuffer
+
+    @property
+    def frame(self):
+        """(generation, framebuffer); the generation bumps on every change."""
+        with self._fb_lock:
+            return self._generation, self._framebuffer
 
     def _make_bmp(self, pixel_data: bytearray) -> bytes:
         """Convert BGRX pixel data to 24-bit BMP. Shared helper."""
@@ -210,22 +731,24 @@ class RenodeFramebufferReader:
         struct.pack_into("<H", bmp, 28, 24)
         struct.pack_into("<I", bmp, 34, pixel_size)
 
-        # Fast conversion: skip every 4th byte (alpha) from BGRX
-        src = pixel_data
-        dst = 54
-        for i in range(0, w * h * 4, 4):
-            bmp[dst]     = src[i]
-            bmp[dst + 1] = src[i + 1]
-            bmp[dst + 2] = src[i + 2]
-            dst += 3
-
+        # BGRX → BGR: drop every 4th byte (alpha)
+        bmp[54:] = _bgrx_to_cpixel(pixel_data)
         return bytes(bmp)
 
     def framebuffer_as_bmp(self) -> bytes:
-        """Return framebuffer as a BMP image."""
-        with self._lock:
-            fb = bytearray(self._framebuffer)
-        return self._make_bmp(fb)
+        """Return framebuffer as a BMP image (built once per frame)."""
+        gen, fb = self.frame
+        cached = self._bmp_cache
+        if cached is None or cached[0] != gen:
+            cached = (gen, self._make_bmp(fb))
+            self._bmp_cache = cached
+        return cached[1]
+
+    def wait_frame(self, gen: int, timeout: float):
+        """Block until the generation moves past @gen; returns self.frame."""
+        with self._fb_cond:
+            self._fb_cond.wait_for(lambda: self._generation != gen, timeout)
+            return self._generation, self._framebuffer
 
     def uart_log_tail(self, max_lines: int = 80) -> str:
         """Read last N lines from UART log file."""
@@ -401,7 +924,8 @@ WEB_VIEWER_HTML = r"""<!DOCTYPE html>
 <div class="info">
   <span>640&times;480</span> XRGB8888 &nbsp;|&nbsp;
   Refresh: <span id="fps-display">2</span> fps &nbsp;|&nbsp;
-  Frame: <span id="frame-count">0</span>
+  Frame: <span id="frame-count">0</span> &nbsp;|&nbsp;
+  <span id="mode">polling</span>
 </div>
 
 <div class="main-row">
@@ -459,6 +983,8 @@ let frameCount = 0;
 let cmdHistory = [];
 let histIdx = -1;
 let autoScroll = true;
+let stream = null;
+let drawQueue = Promise.resolve();
 
 function setScale(s) {
   const sz = parseFloat(s);
@@ -474,7 +1000,7 @@ function setFps(f) {
   interval = 1000 / parseFloat(f);
   document.getElementById('fps-display').textContent = f;
   if (timer) clearInterval(timer);
-  timer = setInterval(fetchFrame, interval);
+  if (!stream) timer = setInterval(fetchFrame, interval);
 }
 
 async function loadBmp(url, ctx) {
@@ -498,6 +1024,53 @@ async function fetchFrame() {
   }
 }
 
+/*
+ * /stream (WebSocket): the server pushes one binary message per frame
+ * change — u16 tile count, then per tile u16 x, u16 y, u32 length and
+ * a PNG.  Polling /frame.bmp is the fallback when the socket is down.
+ */
+async function drawTiles(buf) {
+  const dv = new DataView(buf);
+  const n = dv.getUint16(0, true);
+  let off = 2;
+  const tiles = [];
+  for (let i = 0; i < n; i++) {
+    const x = dv.getUint16(off, true), y = dv.getUint16(off + 2, true);
+    const len = dv.getUint32(off + 4, true);
+    const png = new Blob([new Uint8Array(buf, off + 8, len)], {type: 'image/png'});
+    tiles.push([x, y, createImageBitmap(png)]);
+    off += 8 + len;
+  }
+  for (const [x, y, bmp] of tiles) ctxFb.drawImage(await bmp, x, y);
+  frameCount++;
+  document.getElementById('frame-count').textContent = frameCount;
+  statusEl.className = 'status ok';
+  statusEl.textContent = '\u25cf Streaming \u2014 frame #' + frameCount;
+}
+
+function startStream() {
+  if (!('WebSocket' in window)) return;
+  const proto = location.protocol === 'https:' ? 'wss://' : 'ws://';
+  const ws = new WebSocket(proto + location.host + '/stream');
+  ws.binaryType = 'arraybuffer';
+  ws.onopen = () => {
+    stream = ws;
+    if (timer) { clearInterval(timer); timer = null; }
+    document.getElementById('mode').textContent = 'streaming';
+  };
+  ws.onmessage = (ev) => {
+    drawQueue = drawQueue.then(() => drawTiles(ev.data)).catch(() => {});
+  };
+  ws.onclose = () => {
+    if (stream === ws) {
+      stream = null;
+      document.getElementById('mode').textContent = 'polling';
+      setFps(document.getElementById('fpsctl').value);
+    }
+    setTimeout(startStream, 3000);
+  };
+}
+
 let lastLogHash = '';
 async function fetchUartLog() {
   try {
@@ -545,7 +1118,7 @@ async function sendUartCmd() {
       }
       histIdx = cmdHistory.length;
       cmdInput.value = '';
-      setTimeout(() => { fetchFrame(); fetchUartLog(); }, 500);
+      setTimeout(() => { if (!stream) fetchFrame(); fetchUartLog(); }, 500);
     } else {
       sendStatus.className = 'uart-send-status err';
       sendStatus.textContent = '\u2716 ' + (result.error || 'Send failed');
@@ -582,15 +1155,127 @@ fetchFrame();
 fetchUartLog();
 timer = setInterval(fetchFrame, interval);
 logTimer = setInterval(fetchUartLog, 1500);
+startStream();
 </script>
 </body>
 </html>"""
 
 
+def _png(rgb: bytes, w: int, h: int) -> bytes:
+    """Minimal 8-bit RGB PNG (filter type 0 on every row)."""
+    def chunk(kind, data):
+        return (struct.pack("!I", len(data)) + kind + data +
+                struct.pack("!I", zlib.crc32(kind + data)))
+    row = w * 3
+    raw = b"".join(b"\x00" + rgb[r * row:(r + 1) * row] for r in range(h))
+    return (b"\x89PNG\r\n\x1a\n" +
+            chunk(b"IHDR", struct.pack("!IIBBBBB", w, h, 8, 2, 0, 0, 0)) +
+            chunk(b"IDAT", zlib.compress(raw, 6)) +
+            chunk(b"IEND", b""))
+
+
+class FrameStream:
+    """Frame deltas for /stream, encoded once and shared by every browser.
+
+    Each frame change becomes one message: u16 tile count, then per
+    TILE x TILE tile u16 x, u16 y, u32 length and a PNG (little-endian).
+    A client that is at the previous sequence number gets the delta;
+    anyone else (new or lagging) gets a full-frame keyframe, also built
+    once per sequence number.
+    """
+
+    def __init__(self, fb_reader: RenodeFramebufferReader):
+        self.fb = fb_reader
+        self.width = fb_reader.width
+        self.height = fb_reader.height
+        self.stride = self.width * 4
+        self._cond = threading.Condition()
+        self._clients = 0
+        self._gen = -1
+        self._frame = None
+        self._seq = 0
+        self._delta = None          # (base seq, message)
+        self._key = None            # (seq, message)
+        threading.Thread(target=self._run, daemon=True).start()
+
+    def _encode(self, fb, tiles) -> bytes:
+        out = [struct.pack("<H", len(tiles))]
+        for x, y, w, h in tiles:
+            png = _png(_bgrx_to_rgb(_rect_bytes(fb, self.stride, x, y, w, h)),
+                       w, h)
+            out.append(struct.pack("<HHI", x, y, len(png)) + png)
+        return b"".join(out)
+
+    def _run(self):
+        while True:
+            with self._cond:
+                if not self._clients:
+                    self._cond.wait_for(lambda: self._clients, 1.0)
+                    continue
+            gen, fb = self.fb.wait_frame(self._gen, 1.0)
+            if gen == self._gen:
+                continue
+            if self._frame is None:
+                msg = None
+            else:
+                msg = self._encode(fb, dirty_tiles(self._frame, fb, self.width,
+                                                   self.height, self.stride))
+            with self._cond:
+                self._delta = (self._seq, msg) if msg else None
+                self._seq += 1
+                self._gen, self._frame = gen, fb
+                self._cond.notify_all()
+
+    def _keyframe(self) -> bytes:
+        """Full frame for the current sequence number (call with _cond held)."""
+        if self._key is None or self._key[0] != self._seq:
+            if self._frame is None:
+                self._gen, self._frame = self.fb.frame
+            self._key = (self._seq, self._encode(
+                self._frame, [(0, 0, self.width, self.height)]))
+        return self._key[1]
+
+    def next(self, seq: int, timeout: float = 5.0):
+        """(seq, message) newer than @seq, or (seq, None) on timeout."""
+        with self._cond:
+            if seq == self._seq:
+                self._cond.wait_for(lambda: self._seq != seq, timeout)
+                if seq == self._seq:
+                    return seq, None
+            if self._delta is not None and self._delta[0] == seq:
+                return self._seq, self._delta[1]
+            return self._seq, self._keyframe()
+
+    def attach(self):
+        with self._cond:
+            self._clients += 1
+            self._cond.notify_all()
+
+    def detach(self):
+        with self._cond:
+            self._clients -= 1
+
+
+WS_GUID = b"258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+
+def _ws_frame(opcode: int, payload: bytes) -> bytes:
+    """Unmasked server-to-client WebSocket frame."""
+    n = len(payload)
+    if n < 126:
+        hdr = struct.pack("!BB", 0x80 | opcode, n)
+    elif n < 65536:
+        hdr = struct.pack("!BBH", 0x80 | opcode, 126, n)
+    else:
+        hdr = struct.pack("!BBQ", 0x80 | opcode, 127, n)
+    return hdr + payload
+
+
 class WebViewerHandler(http.server.BaseHTTPRequestHandler):
     """HTTP handler for the browser-based framebuffer viewer."""
 
     fb_reader = None
+    stream = None
 
     def log_message(self, format, *args):
         pass  # suppress default access log
@@ -604,6 +1289,9 @@ class WebViewerHandler(http.server.BaseHTTPRequestHandler):
             self.send_header("Cache-Control", "no-cache")
             self.end_headers()
             self.wfile.write(body)
+        elif (self.path.startswith("/stream") and
+              self.headers.get("Upgrade", "").lower() == "websocket"):
+            self._serve_stream()
         elif self.path.startswith("/frame.bmp"):
             bmp = self.fb_reader.framebuffer_as_bmp()
             self.send_response(200)
@@ -625,6 +1313,45 @@ class WebViewerHandler(http.server.BaseHTTPRequestHandler):
         else:
             self.send_error(404)
 
+    def _serve_stream(self):
+        """WebSocket push of FrameStream messages until the browser leaves."""
+        key = self.headers.get("Sec-WebSocket-Key", "").encode()
+        accept = base64.b64encode(hashlib.sha1(key + WS_GUID).digest())
+        self.wfile.write(b"HTTP/1.1 101 Switching Protocols\r\n"
+                         b"Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                         b"Sec-WebSocket-Accept: " + accept + b"\r\n\r\n")
+        self.wfile.flush()
+        self.close_connection = True
+
+        sock = self.connection
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        stream = self.stream
+        stream.attach()
+        seq = -1
+        try:
+            while True:
+                seq, msg = stream.next(seq)
+                # Idle: ping, which also notices a closed browser tab
+                frame = (_ws_frame(0x2, msg) if msg is not None
+                         else _ws_frame(0x9, b""))
+                sock.settimeout(30.0)
+                sock.sendall(frame)
+                # Drain (and ignore) anything the browser sent
+                sock.settimeout(0)
+                try:
+                    while True:
+                        b = sock.recv(4096)
+                        if not b:
+                            return
+                        if b[0] & 0x0F == 0x8:      # close
+                            return
+                except (BlockingIOError, socket.timeout):
+                    pass
+        except (ConnectionError, BrokenPipeError, OSError):
+            pass
+        finally:
+            stream.detach()
+
     def do_POST(self):
         if self.path == "/uart.send":
             try:
@@ -807,8 +1534,11 @@ class VNCServer:
     # ── RFB Serve Loop ───────────────────────────────────────────────
 
     def _rfb_serve(self, sock: socket.socket, addr):
-        """Send framebuffer updates to VNC client."""
-        last_hash = b""
+        """Answer FramebufferUpdateRequests with the tiles that changed."""
+        enc = RFBEncoder(self.width, self.height)
+        model = None        # what the client currently shows
+        last_gen = -1
+        pending = None      # None, or True / False = incremental request
         frames = 0
 
         while self._running:
@@ -819,42 +1549,60 @@ class VNCServer:
                     b = sock.recv(1)
                     if not b:
                         break
-                    self._consume_client_msg(sock, b[0])
+                    req = self._consume_client_msg(sock, b[0], enc, addr)
+                    if req is not None:
+                        pending = req if pending is None else pending and req
+                    continue        # drain queued messages first
                 except socket.timeout:
                     pass
 
-                # Send frame if changed
-                fb = self.fb.framebuffer
-                h = hashlib.md5(fb).digest()
-                if h != last_hash:
-                    sock.settimeout(30.0)
-                    hdr = struct.pack("!BxH", MSG_FB_UPDATE, 1)
-                    rect = struct.pack("!HHHHi",
-                                       0, 0, self.width, self.height, ENC_RAW)
-                    sock.sendall(hdr + rect + fb)
-                    last_hash = h
-                    frames += 1
-                    if frames <= 2:
-                        log.info("[%s] frame #%d sent", addr[0], frames)
-
-                time.sleep(1.0 / self.fps)
+                if pending is None:
+                    continue
+                gen, fb = self.fb.frame
+                if pending and gen == last_gen:
+                    time.sleep(1.0 / self.fps)
+                    continue
+
+                msg = enc.update(fb, model, full=not pending)
+                last_gen = gen
+                if msg is None:
+                    continue
+                sock.settimeout(30.0)
+                sock.sendall(msg)
+                model = fb
+                pending = None
+                frames += 1
+                if frames <= 2:
+                    log.info("[%s] update #%d sent (%d bytes)",
+                             addr[0], frames, len(msg))
 
             except socket.timeout:
                 continue
             except (ConnectionResetError, BrokenPipeError):
                 break
 
-    def _consume_client_msg(self, sock: socket.socket, msg_type: int):
-        """Read and discard a client message."""
+    def _consume_client_msg(self, sock: socket.socket, msg_type: int,
+                            enc: RFBEncoder, addr):
+        """Read one client message.
+
+        Returns the incremental flag of a FramebufferUpdateRequest, or
+        None for any other message.
+        """
         sock.settimeout(5.0)
         if msg_type == MSG_SET_PIXEL_FORMAT:
-            _recv_exact(sock, 19)
+            fmt = _recv_exact(sock, 19)[3:]
+            if fmt != self._pixel_format:
+                log.warning("[%s] client pixel format ignored", addr[0])
         elif msg_type == MSG_SET_ENCODINGS:
             d = _recv_exact(sock, 3)
             n = struct.unpack("!xH", d)[0]
-            _recv_exact(sock, n * 4)
+            encodings = list(struct.unpack(f"!{n}i", _recv_exact(sock, n * 4)))
+            enc.set_encodings(encodings)
+            log.info("[%s] encoding %d%s%s", addr[0], enc.encoding,
+                     " +CopyRect" if enc.copyrect else "",
+                     f" +JPEG q{enc.jpeg_quality}" if enc.jpeg_quality else "")
         elif msg_type == MSG_FB_UPDATE_REQUEST:
-            _recv_exact(sock, 9)
+            return bool(_recv_exact(sock, 9)[0])
         elif msg_type == MSG_KEY_EVENT:
             _recv_exact(sock, 7)
         elif msg_type == MSG_POINTER_EVENT:
@@ -866,6 +1614,7 @@ class VNCServer:
                 _recv_exact(sock, length)
         else:
             log.debug("Unknown msg type: %d", msg_type)
+        return None
 
 
 # ─── Main ─────────────────────────────────────────────────────────────
@@ -884,8 +1633,17 @@ def main():
     parser.add_argument("--height", type=int, default=480)
     parser.add_argument("--fb-addr", type=lambda x: int(x, 0),
                         default=0x43E00000)
+    parser.add_argument("--scanout-reg", type=lambda x: int(x, 0), default=0,
+                        help="Register holding the scanout base to follow "
+                             "instead of --fb-addr when non-zero "
+                             "(TLM model: 0x82001014)")
     parser.add_argument("--uart-log", default="/tmp/uart_output_interactive.txt",
                         help="Path to UART log file (default: /tmp/uart_output_interactive.txt)")
+    parser.add_argument("--capture", choices=("auto", "shm", "telnet"),
+                        default="auto",
+                        help="Frame capture backend (default: auto)")
+    parser.add_argument("--shm-path", default="/dev/shm/renode_fb",
+                        help="Shared-memory export file (default: /dev/shm/renode_fb)")
     parser.add_argument("-v", "--verbose", action="store_true")
     args = parser.parse_args()
 
@@ -897,7 +1655,10 @@ def main():
     fb = RenodeFramebufferReader(
         args.renode_host, args.renode_port,
         args.fb_addr, args.width, args.height,
-        uart_log_path=args.uart_log)
+        uart_log_path=args.uart_log,
+        capture=args.capture, shm_path=args.shm_path,
+        export_fps=max(args.fps, 1.0),
+        scanout_reg=args.scanout_reg)
 
     log.info("Connecting to Renode at %s:%d ...", args.renode_host, args.renode_port)
     if not fb.connect():
@@ -908,6 +1669,7 @@ def main():
 
     # HTTP viewer
     WebViewerHandler.fb_reader = fb
+    WebViewerHandler.stream = FrameStream(fb)
     http_srv = ThreadedHTTPServer(("0.0.0.0", args.web_port), WebViewerHandler)
     threading.Thread(target=http_srv.serve_forever, daemon=True).start()
     log.info("HTTP viewer: http://0.0.0.0:%d", args.web_port)